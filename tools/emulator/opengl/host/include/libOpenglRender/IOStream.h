@@ -21,17 +21,34 @@
 
 #include "ErrorLog.h"
 
+// caller owned data smaller than this is copied into the stream buffer
+#define IOSTREAM_ATTACH_THRESHOLD   (16 * 1024)
+// maximum number of attached regions pending in a single flush
+#define IOSTREAM_MAX_ATTACHMENTS    16
+
 class IOStream {
 public:
+    struct Segment {
+        const void *base;
+        size_t len;
+    };
 
     IOStream(size_t bufSize) {
         m_buf = NULL;
         m_bufsize = bufSize;
         m_free = 0;
+        m_nAttached = 0;
+        m_nReserved = 0;
+        m_commits = 0;
+        m_flushed = 0;
+        m_attachedLen = 0;
     }
 
     virtual void *allocBuffer(size_t minSize) = 0;
     virtual int commitBuffer(size_t size) = 0;
+    // commitBufferv - gather write of the buffer regions and attached
+    // data, in order. Used by flush() when data has been attached.
+    virtual int commitBufferv(const Segment *segments, int count) = 0;
     virtual const unsigned char *readFully( void *buf, size_t len) = 0;
     virtual const unsigned char *read( void *buf, size_t *inout_len) = 0;
 
@@ -67,13 +84,79 @@ public:
         return ptr;
     }
 
+    //
+    // unalloc - gives back the last 'len' bytes returned by alloc(),
+    // which must not have been flushed nor had data attached yet.
+    //
+    void unalloc(size_t len) {
+        m_free += len;
+    }
+
+    //
+    // reserveAttach - returns true if 'len' bytes of caller owned data
+    // should be sent by reference rather than copied into the buffer
+    // returned by alloc(). In that case the caller must not include the
+    // data in the alloc() size, must call attach() for it exactly once,
+    // and must flush() before the data is released.
+    //
+    bool reserveAttach(size_t len) {
+        if (len < IOSTREAM_ATTACH_THRESHOLD ||
+            m_nAttached + m_nReserved >= IOSTREAM_MAX_ATTACHMENTS) {
+            return false;
+        }
+        m_nReserved++;
+        return true;
+    }
+
+    //
+    // attach - queues 'len' bytes at 'data' to be sent in place at 'at',
+    // the current write location in the buffer returned by alloc().
+    //
+    void attach(unsigned char *at, const void *data, size_t len) {
+        Attachment *a = &m_attached[m_nAttached++];
+        a->offset = at - m_buf;
+        a->data = data;
+        a->len = len;
+        m_attachedLen += len;
+        m_nReserved--;
+    }
+
+    //
+    // tail - the current write location in the buffer returned by
+    // alloc(), NULL if there is none, and the number of bytes that can
+    // still be allocated there without flushing. Together with commits(),
+    // the number of flushes that sent data, they let an encoder tell that
+    // the packet it wrote last is still unsent and can be extended.
+    //
+    unsigned char *tail() const { return m_buf ? m_buf + (m_bufsize - m_free) : NULL; }
+    size_t tailRoom() const { return m_buf ? m_free : 0; }
+    unsigned int commits() const { return m_commits; }
+
+    //
+    // position - the number of bytes written to the stream so far, the
+    // stream position of tail(), modulo 2^32.
+    //
+    unsigned int position() const {
+        return m_flushed + (unsigned int)(m_buf ? m_bufsize - m_free : 0) + m_attachedLen;
+    }
+
     int flush() {
 
-        if (!m_buf || m_free == m_bufsize) return 0;
+        if (!m_buf || (m_free == m_bufsize && m_nAttached == 0)) return 0;
 
-        int stat = commitBuffer(m_bufsize - m_free);
+        m_commits++;
+        m_flushed += (unsigned int)(m_bufsize - m_free) + m_attachedLen;
+
+        int stat;
+        if (m_nAttached > 0) {
+            stat = commitAttached();
+        } else {
+            stat = commitBuffer(m_bufsize - m_free);
+        }
         m_buf = NULL;
         m_free = 0;
+        m_nAttached = 0;
+        m_attachedLen = 0;
         return stat;
     }
 
@@ -83,9 +166,49 @@ public:
     }
 
 private:
+    int commitAttached() {
+        Segment segments[2 * IOSTREAM_MAX_ATTACHMENTS + 1];
+        int count = 0;
+        size_t used = m_bufsize - m_free;
+        size_t prev = 0;
+
+        for (int i = 0; i < m_nAttached; i++) {
+            const Attachment &a = m_attached[i];
+            if (a.offset > prev) {
+                segments[count].base = m_buf + prev;
+                segments[count].len = a.offset - prev;
+                count++;
+            }
+            segments[count].base = a.data;
+            segments[count].len = a.len;
+            count++;
+            prev = a.offset;
+        }
+        if (used > prev) {
+            segments[count].base = m_buf + prev;
+            segments[count].len = used - prev;
+            count++;
+        }
+
+        return commitBufferv(segments, count);
+    }
+
+private:
+    struct Attachment {
+        size_t offset;
+        const void *data;
+        size_t len;
+    };
+
     unsigned char *m_buf;
     size_t m_bufsize;
     size_t m_free;
+    Attachment m_attached[IOSTREAM_MAX_ATTACHMENTS];
+    int m_nAttached;
+    int m_nReserved;
+    unsigned int m_commits;
+    unsigned int m_flushed;     // bytes written by the previous flushes
+    unsigned int m_attachedLen; // bytes of m_attached
 };
 
 #endif
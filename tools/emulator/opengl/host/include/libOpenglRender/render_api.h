@@ -35,12 +35,25 @@ typedef Window   FBNativeWindowType;
 #warning "Unsupported platform"
 #endif
 
+//
+// Transport used between the emulator and the renderer.
+//     RENDER_STREAM_TCP - a localhost TCP socket (default).
+//     RENDER_STREAM_SHM - shared memory rings, both ends must run on
+//                         the same host (linux only).
+//
+typedef enum {
+    RENDER_STREAM_TCP = 0,
+    RENDER_STREAM_SHM = 1
+} RenderStreamType;
+
 
 //
 // initOpenGLRenderer - initialize the OpenGL renderer process.
 //     window is the native window to be used as the framebuffer.
 //     x,y,width,height are the dimensions of the rendering subwindow.
 //     portNum is the tcp port number the renderer is listening to.
+//     streamType selects the transport used by createRenderThread,
+//     portNum also identifies the channel for shared memory streams.
 //
 // returns true if renderer has been starter successfully;
 //
@@ -49,7 +62,8 @@ typedef Window   FBNativeWindowType;
 //
 bool initOpenGLRenderer(FBNativeWindowType window,
                         int x, int y, int width, int height,
-                        int portNum);
+                        int portNum,
+                        RenderStreamType streamType = RENDER_STREAM_TCP);
 
 //
 // stopOpenGLRenderer - stops the OpenGL renderer process.
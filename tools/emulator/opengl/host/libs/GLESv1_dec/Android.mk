@@ -41,5 +41,9 @@ $(GEN) : $(EMUGEN) \
         $(emulatorOpengl)/system/GLESv1_enc/gl.types
 	$(transform-generated-source)
 
+ifneq (,$(BUILD_EMULATOR_OPENGL_TRACE))
+LOCAL_CFLAGS += -DCODEC_TRACE
+endif
+
 LOCAL_GENERATED_SOURCES += $(GEN)
 include $(BUILD_HOST_SHARED_LIBRARY)
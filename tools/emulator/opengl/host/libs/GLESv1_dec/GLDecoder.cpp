@@ -14,6 +14,7 @@
 * limitations under the License.
 */
 #include "GLDecoder.h"
+#include "ProtocolUtils.h"
 #include <string.h>
 #include <dlfcn.h>
 #include <stdio.h>
@@ -25,6 +26,8 @@
 GLDecoder::GLDecoder()
 {
     m_contextData = NULL;
+    m_pinner = NULL;
+    m_glDrawArrays = NULL;
     m_glesDso = NULL;
 }
 
@@ -72,8 +75,12 @@ int GLDecoder::initGL(get_proc_func_t getProcFunc, void *getProcFuncData)
     set_glWeightPointerData(s_glWeightPointerData);
     set_glMatrixIndexPointerData(s_glMatrixIndexPointerData);
 
+    // glDrawArrays is a custom decoder only to release the pinned
+    // data after the draw, it was looked up as the GL entry point
+    m_glDrawArrays = (glDrawArrays_proc_t)set_glDrawArrays(s_glDrawArrays);
     set_glDrawElementsOffset(s_glDrawElementsOffset);
     set_glDrawElementsData(s_glDrawElementsData);
+    set_glInterleavedPointerData(s_glInterleavedPointerData);
 
     return 0;
 }
@@ -124,7 +131,7 @@ void GLDecoder::s_glMatrixIndexPointerOffset(void * self, GLint size, GLenum typ
 
 #define STORE_POINTER_DATA_OR_ABORT(location)    \
     if (ctx->m_contextData != NULL) {   \
-        ctx->m_contextData->storePointerData((location), data, datalen); \
+        ctx->m_contextData->storePointerData((location), data, datalen, ctx->m_pinner); \
     } else { \
         return; \
     }
@@ -194,16 +201,37 @@ void GLDecoder::s_glMatrixIndexPointerData(void * self, GLint size, GLenum type,
     ctx->glMatrixIndexPointerOES(size, type, 0, ctx->m_contextData->pointerData(GLDecoderContextData::MATRIXINDEX_LOCATION));
 }
 
+//
+// The draws release the pointer data that was pinned for them; the
+// encoders send the client arrays again before every draw.
+//
+void GLDecoder::s_glDrawArrays(void *self, GLenum mode, GLint first, GLsizei count)
+{
+    GLDecoder *ctx = (GLDecoder *)self;
+    if (ctx->m_glDrawArrays != NULL) {
+        ctx->m_glDrawArrays(mode, first, count);
+    }
+    if (ctx->m_pinner != NULL) {
+        ctx->m_pinner->unpinAll();
+    }
+}
+
 void GLDecoder::s_glDrawElementsOffset(void *self, GLenum mode, GLsizei count, GLenum type, GLuint offset)
 {
     GLDecoder *ctx = (GLDecoder *)self;
     ctx->glDrawElements(mode, count, type, (void *)offset);
+    if (ctx->m_pinner != NULL) {
+        ctx->m_pinner->unpinAll();
+    }
 }
 
 void GLDecoder::s_glDrawElementsData(void *self, GLenum mode, GLsizei count, GLenum type, void * data, GLuint datalen)
 {
     GLDecoder *ctx = (GLDecoder *)self;
     ctx->glDrawElements(mode, count, type, data);
+    if (ctx->m_pinner != NULL) {
+        ctx->m_pinner->unpinAll();
+    }
 }
 
 void GLDecoder::s_glGetCompressedTextureFormats(void *self, GLint count, GLint *data)
@@ -229,3 +257,71 @@ void *GLDecoder::s_getProc(const char *name, void *userData)
     }
     return func;
 }
+
+//
+// The interleaved block is staged once, in the buffer of the first
+// array, and every array listed in 'attribs' points into it.
+//
+void GLDecoder::s_glInterleavedPointerData(void *self, GLuint count, GLuint *attribs, GLuint attribslen, GLsizei stride, void *data, GLuint datalen)
+{
+    GLDecoder *ctx = (GLDecoder *)self;
+    // the records must all be in the packet
+    if (ctx->m_contextData == NULL || count == 0 ||
+        count > attribslen / (CODEC_INTERLEAVED_FIELDS * 4)) {
+        return;
+    }
+
+    const unsigned char *rec = (const unsigned char *)attribs;
+    GLuint lead = Unpack<GLuint>(rec + CODEC_INTERLEAVED_LOCATION * 4);
+    if (lead >= GLDecoderContextData::LAST_LOCATION ||
+        lead >= ctx->m_contextData->nLocations()) {
+        return;
+    }
+    ctx->m_contextData->storePointerData(lead, data, datalen, ctx->m_pinner);
+    unsigned char *staged = (unsigned char *)ctx->m_contextData->pointerData(lead);
+
+    for (GLuint i = 0; i < count; i++, rec += CODEC_INTERLEAVED_FIELDS * 4) {
+        GLuint loc = Unpack<GLuint>(rec + CODEC_INTERLEAVED_LOCATION * 4);
+        GLint size = Unpack<GLint>(rec + CODEC_INTERLEAVED_SIZE * 4);
+        GLenum type = Unpack<GLenum>(rec + CODEC_INTERLEAVED_TYPE * 4);
+        GLuint offset = Unpack<GLuint>(rec + CODEC_INTERLEAVED_OFFSET * 4);
+        if (loc >= GLDecoderContextData::LAST_LOCATION || offset >= datalen) {
+            continue;
+        }
+        void *ptr = staged + offset;
+
+        switch(loc) {
+        case GLDecoderContextData::VERTEX_LOCATION:
+            ctx->glVertexPointer(size, type, stride, ptr);
+            break;
+        case GLDecoderContextData::NORMAL_LOCATION:
+            ctx->glNormalPointer(type, stride, ptr);
+            break;
+        case GLDecoderContextData::COLOR_LOCATION:
+            ctx->glColorPointer(size, type, stride, ptr);
+            break;
+        case GLDecoderContextData::POINTSIZE_LOCATION:
+            ctx->glPointSizePointerOES(type, stride, ptr);
+            break;
+        case GLDecoderContextData::TEXCOORD0_LOCATION:
+        case GLDecoderContextData::TEXCOORD1_LOCATION:
+        case GLDecoderContextData::TEXCOORD2_LOCATION:
+        case GLDecoderContextData::TEXCOORD3_LOCATION:
+        case GLDecoderContextData::TEXCOORD4_LOCATION:
+        case GLDecoderContextData::TEXCOORD5_LOCATION:
+        case GLDecoderContextData::TEXCOORD6_LOCATION:
+        case GLDecoderContextData::TEXCOORD7_LOCATION:
+            // the encoder selects the client active texture again before
+            // it sends anything else for a texture unit
+            ctx->glClientActiveTexture(GL_TEXTURE0 + loc - GLDecoderContextData::TEXCOORD0_LOCATION);
+            ctx->glTexCoordPointer(size, type, stride, ptr);
+            break;
+        case GLDecoderContextData::WEIGHT_LOCATION:
+            ctx->glWeightPointerOES(size, type, stride, ptr);
+            break;
+        case GLDecoderContextData::MATRIXINDEX_LOCATION:
+            ctx->glMatrixIndexPointerOES(size, type, stride, ptr);
+            break;
+        }
+    }
+}
@@ -32,8 +32,13 @@ public:
     ~GLDecoder();
     int initGL(get_proc_func_t getProcFunc = NULL, void *getProcFuncData = NULL);
     void setContextData(GLDecoderContextData *contextData) { m_contextData = contextData; }
+    // when set, client arrays data is used where it was received, see
+    // DataPinner.h
+    void setDataPinner(DataPinner *pinner) { m_pinner = pinner; }
 
 private:
+    typedef void (*glDrawArrays_proc_t)(GLenum mode, GLint first, GLsizei count);
+
     static void s_glGetCompressedTextureFormats(void * self, GLint cont, GLint *data);
     static void s_glVertexPointerData(void *self, GLint size, GLenum type, GLsizei stride, void *data, GLuint datalen);
     static void s_glVertexPointerOffset(void *self, GLint size, GLenum type, GLsizei stride, GLuint offset);
@@ -50,6 +55,7 @@ private:
     static void s_glPointSizePointerData(void *self, GLenum type, GLsizei stride, void *data, GLuint datalen);
     static void s_glPointSizePointerOffset(void *self, GLenum type, GLsizei stride, GLuint offset);
 
+    static void s_glDrawArrays(void *self, GLenum mode, GLint first, GLsizei count);
     static void s_glDrawElementsOffset(void *self, GLenum mode, GLsizei count, GLenum type, GLuint offset);
     static void s_glDrawElementsData(void *self, GLenum mode, GLsizei count, GLenum type, void * data, GLuint datalen);
 
@@ -59,9 +65,13 @@ private:
     static void s_glMatrixIndexPointerData(void * self, GLint size, GLenum type, GLsizei stride, void * data, GLuint datalen);
     static void s_glMatrixIndexPointerOffset(void * self, GLint size, GLenum type, GLsizei stride, GLuint offset);
 
+    static void s_glInterleavedPointerData(void *self, GLuint count, GLuint *attribs, GLuint attribslen, GLsizei stride, void *data, GLuint datalen);
+
     static void * s_getProc(const char *name, void *userData);
 
     GLDecoderContextData *m_contextData;
+    DataPinner *m_pinner;
+    glDrawArrays_proc_t m_glDrawArrays;
     void *m_glesDso;
 };
 
@@ -42,6 +42,10 @@ $(GEN) : $(EMUGEN) \
         $(emulatorOpengl)/system/GLESv2_enc/gl2.types
 	$(transform-generated-source)
 
+ifneq (,$(BUILD_EMULATOR_OPENGL_TRACE))
+LOCAL_CFLAGS += -DCODEC_TRACE
+endif
+
 LOCAL_GENERATED_SOURCES += $(GEN)
 include $(BUILD_HOST_SHARED_LIBRARY)
 
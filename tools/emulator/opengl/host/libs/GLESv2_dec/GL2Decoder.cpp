@@ -1,12 +1,16 @@
 #include "GL2Decoder.h"
+#include "ProtocolUtils.h"
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <string.h>
 
 
 GL2Decoder::GL2Decoder()
 {
     m_contextData = NULL;
+    m_pinner = NULL;
+    m_glDrawArrays = NULL;
     m_GL2library = NULL;
 }
 
@@ -55,9 +59,14 @@ int GL2Decoder::initGL(get_proc_func_t getProcFunc, void *getProcFuncData)
     set_glVertexAttribPointerData(s_glVertexAttribPointerData);
     set_glVertexAttribPointerOffset(s_glVertexAttribPointerOffset);
 
+    // glDrawArrays is a custom decoder only to release the pinned
+    // data after the draw, it was looked up as the GL entry point
+    m_glDrawArrays = (glDrawArrays_proc_t)set_glDrawArrays(s_glDrawArrays);
     set_glDrawElementsOffset(s_glDrawElementsOffset);
     set_glDrawElementsData(s_glDrawElementsData);
     set_glShaderString(s_glShaderString);
+    set_glInterleavedPointerData(s_glInterleavedPointerData);
+    set_glGetProgramInfoBlock(s_glGetProgramInfoBlock);
     return 0;
 
 }
@@ -80,13 +89,48 @@ void GL2Decoder::s_glVertexAttribPointerData(void *self, GLuint indx, GLint size
 {
     GL2Decoder *ctx = (GL2Decoder *) self;
     if (ctx->m_contextData != NULL) {
-        ctx->m_contextData->storePointerData(indx, data, datalen);
+        ctx->m_contextData->storePointerData(indx, data, datalen, ctx->m_pinner);
         // note - the stride of the data is always zero when it comes out of the codec.
         // See gl2.attrib for the packing function call.
         ctx->glVertexAttribPointer(indx, size, type, normalized, 0, ctx->m_contextData->pointerData(indx));
     }
 }
 
+//
+// The interleaved block is staged once, in the buffer of the first
+// attribute, and every attribute listed in 'attribs' points into it.
+//
+void GL2Decoder::s_glInterleavedPointerData(void *self, GLuint count, GLuint *attribs, GLuint attribslen, GLsizei stride, void *data, GLuint datalen)
+{
+    GL2Decoder *ctx = (GL2Decoder *) self;
+    // the records must all be in the packet
+    if (ctx->m_contextData == NULL || count == 0 ||
+        count > attribslen / (CODEC_INTERLEAVED_FIELDS * 4)) {
+        return;
+    }
+
+    const unsigned char *rec = (const unsigned char *)attribs;
+    GLuint lead = Unpack<GLuint>(rec + CODEC_INTERLEAVED_LOCATION * 4);
+    if (lead >= ctx->m_contextData->nLocations()) {
+        return;
+    }
+    ctx->m_contextData->storePointerData(lead, data, datalen, ctx->m_pinner);
+    unsigned char *staged = (unsigned char *)ctx->m_contextData->pointerData(lead);
+
+    for (GLuint i = 0; i < count; i++, rec += CODEC_INTERLEAVED_FIELDS * 4) {
+        GLuint indx = Unpack<GLuint>(rec + CODEC_INTERLEAVED_LOCATION * 4);
+        GLuint offset = Unpack<GLuint>(rec + CODEC_INTERLEAVED_OFFSET * 4);
+        if (indx >= ctx->m_contextData->nLocations() || offset >= datalen) {
+            continue;
+        }
+        ctx->glVertexAttribPointer(indx,
+                                   Unpack<GLint>(rec + CODEC_INTERLEAVED_SIZE * 4),
+                                   Unpack<GLenum>(rec + CODEC_INTERLEAVED_TYPE * 4),
+                                   Unpack<GLuint>(rec + CODEC_INTERLEAVED_NORMALIZED * 4) ? GL_TRUE : GL_FALSE,
+                                   stride, staged + offset);
+    }
+}
+
 void GL2Decoder::s_glVertexAttribPointerOffset(void *self, GLuint indx, GLint size, GLenum type,
                                                GLboolean normalized, GLsizei stride,  GLuint data)
 {
@@ -95,17 +139,37 @@ void GL2Decoder::s_glVertexAttribPointerOffset(void *self, GLuint indx, GLint si
 }
 
 
-void GL2Decoder::s_glDrawElementsData(void *self, GLenum mode, GLsizei count, GLenum type, void * data, GLuint datalen)
+//
+// The draws release the pointer data that was pinned for them; the
+// encoder sends the client arrays again before every draw.
+//
+void GL2Decoder::s_glDrawArrays(void *self, GLenum mode, GLint first, GLsizei count)
 {
     GL2Decoder *ctx = (GL2Decoder *)self;
-    ctx->glDrawElements(mode, count, type, data);
+    if (ctx->m_glDrawArrays != NULL) {
+        ctx->m_glDrawArrays(mode, first, count);
+    }
+    if (ctx->m_pinner != NULL) {
+        ctx->m_pinner->unpinAll();
+    }
 }
 
-
 void GL2Decoder::s_glDrawElementsOffset(void *self, GLenum mode, GLsizei count, GLenum type, GLuint offset)
 {
     GL2Decoder *ctx = (GL2Decoder *)self;
     ctx->glDrawElements(mode, count, type, (void *)offset);
+    if (ctx->m_pinner != NULL) {
+        ctx->m_pinner->unpinAll();
+    }
+}
+
+void GL2Decoder::s_glDrawElementsData(void *self, GLenum mode, GLsizei count, GLenum type, void * data, GLuint datalen)
+{
+    GL2Decoder *ctx = (GL2Decoder *)self;
+    ctx->glDrawElements(mode, count, type, data);
+    if (ctx->m_pinner != NULL) {
+        ctx->m_pinner->unpinAll();
+    }
 }
 
 void GL2Decoder::s_glShaderString(void *self, GLuint shader, GLstr string, GLsizei len)
@@ -113,3 +177,72 @@ void GL2Decoder::s_glShaderString(void *self, GLuint shader, GLstr string, GLsiz
     GL2Decoder *ctx = (GL2Decoder *)self;
     ctx->glShaderSource(shader, 1, &string, NULL);
 }
+
+//
+// Fills 'data' with the link status and the active attributes and
+// uniforms of 'program', see codec_defs.h for the layout. Returns the
+// size of the whole block; nothing past 'bufsize' is written, the guest
+// asks again with a larger buffer if the block did not fit.
+//
+GLsizei GL2Decoder::s_glGetProgramInfoBlock(void *self, GLuint program, GLsizei bufsize, void *data)
+{
+    GL2Decoder *ctx = (GL2Decoder *)self;
+    unsigned char *out = (unsigned char *)data;
+    if (bufsize < 0) {
+        bufsize = 0;
+    }
+
+    GLint linked = GL_FALSE;
+    GLint nAttribs = 0, nUniforms = 0;
+    GLint maxLength = 0, maxUniformLength = 0;
+    ctx->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked) {
+        ctx->glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &nAttribs);
+        ctx->glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &nUniforms);
+        ctx->glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+        ctx->glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformLength);
+        if (maxUniformLength > maxLength) {
+            maxLength = maxUniformLength;
+        }
+    }
+
+    GLsizei size = CODEC_PROGRAM_HEADER_FIELDS * 4;
+    if (size <= bufsize) {
+        Pack<GLint>(out + CODEC_PROGRAM_LINK_STATUS * 4, linked);
+        Pack<GLint>(out + CODEC_PROGRAM_NUM_ATTRIBS * 4, nAttribs);
+        Pack<GLint>(out + CODEC_PROGRAM_NUM_UNIFORMS * 4, nUniforms);
+    }
+
+    char *name = (char *)malloc(maxLength + 1);
+    if (name == NULL) {
+        return size;
+    }
+    for (GLint i = 0; i < nAttribs + nUniforms; i++) {
+        GLsizei length = 0;
+        GLint varSize = 0;
+        GLenum type = 0;
+        GLint location;
+        name[0] = '\0';
+        if (i < nAttribs) {
+            ctx->glGetActiveAttrib(program, i, maxLength + 1, &length, &varSize, &type, name);
+            location = ctx->glGetAttribLocation(program, name);
+        } else {
+            ctx->glGetActiveUniform(program, i - nAttribs, maxLength + 1, &length, &varSize, &type, name);
+            location = ctx->glGetUniformLocation(program, name);
+        }
+
+        GLsizei recordSize = CODEC_PROGRAM_VAR_FIELDS * 4 + ((length + 3) & ~3);
+        if (size + recordSize <= bufsize) {
+            unsigned char *rec = out + size;
+            Pack<GLint>(rec + CODEC_PROGRAM_VAR_LOCATION * 4, location);
+            Pack<GLint>(rec + CODEC_PROGRAM_VAR_SIZE * 4, varSize);
+            Pack<GLenum>(rec + CODEC_PROGRAM_VAR_TYPE * 4, type);
+            Pack<GLint>(rec + CODEC_PROGRAM_VAR_NAME_LENGTH * 4, length);
+            memset(rec + CODEC_PROGRAM_VAR_FIELDS * 4, 0, recordSize - CODEC_PROGRAM_VAR_FIELDS * 4);
+            memcpy(rec + CODEC_PROGRAM_VAR_FIELDS * 4, name, length);
+        }
+        size += recordSize;
+    }
+    free(name);
+    return size;
+}
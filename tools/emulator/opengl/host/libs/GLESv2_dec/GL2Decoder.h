@@ -17,8 +17,15 @@ public:
     ~GL2Decoder();
     int initGL(get_proc_func_t getProcFunc = NULL, void *getProcFuncData = NULL);
     void setContextData(GLDecoderContextData *contextData) { m_contextData = contextData; }
+    // when set, client arrays data is used where it was received, see
+    // DataPinner.h
+    void setDataPinner(DataPinner *pinner) { m_pinner = pinner; }
 private:
+    typedef void (*glDrawArrays_proc_t)(GLenum mode, GLint first, GLsizei count);
+
     GLDecoderContextData *m_contextData;
+    DataPinner *m_pinner;
+    glDrawArrays_proc_t m_glDrawArrays;
     osUtils::dynLibrary * m_GL2library;
 
     static void *s_getProc(const char *name, void *userData);
@@ -28,8 +35,11 @@ private:
     static void s_glVertexAttribPointerOffset(void *self, GLuint indx, GLint size, GLenum type,
                                         GLboolean normalized, GLsizei stride,  GLuint offset);
 
+    static void s_glDrawArrays(void *self, GLenum mode, GLint first, GLsizei count);
     static void s_glDrawElementsOffset(void *self, GLenum mode, GLsizei count, GLenum type, GLuint offset);
     static void s_glDrawElementsData(void *self, GLenum mode, GLsizei count, GLenum type, void * data, GLuint datalen);
     static void s_glShaderString(void *self, GLuint shader, GLstr string, GLsizei len);
+    static void s_glInterleavedPointerData(void *self, GLuint count, GLuint *attribs, GLuint attribslen, GLsizei stride, void *data, GLuint datalen);
+    static GLsizei s_glGetProgramInfoBlock(void *self, GLuint program, GLsizei bufsize, void *data);
 };
 #endif
@@ -12,7 +12,8 @@ LOCAL_MODULE_TAGS := debug
 LOCAL_MODULE := libOpenglRender
 LOCAL_ADDITIONAL_DEPENDENCIES := \
 	$(HOST_OUT_SHARED_LIBRARIES)/lib_renderControl_dec$(HOST_SHLIB_SUFFIX) \
-	$(HOST_OUT_SHARED_LIBRARIES)/libGLESv1_dec$(HOST_SHLIB_SUFFIX)
+	$(HOST_OUT_SHARED_LIBRARIES)/libGLESv1_dec$(HOST_SHLIB_SUFFIX) \
+	$(HOST_OUT_SHARED_LIBRARIES)/libGLESv2_dec$(HOST_SHLIB_SUFFIX)
 
 LOCAL_SRC_FILES := \
     render_api.cpp \
@@ -26,9 +27,17 @@ LOCAL_SRC_FILES := \
     WindowSurface.cpp \
     RenderControl.cpp \
     ThreadInfo.cpp \
+    RenderChannel.cpp \
+    RenderPipeline.cpp \
     RenderThread.cpp \
     ReadBuffer.cpp \
-    RenderServer.cpp
+    RenderServer.cpp \
+    StateFilter.cpp \
+    StreamCapture.cpp
+
+ifeq ($(HOST_OS),linux)
+    LOCAL_SRC_FILES += RenderWorker.cpp
+endif
 
 LOCAL_C_INCLUDES += \
     $(emulatorOpengl)/host/include \
@@ -36,9 +45,12 @@ LOCAL_C_INCLUDES += \
     $(emulatorOpengl)/shared/OpenglOsUtils \
     $(emulatorOpengl)/host/include/libOpenglRender \
     $(emulatorOpengl)/host/libs/GLESv1_dec \
+    $(emulatorOpengl)/host/libs/GLESv2_dec \
     $(emulatorOpengl)/system/GLESv1_enc \
+    $(emulatorOpengl)/system/GLESv2_enc \
     $(emulatorOpengl)/system/renderControl_enc \
 	$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv1_dec, HOST) \
+	$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv2_dec, HOST) \
 	$(call intermediates-dir-for, SHARED_LIBRARIES, lib_renderControl_dec, HOST)
 
 LOCAL_STATIC_LIBRARIES := \
@@ -50,8 +62,11 @@ LOCAL_STATIC_LIBRARIES := \
 
 LOCAL_SHARED_LIBRARIES := \
         libGLESv1_dec \
+        libGLESv2_dec \
         lib_renderControl_dec
 
+LOCAL_CFLAGS += -DWITH_GLES2
+
 ifeq ($(HOST_OS),windows)
     LOCAL_LDLIBS := -lws2_32
 endif
@@ -19,8 +19,12 @@
 #include "GLDispatch.h"
 #include "GL2Dispatch.h"
 #include "ThreadInfo.h"
+#include "TimeUtils.h"
 #include <stdio.h>
 
+// how long a lookup waits for an object with a reserved handle
+#define RESERVED_HANDLE_WAIT_MS 2000
+
 FrameBuffer *FrameBuffer::s_theFrameBuffer = NULL;
 HandleType FrameBuffer::s_nextHandle = 0;
 
@@ -317,40 +321,122 @@ FrameBuffer::~FrameBuffer()
 {
 }
 
-HandleType FrameBuffer::genHandle()
+bool FrameBuffer::handleInUse(HandleType p_handle)
+{
+    return m_contexts.find(p_handle) != m_contexts.end() ||
+           m_windows.find(p_handle) != m_windows.end() ||
+           m_colorbuffers.find(p_handle) != m_colorbuffers.end();
+}
+
+HandleType FrameBuffer::genHandle(HandleType p_proposed)
 {
+    if (p_proposed != 0) {
+        return handleInUse(p_proposed) ? 0 : p_proposed;
+    }
+
     HandleType id;
     do {
         id = ++s_nextHandle;
-    } while( id == 0 ||
-             m_contexts.find(id) != m_contexts.end() ||
-             m_windows.find(id) != m_windows.end() );
+    } while( id == 0 || handleInUse(id) ||
+             m_reservedHandles.find(id) != m_reservedHandles.end() );
 
     return id;
 }
 
+//
+// reserveHandles - moves the handle counter past p_count unused handles,
+// so that genHandle() does not give them out, and returns the first one.
+//
+HandleType FrameBuffer::reserveHandles(uint32_t p_count)
+{
+    android::Mutex::Autolock mutex(m_lock);
+
+    if (p_count == 0) {
+        return 0;
+    }
+
+    for (int attempt = 0; attempt < 16; attempt++) {
+        HandleType first = s_nextHandle + 1;
+        HandleType last = first + p_count - 1;
+        if (first == 0 || last < first) {
+            // the range would wrap around, start over
+            s_nextHandle = 0;
+            continue;
+        }
+        s_nextHandle = last;
+
+        bool inUse = false;
+        for (HandleType h = first; h != last + 1 && !inUse; h++) {
+            inUse = handleInUse(h) ||
+                    m_reservedHandles.find(h) != m_reservedHandles.end();
+        }
+        if (!inUse) {
+            for (HandleType h = first; h != last + 1; h++) {
+                m_reservedHandles.insert(h);
+            }
+            return first;
+        }
+    }
+    return 0;
+}
+
+void FrameBuffer::releaseHandles(HandleType p_first, uint32_t p_count)
+{
+    android::Mutex::Autolock mutex(m_lock);
+
+    for (uint32_t i = 0; i < p_count; i++) {
+        m_reservedHandles.erase(p_first + i);
+    }
+    m_releasedCond.broadcast();
+}
+
+//
+// waitCreated_locked - waits until p_handle is no longer reserved, the
+// object then exists or it never will, or until it is time to give up.
+//
+void FrameBuffer::waitCreated_locked(HandleType p_handle)
+{
+    if (m_reservedHandles.find(p_handle) == m_reservedHandles.end()) {
+        return;
+    }
+
+    long long deadline = GetCurrentTimeMS() + RESERVED_HANDLE_WAIT_MS;
+    while (m_reservedHandles.find(p_handle) != m_reservedHandles.end()) {
+        long long left = deadline - GetCurrentTimeMS();
+        if (left <= 0) {
+            fprintf(stderr, "FrameBuffer: handle 0x%x was reserved but not created\n", p_handle);
+            return;
+        }
+        m_releasedCond.waitRelative(m_lock, left * 1000000LL);
+    }
+}
+
 HandleType FrameBuffer::createColorBuffer(int p_width, int p_height,
-                                          GLenum p_internalFormat)
+                                          GLenum p_internalFormat,
+                                          HandleType p_handle)
 {
     android::Mutex::Autolock mutex(m_lock);
     HandleType ret = 0;
 
     ColorBufferPtr cb( ColorBuffer::create(p_width, p_height, p_internalFormat) );
     if (cb.Ptr() != NULL) {
-        ret = genHandle();
-        m_colorbuffers[ret] = cb;
+        ret = genHandle(p_handle);
+        if (ret) {
+            m_colorbuffers[ret] = cb;
+        }
     }
     return ret;
 }
 
 HandleType FrameBuffer::createRenderContext(int p_config, HandleType p_share,
-                                            bool p_isGL2)
+                                            bool p_isGL2, HandleType p_handle)
 {
     android::Mutex::Autolock mutex(m_lock);
     HandleType ret = 0;
 
     RenderContextPtr share(NULL);
     if (p_share != 0) {
+        waitCreated_locked(p_share);
         RenderContextMap::iterator s( m_contexts.find(p_share) );
         if (s == m_contexts.end()) {
             return 0;
@@ -360,21 +446,26 @@ HandleType FrameBuffer::createRenderContext(int p_config, HandleType p_share,
 
     RenderContextPtr rctx( RenderContext::create(p_config, share, p_isGL2) );
     if (rctx.Ptr() != NULL) {
-        ret = genHandle();
-        m_contexts[ret] = rctx;
+        ret = genHandle(p_handle);
+        if (ret) {
+            m_contexts[ret] = rctx;
+        }
     }
     return ret;
 }
 
-HandleType FrameBuffer::createWindowSurface(int p_config, int p_width, int p_height)
+HandleType FrameBuffer::createWindowSurface(int p_config, int p_width, int p_height,
+                                           HandleType p_handle)
 {
     android::Mutex::Autolock mutex(m_lock);
 
     HandleType ret = 0;
     WindowSurfacePtr win( WindowSurface::create(p_config, p_width, p_height) );
     if (win.Ptr() != NULL) {
-        ret = genHandle();
-        m_windows[ret] = win;
+        ret = genHandle(p_handle);
+        if (ret) {
+            m_windows[ret] = win;
+        }
     }
 
     return ret;
@@ -383,18 +474,21 @@ HandleType FrameBuffer::createWindowSurface(int p_config, int p_width, int p_hei
 void FrameBuffer::DestroyRenderContext(HandleType p_context)
 {
     android::Mutex::Autolock mutex(m_lock);
+    waitCreated_locked(p_context);
     m_contexts.erase(p_context);
 }
 
 void FrameBuffer::DestroyWindowSurface(HandleType p_surface)
 {
     android::Mutex::Autolock mutex(m_lock);
+    waitCreated_locked(p_surface);
     m_windows.erase(p_surface);
 }
 
 void FrameBuffer::DestroyColorBuffer(HandleType p_colorbuffer)
 {
     android::Mutex::Autolock mutex(m_lock);
+    waitCreated_locked(p_colorbuffer);
     m_colorbuffers.erase(p_colorbuffer);
 }
 
@@ -402,6 +496,8 @@ bool FrameBuffer::setWindowSurfaceColorBuffer(HandleType p_surface,
                                               HandleType p_colorbuffer)
 {
     android::Mutex::Autolock mutex(m_lock);
+    waitCreated_locked(p_surface);
+    waitCreated_locked(p_colorbuffer);
 
     WindowSurfaceMap::iterator w( m_windows.find(p_surface) );
     if (w == m_windows.end()) {
@@ -433,6 +529,9 @@ bool FrameBuffer::bindContext(HandleType p_context,
     // if this is not an unbind operation - make sure all handles are good
     //
     if (p_context || p_drawSurface || p_readSurface) {
+        waitCreated_locked(p_context);
+        waitCreated_locked(p_drawSurface);
+        waitCreated_locked(p_readSurface);
         RenderContextMap::iterator r( m_contexts.find(p_context) );
         if (r == m_contexts.end()) {
             // bad context handle
@@ -499,6 +598,26 @@ bool FrameBuffer::bindContext(HandleType p_context,
     return true;
 }
 
+//
+// Makes the context and surfaces recorded in the calling thread's
+// RenderThreadInfo current again, after the thread was serving another
+// connection.
+//
+bool FrameBuffer::restoreContext()
+{
+    android::Mutex::Autolock mutex(m_lock);
+
+    RenderThreadInfo *tinfo = getRenderThreadInfo();
+    WindowSurfacePtr draw = tinfo->currDrawSurf;
+    WindowSurfacePtr read = tinfo->currReadSurf;
+    RenderContextPtr ctx = tinfo->currContext;
+
+    return s_egl.eglMakeCurrent(m_eglDisplay,
+                                draw ? draw->getEGLSurface() : EGL_NO_SURFACE,
+                                read ? read->getEGLSurface() : EGL_NO_SURFACE,
+                                ctx ? ctx->getEGLContext() : EGL_NO_CONTEXT);
+}
+
 //
 // The framebuffer lock should be held when calling this function !
 //
@@ -537,6 +656,7 @@ bool FrameBuffer::post(HandleType p_colorbuffer)
     android::Mutex::Autolock mutex(m_lock);
     bool ret = false;
 
+    waitCreated_locked(p_colorbuffer);
     ColorBufferMap::iterator c( m_colorbuffers.find(p_colorbuffer) );
     if (c != m_colorbuffers.end()) {
         if (!bind_locked()) {
@@ -22,6 +22,7 @@
 #include "WindowSurface.h"
 #include <utils/threads.h>
 #include <map>
+#include <set>
 #include <EGL/egl.h>
 #include <stdint.h>
 
@@ -58,14 +59,27 @@ public:
     int getWidth() const { return m_width; }
     int getHeight() const { return m_height; }
 
-    HandleType createRenderContext(int p_config, HandleType p_share, bool p_isGL2 = false);
-    HandleType createWindowSurface(int p_config, int p_width, int p_height);
-    HandleType createColorBuffer(int p_width, int p_height, GLenum p_internalFormat);
+    // p_handle, if not 0, is the handle the object should get, taken
+    // from a range returned by reserveHandles(). 0 is returned if it is
+    // already in use.
+    HandleType createRenderContext(int p_config, HandleType p_share, bool p_isGL2 = false,
+                                   HandleType p_handle = 0);
+    HandleType createWindowSurface(int p_config, int p_width, int p_height,
+                                   HandleType p_handle = 0);
+    HandleType createColorBuffer(int p_width, int p_height, GLenum p_internalFormat,
+                                 HandleType p_handle = 0);
+    HandleType reserveHandles(uint32_t p_count);
+    // ends the reservation of handles that were used, or that will not be
+    // any more. Until then, a lookup of one of them waits a while for the
+    // object to be created: the connection that reserved it and the one
+    // using it are decoded independently.
+    void releaseHandles(HandleType p_first, uint32_t p_count);
     void DestroyRenderContext(HandleType p_context);
     void DestroyWindowSurface(HandleType p_surface);
     void DestroyColorBuffer(HandleType p_colorbuffer);
 
     bool  bindContext(HandleType p_context, HandleType p_drawSurface, HandleType p_readSurface);
+    bool  restoreContext();
     bool  setWindowSurfaceColorBuffer(HandleType p_surface, HandleType p_colorbuffer);
 
     bool post(HandleType p_colorbuffer);
@@ -79,7 +93,9 @@ public:
 private:
     FrameBuffer(int p_x, int p_y, int p_width, int p_height);
     ~FrameBuffer();
-    HandleType genHandle();
+    HandleType genHandle(HandleType p_proposed = 0);
+    bool handleInUse(HandleType p_handle);
+    void waitCreated_locked(HandleType p_handle);
 
 private:
     static FrameBuffer *s_theFrameBuffer;
@@ -89,6 +105,8 @@ private:
     int m_width;
     int m_height;
     android::Mutex m_lock;
+    std::set<HandleType> m_reservedHandles;
+    android::Condition m_releasedCond;  // signaled when handles are released
     FBNativeWindowType m_nativeWindow;
     FrameBufferCaps m_caps;
     EGLDisplay m_eglDisplay;
@@ -23,7 +23,7 @@
 bool init_gl2_dispatch();
 void *gl2_dispatch_get_proc_func(const char *name, void *userData);
 
-extern gl2_decoder_context_t s_gl;
+extern gl2_decoder_context_t s_gl2;
 
 #endif
 #endif
@@ -17,29 +17,186 @@
 #include <string.h>
 #include <assert.h>
 
-ReadBuffer::ReadBuffer(IOStream *stream, size_t bufsize)
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static int createRingFd(size_t size)
 {
-    m_size = bufsize;
-    m_stream = stream;
-    m_buf = new unsigned char[m_size];
-    m_validData = 0;
-    m_readPtr = m_buf;
+    int fd = -1;
+#ifdef __NR_memfd_create
+    fd = syscall(__NR_memfd_create, "opengl-read-buffer", 0);
+#endif
+    if (fd < 0) {
+        char name[64];
+        snprintf(name, sizeof(name), "/opengl-read-buffer-%d-%p", getpid(), &fd);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            return -1;
+        }
+        shm_unlink(name);
+    }
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+//
+// mapMirroredRing - maps 'size' bytes of fresh shared memory twice, back
+// to back, inside a single reserved range of 2*size bytes.
+//
+static unsigned char *mapMirroredRing(size_t size)
+{
+    int fd = createRingFd(size);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    unsigned char *base = (unsigned char *)mmap(NULL, 2 * size, PROT_NONE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    void *lo = mmap(base, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fd, 0);
+    void *hi = mmap(base + size, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);
+
+    if (lo != base || hi != base + size) {
+        munmap(base, 2 * size);
+        return NULL;
+    }
+    return base;
+}
+#endif
+
+//
+// allocRing - allocates a receive buffer of at least *inout_size bytes,
+// mirrored if possible, and updates *inout_size to the actual size.
+//
+static unsigned char *allocRing(size_t *inout_size, bool *out_mirrored)
+{
+#ifdef __linux__
+    size_t pageSize = getpagesize();
+    size_t ringSize = (*inout_size + pageSize - 1) & ~(pageSize - 1);
+    unsigned char *ring = mapMirroredRing(ringSize);
+    if (ring) {
+        *inout_size = ringSize;
+        *out_mirrored = true;
+        return ring;
+    }
+#endif
+
+    *out_mirrored = false;
+    return new unsigned char[*inout_size];
+}
+
+static void freeRing(unsigned char *buf, size_t size, bool mirrored)
+{
+#ifdef __linux__
+    if (mirrored) {
+        munmap(buf, 2 * size);
+        return;
+    }
+#endif
+    delete [] buf;
+}
+
+ReadBuffer::ReadBuffer(IOStream *stream, size_t bufsize) :
+    m_readOff(0),
+    m_size(bufsize),
+    m_validData(0),
+    m_stream(stream),
+    m_readPos(0),
+    m_pinPos(0),
+    m_pinned(false)
+{
+    m_buf = allocRing(&m_size, &m_mirrored);
+    memset(&m_pinStats, 0, sizeof(m_pinStats));
 }
 
 ReadBuffer::~ReadBuffer()
 {
-    delete m_buf;
+    unpinAll();
+    freeRing(m_buf, m_size, m_mirrored);
+}
+
+//
+// grow - doubles the buffer size, keeping the unconsumed data.
+// Only happens when a single packet does not fit in the buffer.
+//
+bool ReadBuffer::grow()
+{
+    size_t newSize = 2 * m_size;
+    bool newMirrored;
+    unsigned char *newBuf = allocRing(&newSize, &newMirrored);
+    if (!newBuf) {
+        return false;
+    }
+
+    // the data keeps its alignment in the stream, there is room for it
+    // as the new ring is at least twice as large as the data
+    size_t newOff = (size_t)(m_readPos & 3);
+    memcpy(newBuf + newOff, buf(), m_validData);
+    if (m_pinned) {
+        // the pinned data stays where it is until unpinAll()
+        Ring old = { m_buf, m_size, m_mirrored };
+        m_retired.push_back(old);
+        m_pinned = false;
+    } else {
+        freeRing(m_buf, m_size, m_mirrored);
+    }
+
+    m_buf = newBuf;
+    m_size = newSize;
+    m_mirrored = newMirrored;
+    m_readOff = newOff;
+    return true;
 }
 
 int ReadBuffer::getData()
 {
-    if (m_validData > 0) {
-        memcpy(m_buf, m_readPtr, m_validData);
+    size_t pinned = pinnedData();
+    if (m_validData + pinned == m_size) {
+        // the decoders could not consume anything out of a full
+        // buffer, the pending packet is larger than the buffer, or
+        // the rest of it is pinned.
+        if (!grow()) {
+            ERR("ReadBuffer: failed to grow to %u bytes\n", (unsigned int)(2 * m_size));
+            return -1;
+        }
     }
-    m_readPtr = m_buf;
-    // get fresh data into the buffer;
-    size_t len = m_size - m_validData;
-    if (NULL != m_stream->read(m_buf + m_validData, &len)) {
+
+    size_t writeOff;
+    if (m_mirrored) {
+        // the free space starts right after the valid data and is
+        // contiguous through the mirror mapping.
+        writeOff = m_readOff + m_validData;
+        if (writeOff >= m_size) {
+            writeOff -= m_size;
+        }
+    } else {
+        if (m_readOff + m_validData > m_size - m_size / 4) {
+            // little room left at the tail, move leftover to the start
+            memmove(m_buf, m_buf + m_readOff, m_validData);
+            m_readOff = 0;
+        }
+        writeOff = m_readOff + m_validData;
+    }
+
+    // get fresh data into the buffer; the pinned data of the ring is
+    // behind the read location, the free space ends there
+    size_t len = (m_mirrored ? m_size - m_validData - pinnedData() : m_size - writeOff);
+    if (NULL != m_stream->read(m_buf + writeOff, &len)) {
         m_validData += len;
         return len;
     }
@@ -50,5 +207,53 @@ void ReadBuffer::consume(size_t amount)
 {
     assert(amount <= m_validData);
     m_validData -= amount;
-    m_readPtr += amount;
+    m_readOff += amount;
+    m_readPos += amount;
+    if (m_mirrored) {
+        if (m_readOff >= m_size) {
+            m_readOff -= m_size;
+        }
+    } else if (m_validData == 0) {
+        m_readOff = 0;
+    }
+}
+
+bool ReadBuffer::pin(const void *data, size_t len)
+{
+    const unsigned char *ptr = (const unsigned char *)data;
+    m_pinStats.requests++;
+    if (((uintptr_t)ptr & 3) != 0) {
+        m_pinStats.misaligned++;
+        return false;
+    }
+    if (!m_mirrored || ptr < buf() || ptr > buf() + m_validData ||
+        len > (size_t)(buf() + m_validData - ptr)) {
+        return false;
+    }
+
+    unsigned long long pos = m_readPos + (ptr - buf());
+    if (!m_pinned || pos < m_pinPos) {
+        m_pinPos = pos;
+        m_pinned = true;
+    }
+    m_pinStats.pinned++;
+    return true;
+}
+
+void ReadBuffer::unpinAll()
+{
+    m_pinned = false;
+    for (size_t i = 0; i < m_retired.size(); i++) {
+        freeRing(m_retired[i].buf, m_retired[i].size, m_retired[i].mirrored);
+    }
+    m_retired.clear();
+}
+
+//
+// pinnedData - the amount of consumed data that is pinned, it ends at
+// the read location.
+//
+size_t ReadBuffer::pinnedData()
+{
+    return m_pinned && m_pinPos < m_readPos ? (size_t)(m_readPos - m_pinPos) : 0;
 }
@@ -17,20 +17,70 @@
 #define _READ_BUFFER_H
 
 #include "IOStream.h"
+#include "DataPinner.h"
+#include <stdint.h>
+#include <vector>
 
-class ReadBuffer {
+//
+// ReadBuffer - receive buffer for the decode loop.
+// On linux the buffer is a ring whose pages are mapped twice back to
+// back, so the unconsumed data is always visible as one contiguous
+// region even when it wraps around the end, and no data is ever moved.
+// Elsewhere (or if the double mapping cannot be set up) leftover data is
+// moved back to the start of the buffer when the tail runs short.
+// The buffer doubles in size when it fills up with data that could not
+// be consumed, so packets larger than the buffer do not stall the stream.
+//
+// With the ring, consumed data can stay pinned (see DataPinner.h): the
+// ring is not refilled past the oldest pinned byte until unpinAll().
+// If it fills up meanwhile it grows, and the old ring is kept mapped
+// until then. Other buffers do not support pinning. Data is only pinned
+// if it is 4 byte aligned; the ring keeps the alignment it had in the
+// stream, which the encoders set for the data meant to be pinned.
+//
+class ReadBuffer : public DataPinner {
 public:
     ReadBuffer(IOStream *stream, size_t bufSize);
     ~ReadBuffer();
     int getData(); // get fresh data from the stream
-    unsigned char *buf() { return m_readPtr; } // return the next read location
+    unsigned char *buf() { return m_buf + m_readOff; } // return the next read location
     size_t validData() { return m_validData; } // return the amount of valid data in readptr
     void consume(size_t amount); // notify that 'amount' data has been consumed;
+
+    // pins data of the unconsumed region
+    virtual bool pin(const void *data, size_t len);
+    virtual void unpinAll();
+
+    // counts of the pin() calls since the buffer was created
+    struct PinStats {
+        uint64_t requests;
+        uint64_t misaligned;    // not pinned as not 4 byte aligned
+        uint64_t pinned;
+    };
+    const PinStats &pinStats() const { return m_pinStats; }
+
+private:
+    struct Ring {
+        unsigned char *buf;
+        size_t size;
+        bool mirrored;
+    };
+
+    bool grow();
+    size_t pinnedData();
+
 private:
     unsigned char *m_buf;
-    unsigned char *m_readPtr;
+    size_t m_readOff;
     size_t m_size;
     size_t m_validData;
+    bool m_mirrored;
     IOStream *m_stream;
+
+    unsigned long long m_readPos;   // stream position of buf()
+    unsigned long long m_pinPos;    // stream position of the oldest pinned byte
+    bool m_pinned;
+    std::vector<Ring> m_retired;    // rings outgrown while data was pinned
+    PinStats m_pinStats;
 };
 #endif
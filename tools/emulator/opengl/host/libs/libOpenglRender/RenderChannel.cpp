@@ -0,0 +1,303 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "RenderChannel.h"
+#include "RenderControl.h"
+#include "StateFilter.h"
+#include "FrameBuffer.h"
+#include "TimeUtils.h"
+#include "GLDispatch.h"
+#ifdef WITH_GLES2
+#include "GL2Dispatch.h"
+#include "GL2Decoder.h"
+#endif
+#include <utils/threads.h>
+#include <stdlib.h>
+
+#define STREAM_BUFFER_SIZE 4*1024*1024
+
+#define STATS_FILE_VAR "ANDROID_GL_STATS_FILE"
+
+// ranges of reserved handles kept per connection, the oldest range is
+// dropped when a client reserves more
+#define MAX_RESERVED_RANGES 16
+
+static android::Mutex s_statsLock;
+static FILE *s_statsFile = NULL;
+static bool s_statsFileChecked = false;
+static int s_nextId = 0;
+
+RenderChannel::RenderChannel(IOStream *p_stream) :
+    m_stream(p_stream),
+    m_readBuf(p_stream, STREAM_BUFFER_SIZE),
+    m_gl2Dec(NULL),
+    m_asyncError(0),
+    m_statsBytes(0)
+{
+    //
+    // initialize decoders
+    //
+    m_glDec.initGL( gl_dispatch_get_proc_func, NULL );
+    StateFilter::install(&m_glDec);
+    initRenderControlContext( &m_rcDec );
+
+    m_dispatcher.addDecoder(&GLDecoder::s_info, &m_glDec, &m_glDec.m_stats);
+    m_dispatcher.addDecoder(&renderControl_decoder_context_t::s_info,
+                            &m_rcDec, &m_rcDec.m_stats);
+
+#ifdef WITH_GLES2
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (fb && fb->getCaps().hasGL2) {
+        m_gl2Dec = new GL2Decoder();
+        m_gl2Dec->initGL( gl2_dispatch_get_proc_func, NULL );
+        StateFilter::install(m_gl2Dec);
+        m_dispatcher.addDecoder(&GL2Decoder::s_info, m_gl2Dec, &m_gl2Dec->m_stats);
+    }
+#endif
+
+    // process() decodes straight out of the receive buffer, the
+    // client arrays data is used there
+    setDataPinner(&m_readBuf);
+
+    m_threadInfo.channel = this;
+    m_statsT0 = GetCurrentTimeMS();
+
+    s_statsLock.lock();
+    m_id = s_nextId++;
+    s_statsLock.unlock();
+
+    m_capture = StreamCapture::get();
+    if (m_capture) {
+        m_capture->record(m_id, CAPTURE_OPEN, NULL, 0);
+    }
+}
+
+RenderChannel::~RenderChannel()
+{
+    if (m_capture) {
+        m_capture->record(m_id, CAPTURE_CLOSE, NULL, 0);
+    }
+    dumpStats();
+    releaseReservedHandles(0, m_reserved.size());
+#ifdef WITH_GLES2
+    delete m_gl2Dec;
+#endif
+    delete m_stream;
+}
+
+bool RenderChannel::process()
+{
+    if (receive() <= 0) {
+        return false;
+    }
+
+    //
+    // decode every complete packet received so far, whatever api
+    // it belongs to.
+    //
+    size_t last = m_dispatcher.decode(m_readBuf.buf(), m_readBuf.validData(), m_stream);
+    if (last > 0) {
+        m_readBuf.consume(last);
+    }
+    if (m_dispatcher.failed()) {
+        fprintf(stderr, "invalid command stream, closing connection\n");
+        return false;
+    }
+
+    return true;
+}
+
+int RenderChannel::receive()
+{
+    int stat = m_readBuf.getData();
+    if (stat <= 0) {
+        fprintf(stderr, "client shutdown\n");
+        return stat;
+    }
+
+    if (m_capture) {
+        m_capture->record(m_id, CAPTURE_DATA,
+                          m_readBuf.buf() + m_readBuf.validData() - stat, stat);
+    }
+
+    //
+    // log received bandwidth statistics
+    //
+    m_statsBytes += stat;
+    long long dt = GetCurrentTimeMS() - m_statsT0;
+    if (dt > 1000) {
+        float dts = (float)dt / 1000.0f;
+        printf("Used Bandwidth %5.3f MB/s\n", ((float)m_statsBytes / dts) / (1024.0f*1024.0f));
+        m_statsBytes = 0;
+        m_statsT0 = GetCurrentTimeMS();
+        dumpStats();
+    }
+
+    return stat;
+}
+
+size_t RenderChannel::stage(bool *out_reply)
+{
+    return m_dispatcher.scan(m_readBuf.buf(), m_readBuf.validData(), out_reply);
+}
+
+size_t RenderChannel::execute(unsigned char *buf, size_t len)
+{
+    // the packets were copied out of the receive buffer, which the
+    // reading thread keeps refilling
+    setDataPinner(NULL);
+    return m_dispatcher.decode(buf, len, m_stream);
+}
+
+void RenderChannel::setDataPinner(DataPinner *pinner)
+{
+    m_glDec.setDataPinner(pinner);
+#ifdef WITH_GLES2
+    if (m_gl2Dec) {
+        m_gl2Dec->setDataPinner(pinner);
+    }
+#endif
+}
+
+int RenderChannel::copyOpcodeStats(uint32_t opcode, uint32_t count, void *out)
+{
+    if (m_glDec.m_stats.hasOpcode(opcode)) {
+        return m_glDec.m_stats.copy(opcode, count, out);
+    }
+#ifdef WITH_GLES2
+    if (m_gl2Dec && m_gl2Dec->m_stats.hasOpcode(opcode)) {
+        return m_gl2Dec->m_stats.copy(opcode, count, out);
+    }
+#endif
+    return m_rcDec.m_stats.copy(opcode, count, out);
+}
+
+void RenderChannel::addReservedHandles(uint32_t first, uint32_t count)
+{
+    if (m_reserved.size() >= MAX_RESERVED_RANGES) {
+        releaseReservedHandles(0, 1);
+    }
+    HandleRange range;
+    range.next = first;
+    range.last = first + count - 1;
+    m_reserved.push_back(range);
+}
+
+bool RenderChannel::claimReservedHandle(uint32_t handle)
+{
+    for (size_t i = 0; i < m_reserved.size(); i++) {
+        HandleRange &range = m_reserved[i];
+        if (handle >= range.next && handle <= range.last) {
+            // the handles skipped can no longer be claimed
+            FrameBuffer *fb = FrameBuffer::getFB();
+            if (fb && handle > range.next) {
+                fb->releaseHandles(range.next, handle - range.next);
+            }
+            if (handle == range.last) {
+                m_reserved.erase(m_reserved.begin() + i);
+            } else {
+                range.next = handle + 1;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// releaseReservedHandles - drops 'count' ranges from the i'th one on,
+// with the handles in them that were not claimed.
+//
+void RenderChannel::releaseReservedHandles(size_t i, size_t count)
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    for (size_t k = i; k < i + count; k++) {
+        if (fb) {
+            fb->releaseHandles(m_reserved[k].next, m_reserved[k].last - m_reserved[k].next + 1);
+        }
+    }
+    m_reserved.erase(m_reserved.begin() + i, m_reserved.begin() + i + count);
+}
+
+void RenderChannel::setDecoderContextData(GLDecoderContextData *contextData)
+{
+    m_glDec.setContextData(contextData);
+#ifdef WITH_GLES2
+    if (m_gl2Dec) {
+        m_gl2Dec->setContextData(contextData);
+    }
+#endif
+}
+
+uint32_t RenderChannel::s_currentGLError(void *data)
+{
+    RenderContext *ctx = getRenderThreadInfo()->currContext.Ptr();
+    if (ctx == NULL) {
+        return GL_NO_ERROR;
+    }
+#ifdef WITH_GLES2
+    if (ctx->isGL2()) {
+        return s_gl2.glGetError();
+    }
+#endif
+    return s_gl.glGetError();
+}
+
+void RenderChannel::dumpStats()
+{
+    android::Mutex::Autolock mutex(s_statsLock);
+
+    if (!s_statsFileChecked) {
+        const char *fileName = getenv(STATS_FILE_VAR);
+        if (fileName) {
+            s_statsFile = fopen(fileName, "a");
+            if (!s_statsFile) {
+                fprintf(stderr, "Failed to open %s\n", fileName);
+            }
+        }
+        s_statsFileChecked = true;
+    }
+    if (!s_statsFile) {
+        return;
+    }
+
+    long long now = GetCurrentTimeMS();
+    m_glDec.m_stats.dumpJson(s_statsFile, now, m_id);
+#ifdef WITH_GLES2
+    if (m_gl2Dec) {
+        m_gl2Dec->m_stats.dumpJson(s_statsFile, now, m_id);
+    }
+#endif
+    m_rcDec.m_stats.dumpJson(s_statsFile, now, m_id);
+    // client arrays used in place rather than copied, see ReadBuffer.h
+    const ReadBuffer::PinStats &pins = m_readBuf.pinStats();
+    if (pins.requests > 0) {
+        fprintf(s_statsFile, "{\"time_ms\":%lld,\"conn\":%d,\"pin_requests\":%llu,"
+                             "\"pin_misaligned\":%llu,\"pinned\":%llu}\n",
+                now, m_id,
+                (unsigned long long)pins.requests,
+                (unsigned long long)pins.misaligned,
+                (unsigned long long)pins.pinned);
+    }
+    fflush(s_statsFile);
+}
+
+void RenderChannel::unbind()
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (fb && getRenderThreadInfo()->currContext.Ptr() != NULL) {
+        fb->bindContext(0, 0, 0);
+    }
+}
@@ -0,0 +1,144 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIB_OPENGL_RENDER_RENDER_CHANNEL_H
+#define _LIB_OPENGL_RENDER_RENDER_CHANNEL_H
+
+#include "IOStream.h"
+#include "ReadBuffer.h"
+#include "ThreadInfo.h"
+#include "GLDecoder.h"
+#include "renderControl_dec.h"
+#include "OpcodeDispatcher.h"
+#include "GLDecoderContextData.h"
+#include "StreamCapture.h"
+#include <vector>
+
+class GL2Decoder;
+
+//
+// RenderChannel - the renderer side of one guest connection: the
+// stream, its receive buffer, the decoders and the GL binding state of
+// the connection. A channel can be driven by a dedicated thread or be
+// one of the channels served by a RenderWorker. The GLES1, GLES2 (when
+// the host supports it) and renderControl packets of the connection are
+// decoded in a single pass through an OpcodeDispatcher.
+//
+// If ANDROID_GL_STATS_FILE is set, the per opcode statistics of every
+// channel are appended to that file as JSON lines once per second while
+// the channel is active, and when it is closed. If ANDROID_GL_CAPTURE_FILE
+// is set the received data is recorded there (see StreamCapture.h).
+//
+class RenderChannel
+{
+public:
+    explicit RenderChannel(IOStream *p_stream); // takes ownership of p_stream
+    ~RenderChannel();
+
+    // reads once from the stream and decodes every complete packet
+    // received so far. Blocks only if the stream has no data at all.
+    // Returns false when the client went away.
+    bool process();
+
+    //
+    // The two halves of process(), for channels whose packets are
+    // executed on another thread than the one reading the stream (see
+    // RenderPipeline). receive() reads once from the stream into
+    // readBuffer() and returns the number of bytes read, or <= 0 when
+    // the client went away. stage() returns the size of the complete
+    // packets at the head of readBuffer(), up to and including the first
+    // call that sends a reply (*out_reply is set then); it fails(),
+    // returning 0, if the data is not a valid command stream. execute()
+    // decodes and runs complete packets, possibly copied elsewhere.
+    //
+    int receive();
+    ReadBuffer *readBuffer() { return &m_readBuf; }
+    size_t stage(bool *out_reply);
+    bool failed() const { return m_dispatcher.failed(); }
+    size_t execute(unsigned char *buf, size_t len);
+
+    // releases the context bound by the client, must be called on the
+    // thread that served the channel last.
+    void unbind();
+
+    // client side arrays data of the context the client bound,
+    // NULL when no context is bound.
+    void setDecoderContextData(GLDecoderContextData *contextData);
+
+    // header format of the packets that follow, see rcSetPacketFormat
+    bool setPacketFormat(uint32_t format) { return m_dispatcher.setPacketFormat(format); }
+
+    // appends the GL error of the current context to every reply that
+    // follows, see rcSetReplyStatus
+    void setReplyStatus(bool enable) {
+        m_dispatcher.setReplyStatus(enable ? s_currentGLError : NULL, this);
+    }
+
+    IOStream *stream() { return m_stream; }
+    RenderThreadInfo *threadInfo() { return &m_threadInfo; }
+
+    // decoder statistics, see DecoderStats::copy()
+    int copyOpcodeStats(uint32_t opcode, uint32_t count, void *out);
+
+    // handles reserved by the client with rcReserveHandles. Each one
+    // can be claimed once, in increasing order within its range; the
+    // creation that claims one releases it from the FrameBuffer, and the
+    // channel releases those left when it drops a range.
+    void addReservedHandles(uint32_t first, uint32_t count);
+    bool claimReservedHandle(uint32_t handle);
+
+    // first asynchronous creation that failed, see rcGetAsyncError
+    void setAsyncError(uint32_t handle) {
+        if (m_asyncError == 0) {
+            m_asyncError = handle;
+        }
+    }
+    uint32_t takeAsyncError() {
+        uint32_t handle = m_asyncError;
+        m_asyncError = 0;
+        return handle;
+    }
+
+private:
+    struct HandleRange
+    {
+        uint32_t next;      // lowest handle that can still be claimed
+        uint32_t last;
+    };
+
+    void dumpStats();
+    void releaseReservedHandles(size_t i, size_t count);
+    void setDataPinner(DataPinner *pinner);
+    static uint32_t s_currentGLError(void *data);
+
+private:
+    int m_id;
+    StreamCapture *m_capture;
+    IOStream *m_stream;
+    ReadBuffer m_readBuf;
+    GLDecoder m_glDec;
+    GL2Decoder *m_gl2Dec;   // NULL if the host has no GLES2 support
+    renderControl_decoder_context_t m_rcDec;
+    OpcodeDispatcher m_dispatcher;
+    RenderThreadInfo m_threadInfo;
+
+    std::vector<HandleRange> m_reserved;
+    uint32_t m_asyncError;
+
+    int m_statsBytes;
+    long long m_statsT0;
+};
+
+#endif
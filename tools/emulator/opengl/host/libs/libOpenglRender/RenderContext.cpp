@@ -47,6 +47,8 @@ RenderContext *RenderContext::create(int p_config,
         glContextAttribs[1] = 2;
         c->m_isGL2 = true;
     }
+    // the filter checks caps and enum values against those of the api
+    c->m_stateShadow.setApi(p_isGL2 ? GLStateShadow::GLES2 : GLStateShadow::GLES1);
 
     c->m_ctx = s_egl.eglCreateContext(FrameBuffer::getFB()->getDisplay(),
                                       fbconf->getEGLConfig(), share,
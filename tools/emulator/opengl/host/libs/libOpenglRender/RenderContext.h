@@ -17,6 +17,8 @@
 #define _LIBRENDER_RENDERCONTEXT_H
 
 #include "SmartPtr.h"
+#include "GLDecoderContextData.h"
+#include "GLStateShadow.h"
 #include <EGL/egl.h>
 
 class RenderContext;
@@ -33,6 +35,12 @@ public:
     EGLContext getEGLContext() const { return m_ctx; }
     bool isGL2() const { return m_isGL2; }
 
+    // client side arrays data sent for this context
+    GLDecoderContextData &decoderContextData() { return m_contextData; }
+
+    // the state of this context that StateFilter tracks
+    GLStateShadow &stateShadow() { return m_stateShadow; }
+
 private:
     RenderContext();
 
@@ -40,6 +48,8 @@ private:
     EGLContext m_ctx;
     int        m_config;
     bool       m_isGL2;
+    GLDecoderContextData m_contextData;
+    GLStateShadow m_stateShadow;
 };
 
 #endif
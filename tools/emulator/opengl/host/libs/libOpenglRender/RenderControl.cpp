@@ -17,14 +17,41 @@
 #include "FrameBuffer.h"
 #include "FBConfig.h"
 #include "EGLDispatch.h"
+#include "ThreadInfo.h"
+#include "RenderChannel.h"
 
-static const GLint rendererVersion = 1;
+static const GLint rendererVersion = RENDERER_VERSION_WITH_CAPS;
 
 static GLint rcGetRendererVersion()
 {
     return rendererVersion;
 }
 
+static uint32_t rcGetRendererCaps()
+{
+    return RENDERER_CAP_COMPRESSED_PAYLOAD |
+           RENDERER_CAP_OPCODE_STATS |
+           RENDERER_CAP_ASYNC_CREATE |
+           RENDERER_CAP_COMPACT_HEADER |
+           RENDERER_CAP_INTERLEAVED_ARRAYS |
+           RENDERER_CAP_PROGRAM_INFO |
+           RENDERER_CAP_REPLY_STATUS;
+}
+
+static EGLint rcGetOpcodeStats(uint32_t opcode, uint32_t count,
+                               void *buffer, uint32_t bufferSize)
+{
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!channel) {
+        return -1;
+    }
+
+    if (count > bufferSize / sizeof(OpcodeStats)) {
+        count = bufferSize / sizeof(OpcodeStats);
+    }
+    return channel->copyOpcodeStats(opcode, count, buffer);
+}
+
 static EGLint rcGetEGLVersion(EGLint* major, EGLint* minor)
 {
     FrameBuffer *fb = FrameBuffer::getFB();
@@ -170,6 +197,119 @@ static uint32_t rcCreateColorBuffer(uint32_t width,
     return fb->createColorBuffer(width, height, internalFormat);
 }
 
+static uint32_t rcReserveHandles(uint32_t count)
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!fb || !channel || count == 0 || count > RC_MAX_RESERVED_HANDLES) {
+        return 0;
+    }
+
+    HandleType first = fb->reserveHandles(count);
+    if (first) {
+        channel->addReservedHandles(first, count);
+    }
+    return first;
+}
+
+//
+// The asynchronous creation calls have no reply, a failure is recorded
+// on the connection for rcGetAsyncError. Other connections that use the
+// handle first wait until it is released here.
+//
+static void rcCreateContextAsync(uint32_t handle, uint32_t config,
+                                 uint32_t share, uint32_t glVersion)
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!fb || !channel) {
+        return;
+    }
+
+    if (!channel->claimReservedHandle(handle)) {
+        channel->setAsyncError(handle);
+        return;
+    }
+    if (!fb->createRenderContext(config, share, glVersion == 2, handle)) {
+        channel->setAsyncError(handle);
+    }
+    fb->releaseHandles(handle, 1);
+}
+
+static void rcCreateWindowSurfaceAsync(uint32_t handle, uint32_t config,
+                                       uint32_t width, uint32_t height)
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!fb || !channel) {
+        return;
+    }
+
+    if (!channel->claimReservedHandle(handle)) {
+        channel->setAsyncError(handle);
+        return;
+    }
+    if (!fb->createWindowSurface(config, width, height, handle)) {
+        channel->setAsyncError(handle);
+    }
+    fb->releaseHandles(handle, 1);
+}
+
+static void rcCreateColorBufferAsync(uint32_t handle, uint32_t width,
+                                     uint32_t height, GLenum internalFormat)
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!fb || !channel) {
+        return;
+    }
+
+    if (!channel->claimReservedHandle(handle)) {
+        channel->setAsyncError(handle);
+        return;
+    }
+    if (!fb->createColorBuffer(width, height, internalFormat, handle)) {
+        channel->setAsyncError(handle);
+    }
+    fb->releaseHandles(handle, 1);
+}
+
+static uint32_t rcGetAsyncError()
+{
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!channel) {
+        return 0;
+    }
+    return channel->takeAsyncError();
+}
+
+//
+// The new format applies from the packet following this one; the reply
+// tells the guest it may start using it.
+//
+static EGLint rcSetPacketFormat(uint32_t format)
+{
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!channel || !channel->setPacketFormat(format)) {
+        return EGL_FALSE;
+    }
+    return EGL_TRUE;
+}
+
+//
+// Like rcSetPacketFormat, the reply to this call is the last one without
+// a status word.
+//
+static EGLint rcSetReplyStatus(uint32_t enable)
+{
+    RenderChannel *channel = getRenderThreadInfo()->channel;
+    if (!channel) {
+        return EGL_FALSE;
+    }
+    channel->setReplyStatus(enable != 0);
+    return EGL_TRUE;
+}
+
 static void rcDestroyColorBuffer(uint32_t colorbuffer)
 {
     FrameBuffer *fb = FrameBuffer::getFB();
@@ -199,6 +339,16 @@ static EGLint rcMakeCurrent(uint32_t context,
 
     bool ret = fb->bindContext(context, drawSurf, readSurf);
 
+    //
+    // let the decoders of the connection store client side arrays
+    // data into the bound context
+    //
+    RenderThreadInfo *tInfo = getRenderThreadInfo();
+    if (ret && tInfo->channel) {
+        RenderContext *ctx = tInfo->currContext.Ptr();
+        tInfo->channel->setDecoderContextData(ctx ? &ctx->decoderContextData() : NULL);
+    }
+
     return (ret ? EGL_TRUE : EGL_FALSE);
 }
 
@@ -248,6 +398,8 @@ static void rcUpdateColorBuffer(uint32_t colorBuffer,
 void initRenderControlContext(renderControl_decoder_context_t *dec)
 {
     dec->set_rcGetRendererVersion(rcGetRendererVersion);
+    dec->set_rcGetRendererCaps(rcGetRendererCaps);
+    dec->set_rcGetOpcodeStats(rcGetOpcodeStats);
     dec->set_rcGetEGLVersion(rcGetEGLVersion);
     dec->set_rcQueryEGLString(rcQueryEGLString);
     dec->set_rcGetNumConfigs(rcGetNumConfigs);
@@ -267,4 +419,11 @@ void initRenderControlContext(renderControl_decoder_context_t *dec)
     dec->set_rcColorBufferCacheFlush(rcColorBufferCacheFlush);
     dec->set_rcReadColorBuffer(rcReadColorBuffer);
     dec->set_rcUpdateColorBuffer(rcUpdateColorBuffer);
+    dec->set_rcReserveHandles(rcReserveHandles);
+    dec->set_rcCreateContextAsync(rcCreateContextAsync);
+    dec->set_rcCreateWindowSurfaceAsync(rcCreateWindowSurfaceAsync);
+    dec->set_rcCreateColorBufferAsync(rcCreateColorBufferAsync);
+    dec->set_rcGetAsyncError(rcGetAsyncError);
+    dec->set_rcSetPacketFormat(rcSetPacketFormat);
+    dec->set_rcSetReplyStatus(rcSetReplyStatus);
 }
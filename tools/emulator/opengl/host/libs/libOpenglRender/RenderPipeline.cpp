@@ -0,0 +1,173 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "RenderPipeline.h"
+#include "ThreadInfo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIPELINE_VAR "ANDROID_GL_PIPELINE"
+
+// queue depth between the two stages
+#define RENDER_PIPELINE_MAX_BATCHES 8
+
+// size of a batch, larger ones are allocated for big packets and are
+// not recycled
+#define RENDER_PIPELINE_BATCH_SIZE 256*1024
+
+RenderPipeline::RenderPipeline(RenderChannel *channel) :
+    osUtils::Thread(),
+    m_channel(channel),
+    m_inputDone(false)
+{
+}
+
+RenderPipeline::~RenderPipeline()
+{
+    for (size_t i = 0; i < m_queue.size(); i++) {
+        delete [] m_queue[i]->data;
+        delete m_queue[i];
+    }
+    for (size_t i = 0; i < m_free.size(); i++) {
+        delete [] m_free[i]->data;
+        delete m_free[i];
+    }
+}
+
+bool RenderPipeline::enabled()
+{
+    const char *val = getenv(PIPELINE_VAR);
+    return val && !strcmp(val, "1");
+}
+
+bool RenderPipeline::run()
+{
+    if (!start()) {
+        return false;
+    }
+
+    while (m_channel->receive() > 0) {
+        ReadBuffer *readBuf = m_channel->readBuffer();
+        bool reply;
+        size_t len;
+        while ((len = m_channel->stage(&reply)) > 0) {
+            submit(readBuf->buf(), len, reply);
+            readBuf->consume(len);
+        }
+        if (m_channel->failed()) {
+            fprintf(stderr, "invalid command stream, closing connection\n");
+            break;
+        }
+    }
+
+    m_lock.lock();
+    m_inputDone = true;
+    m_workCond.signal();
+    m_lock.unlock();
+
+    int status;
+    wait(&status);
+    return true;
+}
+
+//
+// submit - queues staged packets. They are appended to the last queued
+// batch if the executor has not taken it yet and it has room, so the
+// executor picks up everything that arrived while it was busy at once.
+//
+void RenderPipeline::submit(const unsigned char *data, size_t size, bool reply)
+{
+    android::Mutex::Autolock lock(m_lock);
+
+    Batch *batch = m_queue.empty() ? NULL : m_queue.back();
+    if (!batch || batch->sealed || batch->capacity - batch->size < size) {
+        while (m_queue.size() >= RENDER_PIPELINE_MAX_BATCHES) {
+            m_spaceCond.wait(m_lock);
+        }
+        batch = allocBatch(size);
+        m_queue.push_back(batch);
+        m_workCond.signal();
+    }
+
+    memcpy(batch->data + batch->size, data, size);
+    batch->size += size;
+    batch->sealed = reply;
+}
+
+RenderPipeline::Batch *RenderPipeline::allocBatch(size_t size)
+{
+    if (size <= RENDER_PIPELINE_BATCH_SIZE && !m_free.empty()) {
+        Batch *batch = m_free.back();
+        m_free.pop_back();
+        return batch;
+    }
+
+    Batch *batch = new Batch;
+    batch->capacity = size > RENDER_PIPELINE_BATCH_SIZE ? size : RENDER_PIPELINE_BATCH_SIZE;
+    batch->data = new unsigned char[batch->capacity];
+    batch->size = 0;
+    batch->sealed = false;
+    return batch;
+}
+
+void RenderPipeline::releaseBatch(Batch *batch)
+{
+    if (batch->capacity > RENDER_PIPELINE_BATCH_SIZE ||
+        m_free.size() >= RENDER_PIPELINE_MAX_BATCHES) {
+        delete [] batch->data;
+        delete batch;
+        return;
+    }
+    batch->size = 0;
+    batch->sealed = false;
+    m_free.push_back(batch);
+}
+
+//
+// Main - the executor
+//
+int RenderPipeline::Main()
+{
+#ifdef __linux__
+    setRenderThreadInfo(m_channel->threadInfo());
+#else
+    getRenderThreadInfo()->channel = m_channel;
+#endif
+
+    m_lock.lock();
+    for (;;) {
+        while (m_queue.empty() && !m_inputDone) {
+            m_workCond.wait(m_lock);
+        }
+        if (m_queue.empty()) {
+            break;
+        }
+
+        Batch *batch = m_queue.front();
+        m_queue.pop_front();
+        m_spaceCond.signal();
+        m_lock.unlock();
+
+        m_channel->execute(batch->data, batch->size);
+
+        m_lock.lock();
+        releaseBatch(batch);
+    }
+    m_lock.unlock();
+
+    m_channel->unbind();
+    return 0;
+}
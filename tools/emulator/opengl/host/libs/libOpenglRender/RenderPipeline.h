@@ -0,0 +1,74 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIB_OPENGL_RENDER_RENDER_PIPELINE_H
+#define _LIB_OPENGL_RENDER_RENDER_PIPELINE_H
+
+#include "RenderChannel.h"
+#include "osThread.h"
+#include <utils/threads.h>
+#include <deque>
+#include <vector>
+
+//
+// RenderPipeline - serves a connection with two threads. The calling
+// thread reads the stream and stages the complete packets into batches,
+// while the executor thread, which owns the connection's GL context,
+// decodes and runs them, so transport and GL execution overlap. At most
+// RENDER_PIPELINE_MAX_BATCHES batches are queued. A batch ends after any
+// call that sends a reply: the client waits for it, so it is handed to
+// the executor at once. Replies are written by the executor.
+//
+// The stream is read and written from different threads, which only
+// socket streams support. Enabled with ANDROID_GL_PIPELINE=1.
+//
+class RenderPipeline : public osUtils::Thread
+{
+public:
+    explicit RenderPipeline(RenderChannel *channel);
+    ~RenderPipeline();
+
+    static bool enabled();
+
+    // reads and stages packets until the client goes away, then waits
+    // for the executor to run what is left. Returns false if the executor
+    // thread could not be started, nothing was read then.
+    bool run();
+
+private:
+    struct Batch
+    {
+        unsigned char *data;
+        size_t size;
+        size_t capacity;
+        bool sealed;        // ends with a call that sends a reply
+    };
+
+    virtual int Main();
+    void submit(const unsigned char *data, size_t size, bool reply);
+    Batch *allocBatch(size_t size);
+    void releaseBatch(Batch *batch);
+
+private:
+    RenderChannel *m_channel;
+    android::Mutex m_lock;
+    android::Condition m_workCond;      // signaled when a batch is queued
+    android::Condition m_spaceCond;     // signaled when a batch is taken
+    std::deque<Batch *> m_queue;        // protected by m_lock
+    std::vector<Batch *> m_free;        // protected by m_lock
+    bool m_inputDone;                   // protected by m_lock
+};
+
+#endif
@@ -14,58 +14,302 @@
 * limitations under the License.
 */
 #include "RenderServer.h"
+#include "RenderPipeline.h"
 #include "TcpStream.h"
-#include "RenderThread.h"
+#include "ErrorLog.h"
+#ifdef __linux__
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+// upper bound of the render worker pool, the pool is sized to the
+// number of online cpus below that.
+#define RENDER_SERVER_MAX_WORKERS 8
 
 RenderServer::RenderServer() :
     m_listenSock(NULL),
+#ifdef __linux__
+    m_listenShm(NULL),
+    m_epoll(-1),
+    m_exitEvent(-1),
+#endif
+    m_pipelined(false),
     m_exit(false)
 {
 }
 
-RenderServer *RenderServer::create(int port)
+RenderServer::~RenderServer()
+{
+#ifdef __linux__
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        delete m_workers[i];
+    }
+    if (m_exitEvent >= 0) {
+        ::close(m_exitEvent);
+    }
+    if (m_epoll >= 0) {
+        ::close(m_epoll);
+    }
+    delete m_listenShm;
+#endif
+    // threads still serving a client are left running
+    reapThreads();
+    delete m_listenSock;
+}
+
+RenderServer *RenderServer::create(int port, RenderStreamType streamType)
 {
     RenderServer *server = new RenderServer();
     if (!server) {
         return NULL;
     }
 
-    server->m_listenSock = new TcpStream();
-    if (server->m_listenSock->listen(port) < 0) {
+    int listenFd = -1;
+    if (streamType == RENDER_STREAM_SHM) {
+#ifdef __linux__
+        server->m_listenShm = new ShmStream();
+        if (server->m_listenShm->listen(port) < 0) {
+            delete server;
+            return NULL;
+        }
+        listenFd = server->m_listenShm->socket();
+#else
+        fprintf(stderr,"Shared memory stream is not supported on this platform\n");
+        delete server;
+        return NULL;
+#endif
+    }
+    else {
+        server->m_listenSock = new TcpStream();
+        if (server->m_listenSock->listen(port) < 0) {
+            delete server;
+            return NULL;
+        }
+        listenFd = server->m_listenSock->socket();
+        server->m_pipelined = RenderPipeline::enabled();
+    }
+
+#ifdef __linux__
+    server->m_epoll = epoll_create(2);
+    server->m_exitEvent = eventfd(0, EFD_NONBLOCK);
+    if (server->m_epoll < 0 || server->m_exitEvent < 0) {
+        ERR("RenderServer: failed to create event descriptors: %s\n", strerror(errno));
         delete server;
         return NULL;
     }
 
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    bool ok = epoll_ctl(server->m_epoll, EPOLL_CTL_ADD, listenFd, &ev) == 0;
+    ev.data.fd = server->m_exitEvent;
+    ok = ok && epoll_ctl(server->m_epoll, EPOLL_CTL_ADD, server->m_exitEvent, &ev) == 0;
+    if (!ok) {
+        ERR("RenderServer: epoll_ctl failed: %s\n", strerror(errno));
+        delete server;
+        return NULL;
+    }
+
+    // pipelined connections get their own threads instead
+    if (!server->m_pipelined) {
+        long numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+        if (numWorkers < 1) {
+            numWorkers = 1;
+        }
+        else if (numWorkers > RENDER_SERVER_MAX_WORKERS) {
+            numWorkers = RENDER_SERVER_MAX_WORKERS;
+        }
+        for (long i = 0; i < numWorkers; i++) {
+            RenderWorker *worker = RenderWorker::create();
+            if (!worker) {
+                break;
+            }
+            server->m_workers.push_back(worker);
+        }
+        if (server->m_workers.empty()) {
+            delete server;
+            return NULL;
+        }
+    }
+#endif
+
     return server;
 }
 
+void RenderServer::flagNeedExit()
+{
+    m_exit = true;
+#ifdef __linux__
+    uint64_t one = 1;
+    while (::write(m_exitEvent, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+#endif
+}
+
+IOStream *RenderServer::accept()
+{
+#ifdef __linux__
+    if (m_listenShm) {
+        return m_listenShm->accept();
+    }
+#endif
+    return m_listenSock->accept();
+}
+
+#ifdef __linux__
+
 int RenderServer::Main()
 {
-    while(!m_exit) {
-        TcpStream *stream = m_listenSock->accept();
-        if (!stream) {
-            fprintf(stderr,"Error accepting connection, aborting\n");
+    size_t numStarted = 0;
+    while (numStarted < m_workers.size() && m_workers[numStarted]->start()) {
+        numStarted++;
+    }
+    if (numStarted < m_workers.size()) {
+        fprintf(stderr,"Failed to start RenderWorker\n");
+        for (size_t i = numStarted; i < m_workers.size(); i++) {
+            delete m_workers[i];
+        }
+        m_workers.resize(numStarted);
+    }
+
+    while (!m_exit && (m_pipelined || !m_workers.empty())) {
+        struct epoll_event events[2];
+        int n = epoll_wait(m_epoll, events, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ERR("RenderServer: epoll_wait failed: %s\n", strerror(errno));
             break;
         }
 
-        // check if we have been requested to exit while waiting on accept
+        // check if we have been requested to exit while waiting
         if (m_exit) {
             break;
         }
 
-        RenderThread *rt = RenderThread::create(stream);
-        if (!rt) {
-            fprintf(stderr,"Failed to create RenderThread\n");
-            delete stream;
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == m_exitEvent) {
+                continue;
+            }
+
+            IOStream *stream = accept();
+            if (!stream) {
+                fprintf(stderr,"Error accepting connection, aborting\n");
+                m_exit = true;
+                break;
+            }
+            dispatch(stream);
         }
+    }
+
+    //
+    // close all connections and stop the workers
+    //
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        m_workers[i]->flagNeedExit();
+    }
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        int status;
+        m_workers[i]->wait(&status);
+        delete m_workers[i];
+    }
+    m_workers.clear();
+
+    return 0;
+}
+
+void RenderServer::dispatch(IOStream *stream)
+{
+    if (m_pipelined) {
+        reapThreads();
+        startThread(stream);
+        return;
+    }
+
+    RenderWorker *worker = m_workers[0];
+    int load = worker->numChannels();
+    for (size_t i = 1; i < m_workers.size(); i++) {
+        int n = m_workers[i]->numChannels();
+        if (n < load) {
+            worker = m_workers[i];
+            load = n;
+        }
+    }
+
+    RenderChannel *channel = new RenderChannel(stream);
+    if (m_listenShm) {
+        ShmStream *shm = static_cast<ShmStream *>(stream);
+        worker->addChannel(channel, shm->socket(), shm);
+    }
+    else {
+        TcpStream *tcp = static_cast<TcpStream *>(stream);
+        worker->addChannel(channel, tcp->socket(), NULL);
+    }
+}
 
-        if (!rt->start()) {
-            fprintf(stderr,"Failed to start RenderThread\n");
+#else
+
+int RenderServer::Main()
+{
+    while(!m_exit) {
+        IOStream *stream = accept();
+        if (!stream) {
+            fprintf(stderr,"Error accepting connection, aborting\n");
+            break;
+        }
+
+        // check if we have been requested to exit while waiting on accept
+        if (m_exit) {
             delete stream;
+            break;
         }
 
-        printf("Started new RenderThread\n");
+        reapThreads();
+        startThread(stream);
     }
 
     return 0;
 }
+
+#endif
+
+bool RenderServer::startThread(IOStream *stream)
+{
+    RenderThread *rt = RenderThread::create(stream, m_pipelined);
+    if (!rt) {
+        fprintf(stderr,"Failed to create RenderThread\n");
+        delete stream;
+        return false;
+    }
+
+    if (!rt->start()) {
+        fprintf(stderr,"Failed to start RenderThread\n");
+        delete rt;
+        return false;
+    }
+
+    m_threads.push_back(rt);
+    printf("Started new RenderThread\n");
+    return true;
+}
+
+void RenderServer::reapThreads()
+{
+    std::list<RenderThread *>::iterator it = m_threads.begin();
+    while (it != m_threads.end()) {
+        int status;
+        if ((*it)->trywait(&status)) {
+            (*it)->wait(&status);
+            delete *it;
+            it = m_threads.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
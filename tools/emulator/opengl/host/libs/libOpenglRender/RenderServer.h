@@ -17,21 +17,55 @@
 #define _LIB_OPENGL_RENDER_RENDER_SERVER_H
 
 #include "TcpStream.h"
+#include "RenderThread.h"
+#include <list>
+#ifdef __linux__
+#include "ShmStream.h"
+#include "RenderWorker.h"
+#include <vector>
+#endif
+#include "render_api.h"
 #include "osThread.h"
 
+//
+// RenderServer - accepts guest connections and dispatches them.
+// On linux the server sleeps in epoll on the listening socket, and each
+// new connection is given to the least loaded of a bounded pool of
+// RenderWorker threads, which keeps it for the connection's lifetime.
+// Elsewhere each connection gets its own RenderThread, finished threads
+// are reaped on the next accept. Socket connections are served by
+// pipelined RenderThreads on every platform when RenderPipeline is
+// enabled.
+//
 class RenderServer : public osUtils::Thread
 {
 public:
-    static RenderServer *create(int port);
+    static RenderServer *create(int port,
+                                RenderStreamType streamType = RENDER_STREAM_TCP);
+    ~RenderServer();
     virtual int Main();
 
-    void flagNeedExit() { m_exit = true; }
+    void flagNeedExit();
 
 private:
     RenderServer();
+    IOStream *accept();
+#ifdef __linux__
+    void dispatch(IOStream *stream);
+#endif
+    bool startThread(IOStream *stream);
+    void reapThreads();
 
 private:
     TcpStream *m_listenSock;
+#ifdef __linux__
+    ShmStream *m_listenShm;
+    int m_epoll;
+    int m_exitEvent;
+    std::vector<RenderWorker *> m_workers;
+#endif
+    std::list<RenderThread *> m_threads;
+    bool m_pipelined;
     bool m_exit;
 };
 
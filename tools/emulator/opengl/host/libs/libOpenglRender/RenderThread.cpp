@@ -14,90 +14,52 @@
 * limitations under the License.
 */
 #include "RenderThread.h"
-#include "RenderControl.h"
-#include "ReadBuffer.h"
-#include "TimeUtils.h"
-#include "GLDispatch.h"
-
-#define STREAM_BUFFER_SIZE 4*1024*1024
+#include "RenderPipeline.h"
 
 RenderThread::RenderThread() :
     osUtils::Thread(),
-    m_stream(NULL)
+    m_channel(NULL),
+    m_pipelined(false)
+{
+}
+
+RenderThread::~RenderThread()
 {
+    delete m_channel;
 }
 
-RenderThread *RenderThread::create(IOStream *p_stream)
+RenderThread *RenderThread::create(IOStream *p_stream, bool p_pipelined)
 {
     RenderThread *rt = new RenderThread();
     if (!rt) {
         return NULL;
     }
 
-    rt->m_stream = p_stream;
+    rt->m_channel = new RenderChannel(p_stream);
+    rt->m_pipelined = p_pipelined;
 
     return rt;
 }
 
 int RenderThread::Main()
 {
-    //
-    // initialize decoders
-    //
-    m_glDec.initGL( gl_dispatch_get_proc_func, NULL );
-    initRenderControlContext( &m_rcDec );
-
-    ReadBuffer readBuf(m_stream, STREAM_BUFFER_SIZE);
-
-    int stats_totalBytes = 0;
-    long long stats_t0 = GetCurrentTimeMS();
-
-    while (1) {
-
-        int stat = readBuf.getData();
-        if (stat <= 0) {
-            fprintf(stderr, "client shutdown\n");
-            break;
-        }
-
-        //
-        // log received bandwidth statistics
-        //
-        stats_totalBytes += readBuf.validData();
-        long long dt = GetCurrentTimeMS() - stats_t0;
-        if (dt > 1000) {
-            float dts = (float)dt / 1000.0f;
-            printf("Used Bandwidth %5.3f MB/s\n", ((float)stats_totalBytes / dts) / (1024.0f*1024.0f));
-            stats_totalBytes = 0;
-            stats_t0 = GetCurrentTimeMS();
+    if (m_pipelined) {
+        RenderPipeline pipeline(m_channel);
+        if (pipeline.run()) {
+            return 0;
         }
+        fprintf(stderr, "Failed to start the executor thread, not pipelining\n");
+    }
 
-        bool progress;
-        do {
-            progress = false;
-
-            //
-            // try to process some of the command buffer using the GLES decoder
-            //
-            size_t last = m_glDec.decode(readBuf.buf(), readBuf.validData(), m_stream);
-            if (last > 0) {
-                progress = true;
-                readBuf.consume(last);
-            }
-
-            //
-            // try to process some of the command buffer using the
-            // renderControl decoder
-            //
-            last = m_rcDec.decode(readBuf.buf(), readBuf.validData(), m_stream);
-            if (last > 0) {
-                readBuf.consume(last);
-                progress = true;
-            }
-
-        } while( progress );
+#ifdef __linux__
+    setRenderThreadInfo(m_channel->threadInfo());
+#else
+    getRenderThreadInfo()->channel = m_channel;
+#endif
 
+    while (m_channel->process()) {
     }
 
+    m_channel->unbind();
     return 0;
 }
@@ -17,23 +17,27 @@
 #define _LIB_OPENGL_RENDER_RENDER_THREAD_H
 
 #include "IOStream.h"
-#include "GLDecoder.h"
-#include "renderControl_dec.h"
+#include "RenderChannel.h"
 #include "osThread.h"
 
+//
+// RenderThread - serves a single connection on a dedicated thread,
+// used where the event driven RenderWorker pool is not available and
+// for pipelined connections (see RenderPipeline).
+//
 class RenderThread : public osUtils::Thread
 {
 public:
-    static RenderThread *create(IOStream *p_stream);
+    static RenderThread *create(IOStream *p_stream, bool p_pipelined = false);
+    ~RenderThread();
 
 private:
     RenderThread();
     virtual int Main();
 
 private:
-    IOStream *m_stream;
-    GLDecoder   m_glDec;
-    renderControl_decoder_context_t m_rcDec;
+    RenderChannel *m_channel;
+    bool m_pipelined;
 };
 
 #endif
@@ -0,0 +1,309 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "RenderWorker.h"
+#include "FrameBuffer.h"
+#include "ErrorLog.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define RENDER_WORKER_MAX_EVENTS 32
+
+// number of times a busy shared memory connection is drained before
+// the worker gives its other connections a turn
+#define RENDER_WORKER_SHM_ROUNDS 16
+
+RenderWorker::RenderWorker() :
+    osUtils::Thread(),
+    m_epoll(-1),
+    m_wakeEvent(-1),
+    m_numChannels(0),
+    m_exit(false),
+    m_current(NULL)
+{
+}
+
+RenderWorker::~RenderWorker()
+{
+    for (size_t i = 0; i < m_pending.size(); i++) {
+        delete m_pending[i]->channel;
+        delete m_pending[i];
+    }
+    if (m_wakeEvent >= 0) {
+        ::close(m_wakeEvent);
+    }
+    if (m_epoll >= 0) {
+        ::close(m_epoll);
+    }
+}
+
+RenderWorker *RenderWorker::create()
+{
+    RenderWorker *worker = new RenderWorker();
+    if (!worker) {
+        return NULL;
+    }
+
+    worker->m_epoll = epoll_create(RENDER_WORKER_MAX_EVENTS);
+    worker->m_wakeEvent = eventfd(0, EFD_NONBLOCK);
+    if (worker->m_epoll < 0 || worker->m_wakeEvent < 0) {
+        ERR("RenderWorker: failed to create event descriptors: %s\n", strerror(errno));
+        delete worker;
+        return NULL;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(worker->m_epoll, EPOLL_CTL_ADD, worker->m_wakeEvent, &ev) < 0) {
+        ERR("RenderWorker: epoll_ctl failed: %s\n", strerror(errno));
+        delete worker;
+        return NULL;
+    }
+
+    return worker;
+}
+
+void RenderWorker::addChannel(RenderChannel *channel, int sock, ShmStream *shm)
+{
+    Connection *conn = new Connection();
+    conn->channel = channel;
+    conn->shm = shm;
+    conn->sock = sock;
+    conn->closed = false;
+    conn->data.conn = conn;
+    conn->data.peer = false;
+    conn->peer.conn = conn;
+    conn->peer.peer = true;
+
+    m_lock.lock();
+    m_pending.push_back(conn);
+    m_numChannels++;
+    m_lock.unlock();
+
+    wakeUp();
+}
+
+int RenderWorker::numChannels()
+{
+    android::Mutex::Autolock mutex(m_lock);
+    return m_numChannels;
+}
+
+void RenderWorker::flagNeedExit()
+{
+    m_lock.lock();
+    m_exit = true;
+    m_lock.unlock();
+
+    wakeUp();
+}
+
+void RenderWorker::wakeUp()
+{
+    uint64_t one = 1;
+    while (::write(m_wakeEvent, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+int RenderWorker::Main()
+{
+    struct epoll_event events[RENDER_WORKER_MAX_EVENTS];
+
+    while (1) {
+        m_lock.lock();
+        bool needExit = m_exit;
+        m_lock.unlock();
+        if (needExit) {
+            break;
+        }
+
+        int n = epoll_wait(m_epoll, events, RENDER_WORKER_MAX_EVENTS,
+                           m_ready.empty() ? -1 : 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ERR("RenderWorker: epoll_wait failed: %s\n", strerror(errno));
+            break;
+        }
+
+        //
+        // connections left with data in their ring go first
+        //
+        std::vector<Connection *> ready;
+        ready.swap(m_ready);
+        for (size_t i = 0; i < ready.size(); i++) {
+            if (!ready[i]->closed) {
+                serve(ready[i], false);
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            EventSource *src = (EventSource *)events[i].data.ptr;
+            if (!src) {
+                uint64_t count;
+                while (::read(m_wakeEvent, &count, sizeof(count)) < 0 && errno == EINTR) {
+                }
+                attachPending();
+                continue;
+            }
+            if (!src->conn->closed) {
+                serve(src->conn, src->peer);
+            }
+        }
+
+        //
+        // free the connections that were closed during this round
+        //
+        size_t j = 0;
+        for (size_t i = 0; i < m_conns.size(); i++) {
+            if (m_conns[i]->closed) {
+                delete m_conns[i];
+            } else {
+                m_conns[j++] = m_conns[i];
+            }
+        }
+        m_conns.resize(j);
+
+        j = 0;
+        for (size_t i = 0; i < m_ready.size(); i++) {
+            if (!m_ready[i]->closed) {
+                m_ready[j++] = m_ready[i];
+            }
+        }
+        m_ready.resize(j);
+    }
+
+    for (size_t i = 0; i < m_conns.size(); i++) {
+        if (!m_conns[i]->closed) {
+            close(m_conns[i]);
+        }
+        delete m_conns[i];
+    }
+    m_conns.clear();
+    m_ready.clear();
+
+    return 0;
+}
+
+void RenderWorker::attachPending()
+{
+    std::vector<Connection *> pending;
+    m_lock.lock();
+    pending.swap(m_pending);
+    m_lock.unlock();
+
+    for (size_t i = 0; i < pending.size(); i++) {
+        Connection *conn = pending[i];
+        m_conns.push_back(conn);
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = &conn->data;
+        int fd = conn->shm ? conn->shm->eventFd() : conn->sock;
+        bool ok = epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) == 0;
+        if (ok && conn->shm) {
+            ev.data.ptr = &conn->peer;
+            ok = epoll_ctl(m_epoll, EPOLL_CTL_ADD, conn->sock, &ev) == 0;
+        }
+        if (!ok) {
+            ERR("RenderWorker: epoll_ctl failed: %s\n", strerror(errno));
+            close(conn);
+            continue;
+        }
+
+        // the client may have written before the ring was armed
+        if (conn->shm) {
+            m_ready.push_back(conn);
+        }
+    }
+}
+
+void RenderWorker::serve(Connection *conn, bool peerEvent)
+{
+    activate(conn);
+
+    if (!conn->shm) {
+        // level triggered: whatever is left after one read wakes us up again
+        if (!conn->channel->process()) {
+            close(conn);
+        }
+        return;
+    }
+
+    if (peerEvent) {
+        if (conn->shm->peerClosed()) {
+            close(conn);
+        }
+        return;
+    }
+
+    conn->shm->disarmWait();
+    for (int i = 0; i < RENDER_WORKER_SHM_ROUNDS; i++) {
+        if (conn->shm->armWait()) {
+            return;
+        }
+        if (!conn->channel->process()) {
+            close(conn);
+            return;
+        }
+    }
+
+    // still busy, come back to it once the others had a turn
+    m_ready.push_back(conn);
+}
+
+void RenderWorker::activate(Connection *conn)
+{
+    if (m_current == conn) {
+        return;
+    }
+
+    setRenderThreadInfo(conn->channel->threadInfo());
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (fb) {
+        fb->restoreContext();
+    }
+    m_current = conn;
+}
+
+void RenderWorker::close(Connection *conn)
+{
+    activate(conn);
+    conn->channel->unbind();
+
+    int fd = conn->shm ? conn->shm->eventFd() : conn->sock;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, NULL);
+    if (conn->shm) {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, conn->sock, NULL);
+    }
+
+    delete conn->channel;
+    conn->channel = NULL;
+    conn->closed = true;
+
+    setRenderThreadInfo(NULL);
+    m_current = NULL;
+
+    m_lock.lock();
+    m_numChannels--;
+    m_lock.unlock();
+}
@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIB_OPENGL_RENDER_RENDER_WORKER_H
+#define _LIB_OPENGL_RENDER_RENDER_WORKER_H
+
+#include "RenderChannel.h"
+#include "ShmStream.h"
+#include "osThread.h"
+#include <utils/threads.h>
+#include <vector>
+
+//
+// RenderWorker - a thread serving any number of connections. The worker
+// sleeps in epoll until one of its connections has data, then decodes
+// whatever that connection sent and goes back to sleep, so an idle
+// connection costs no thread. A connection stays on the worker it was
+// given to for its whole life, the worker switches the current GL
+// context and thread info whenever it moves to another connection.
+//
+// Linux only.
+//
+class RenderWorker : public osUtils::Thread
+{
+public:
+    static RenderWorker *create();
+    ~RenderWorker();
+
+    // hands a connection over to the worker. shm is the connection's
+    // stream if it is a shared memory one, NULL for a socket stream
+    // whose descriptor is sock. Can be called from any thread.
+    void addChannel(RenderChannel *channel, int sock, ShmStream *shm);
+    int numChannels();
+
+    // asks the worker to close all its connections and exit
+    void flagNeedExit();
+
+private:
+    struct Connection;
+    struct EventSource
+    {
+        Connection *conn;
+        bool peer;          // the shm rendezvous socket, not the data
+    };
+    struct Connection
+    {
+        RenderChannel *channel;
+        ShmStream *shm;
+        int sock;
+        bool closed;
+        EventSource data;
+        EventSource peer;
+    };
+
+    RenderWorker();
+    virtual int Main();
+    void wakeUp();
+    void attachPending();
+    void serve(Connection *conn, bool peerEvent);
+    void activate(Connection *conn);
+    void close(Connection *conn);
+
+private:
+    int m_epoll;
+    int m_wakeEvent;
+    android::Mutex m_lock;
+    std::vector<Connection *> m_pending;   // protected by m_lock
+    int m_numChannels;                     // protected by m_lock
+    bool m_exit;                           // protected by m_lock
+
+    // the rest is only accessed by the worker thread
+    std::vector<Connection *> m_conns;
+    std::vector<Connection *> m_ready;     // shm connections with data left
+    Connection *m_current;
+};
+
+#endif
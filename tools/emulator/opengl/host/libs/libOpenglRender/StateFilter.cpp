@@ -0,0 +1,230 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "StateFilter.h"
+#include "ThreadInfo.h"
+#include "GLStateShadow.h"
+#include "GLDispatch.h"
+#ifdef WITH_GLES2
+#include "GL2Dispatch.h"
+#include "GL2Decoder.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STATE_FILTER_VAR "ANDROID_GL_STATE_FILTER"
+
+typedef enum {
+    FILTER_OFF,
+    FILTER_ON,
+    FILTER_VERIFY
+} FilterMode;
+
+static FilterMode s_mode = FILTER_ON;
+
+static FilterMode readMode()
+{
+    const char *val = getenv(STATE_FILTER_VAR);
+    if (val && !strcmp(val, "0")) {
+        return FILTER_OFF;
+    }
+    if (val && !strcmp(val, "verify")) {
+        return FILTER_VERIFY;
+    }
+    return FILTER_ON;
+}
+
+static GLStateShadow *currentShadow()
+{
+    RenderContext *ctx = getRenderThreadInfo()->currContext.Ptr();
+    return ctx != NULL ? &ctx->stateShadow() : NULL;
+}
+
+//
+// The filtered calls, for the dispatch table 'gl' of either api. Each
+// one forwards the call unless the shadow of the current context says
+// it would not change anything.
+//
+template <class D, D *gl, bool isGL2>
+class Filter
+{
+public:
+    static void enable(GLenum cap) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->enable(cap, true) && verifyEnabled(shadow, cap)) {
+            return;
+        }
+        gl->glEnable(cap);
+    }
+
+    static void disable(GLenum cap) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->enable(cap, false) && verifyEnabled(shadow, cap)) {
+            return;
+        }
+        gl->glDisable(cap);
+    }
+
+    static void activeTexture(GLenum texture) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->maxTextureUnitsKnown()) {
+            GLint units = 0;
+            gl->glGetIntegerv(shadow->maxTextureUnitsParam(), &units);
+            shadow->setMaxTextureUnits(units);
+        }
+        if (shadow && !shadow->activeTexture(texture) && verify(shadow, GL_ACTIVE_TEXTURE)) {
+            return;
+        }
+        gl->glActiveTexture(texture);
+    }
+
+    static void blendFunc(GLenum src, GLenum dst) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->blendFunc(src, dst) && verifyBlend(shadow)) {
+            return;
+        }
+        gl->glBlendFunc(src, dst);
+    }
+
+    static void blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->blendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha) &&
+            verifyBlend(shadow)) {
+            return;
+        }
+        gl->glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+    }
+
+    static void depthFunc(GLenum func) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->depthFunc(func) && verify(shadow, GL_DEPTH_FUNC)) {
+            return;
+        }
+        gl->glDepthFunc(func);
+    }
+
+    static void depthMask(GLboolean flag) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->depthMask(flag) && verify(shadow, GL_DEPTH_WRITEMASK)) {
+            return;
+        }
+        gl->glDepthMask(flag);
+    }
+
+    static void cullFace(GLenum mode) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->cullFace(mode) && verify(shadow, GL_CULL_FACE_MODE)) {
+            return;
+        }
+        gl->glCullFace(mode);
+    }
+
+    static void frontFace(GLenum mode) {
+        GLStateShadow *shadow = currentShadow();
+        if (shadow && !shadow->frontFace(mode) && verify(shadow, GL_FRONT_FACE)) {
+            return;
+        }
+        gl->glFrontFace(mode);
+    }
+
+private:
+    //
+    // In verify mode, checks that the driver agrees with the shadow about
+    // a value before a call is dropped. Returns false, so that the call
+    // is forwarded, if it does not.
+    //
+    static bool verify(GLStateShadow *shadow, GLenum pname) {
+        if (s_mode != FILTER_VERIFY) {
+            return true;
+        }
+        GLint expected = 0, actual = 0;
+        if (!shadow->getParameter(pname, &expected)) {
+            return true;
+        }
+        gl->glGetIntegerv(pname, &actual);
+        if (actual != expected) {
+            fprintf(stderr, "StateFilter: 0x%x is 0x%x, the filter expected 0x%x\n",
+                    pname, actual, expected);
+            return false;
+        }
+        return true;
+    }
+
+    // GLES 1 has the src and dst values only
+    static bool verifyBlend(GLStateShadow *shadow) {
+        if (!isGL2) {
+            return verify(shadow, GL_BLEND_SRC) && verify(shadow, GL_BLEND_DST);
+        }
+        return verify(shadow, GL_BLEND_SRC_RGB) && verify(shadow, GL_BLEND_DST_RGB) &&
+               verify(shadow, GL_BLEND_SRC_ALPHA) && verify(shadow, GL_BLEND_DST_ALPHA);
+    }
+
+    static bool verifyEnabled(GLStateShadow *shadow, GLenum cap) {
+        if (s_mode != FILTER_VERIFY) {
+            return true;
+        }
+        GLboolean expected;
+        if (!shadow->isEnabled(cap, &expected)) {
+            return true;
+        }
+        GLboolean actual = gl->glIsEnabled(cap) ? GL_TRUE : GL_FALSE;
+        if (actual != expected) {
+            fprintf(stderr, "StateFilter: capability 0x%x is %s, the filter expected %s\n",
+                    cap, actual ? "enabled" : "disabled", expected ? "enabled" : "disabled");
+            return false;
+        }
+        return true;
+    }
+};
+
+void StateFilter::install(GLDecoder *dec)
+{
+    s_mode = readMode();
+    if (s_mode == FILTER_OFF) {
+        return;
+    }
+
+    typedef Filter<GLDispatch, &s_gl, false> GLFilter;
+    dec->set_glEnable(GLFilter::enable);
+    dec->set_glDisable(GLFilter::disable);
+    dec->set_glActiveTexture(GLFilter::activeTexture);
+    dec->set_glBlendFunc(GLFilter::blendFunc);
+    dec->set_glDepthFunc(GLFilter::depthFunc);
+    dec->set_glDepthMask(GLFilter::depthMask);
+    dec->set_glCullFace(GLFilter::cullFace);
+    dec->set_glFrontFace(GLFilter::frontFace);
+}
+
+#ifdef WITH_GLES2
+void StateFilter::install(GL2Decoder *dec)
+{
+    s_mode = readMode();
+    if (s_mode == FILTER_OFF) {
+        return;
+    }
+
+    typedef Filter<gl2_decoder_context_t, &s_gl2, true> GL2Filter;
+    dec->set_glEnable(GL2Filter::enable);
+    dec->set_glDisable(GL2Filter::disable);
+    dec->set_glActiveTexture(GL2Filter::activeTexture);
+    dec->set_glBlendFunc(GL2Filter::blendFunc);
+    dec->set_glBlendFuncSeparate(GL2Filter::blendFuncSeparate);
+    dec->set_glDepthFunc(GL2Filter::depthFunc);
+    dec->set_glDepthMask(GL2Filter::depthMask);
+    dec->set_glCullFace(GL2Filter::cullFace);
+    dec->set_glFrontFace(GL2Filter::frontFace);
+}
+#endif
@@ -0,0 +1,51 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIB_OPENGL_RENDER_STATE_FILTER_H
+#define _LIB_OPENGL_RENDER_STATE_FILTER_H
+
+#include "GLDecoder.h"
+
+class GL2Decoder;
+
+//
+// StateFilter - sits between the decoders and the GL dispatch tables and
+// drops the state calls that would not change the state of the current
+// context: capabilities, the active texture, the blend functions, and
+// the depth and face settings. The values are kept in the GLStateShadow
+// of each RenderContext. Texture bindings, the current program and
+// texture parameters are always forwarded: they name objects that
+// contexts can share, so another context can delete, recreate or link
+// them and make a call that the shadow thinks redundant necessary.
+// Calls with a capability or enum value the api of the context does not
+// accept are forwarded too, so that the driver raises the error each
+// time.
+//
+// ANDROID_GL_STATE_FILTER selects the mode: "0" forwards every call,
+// "verify" checks each dropped call against glGet*() and reports (and
+// forwards) those that the driver state disagrees with. The filter is
+// on otherwise.
+//
+class StateFilter
+{
+public:
+    // replaces the state calls of the decoder with filtered ones
+    static void install(GLDecoder *dec);
+#ifdef WITH_GLES2
+    static void install(GL2Decoder *dec);
+#endif
+};
+
+#endif
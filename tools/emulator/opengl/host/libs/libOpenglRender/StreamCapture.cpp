@@ -0,0 +1,155 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "StreamCapture.h"
+#include "TimeUtils.h"
+#include <stdlib.h>
+
+#define CAPTURE_FILE_VAR "ANDROID_GL_CAPTURE_FILE"
+
+// data records are flushed to the file at most that often
+#define CAPTURE_FLUSH_INTERVAL_MS 1000
+
+static android::Mutex s_captureLock;
+static StreamCapture *s_capture = NULL;
+static bool s_captureChecked = false;
+
+StreamCapture::StreamCapture(FILE *fp) :
+    m_fp(fp)
+{
+    m_startTime = GetCurrentTimeUS();
+    m_lastFlush = GetCurrentTimeMS();
+}
+
+StreamCapture *StreamCapture::get()
+{
+    android::Mutex::Autolock mutex(s_captureLock);
+
+    if (!s_captureChecked) {
+        s_captureChecked = true;
+
+        const char *fileName = getenv(CAPTURE_FILE_VAR);
+        if (!fileName) {
+            return NULL;
+        }
+
+        FILE *fp = fopen(fileName, "wb");
+        if (!fp) {
+            fprintf(stderr, "Failed to open capture file %s\n", fileName);
+            return NULL;
+        }
+
+        CaptureFileHeader header;
+        header.magic = CAPTURE_FILE_MAGIC;
+        header.version = CAPTURE_FILE_VERSION;
+        if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+            fprintf(stderr, "Failed to write capture file %s\n", fileName);
+            fclose(fp);
+            return NULL;
+        }
+
+        s_capture = new StreamCapture(fp);
+    }
+
+    return s_capture;
+}
+
+void StreamCapture::record(int connection, CaptureRecordType type,
+                           const void *data, size_t size)
+{
+    android::Mutex::Autolock mutex(m_lock);
+
+    CaptureRecordHeader header;
+    header.timeUS = GetCurrentTimeUS() - m_startTime;
+    header.connection = connection;
+    header.type = type;
+    header.size = size;
+    header.reserved = 0;
+
+    fwrite(&header, sizeof(header), 1, m_fp);
+    if (size > 0) {
+        fwrite(data, size, 1, m_fp);
+    }
+
+    long long now = GetCurrentTimeMS();
+    if (type != CAPTURE_DATA || now - m_lastFlush > CAPTURE_FLUSH_INTERVAL_MS) {
+        fflush(m_fp);
+        m_lastFlush = now;
+    }
+}
+
+CaptureReader::CaptureReader() :
+    m_fp(NULL),
+    m_buf(NULL),
+    m_bufSize(0)
+{
+}
+
+CaptureReader::~CaptureReader()
+{
+    if (m_fp) {
+        fclose(m_fp);
+    }
+    free(m_buf);
+}
+
+bool CaptureReader::open(const char *fileName)
+{
+    m_fp = fopen(fileName, "rb");
+    if (!m_fp) {
+        fprintf(stderr, "Failed to open capture file %s\n", fileName);
+        return false;
+    }
+
+    CaptureFileHeader header;
+    if (fread(&header, sizeof(header), 1, m_fp) != 1 ||
+        header.magic != CAPTURE_FILE_MAGIC) {
+        fprintf(stderr, "%s is not a capture file\n", fileName);
+        return false;
+    }
+    if (header.version != CAPTURE_FILE_VERSION) {
+        fprintf(stderr, "%s: unsupported capture version %u\n",
+                fileName, header.version);
+        return false;
+    }
+
+    return true;
+}
+
+bool CaptureReader::next(CaptureRecordHeader *header, const unsigned char **data)
+{
+    if (!m_fp || fread(header, sizeof(*header), 1, m_fp) != 1) {
+        return false;
+    }
+
+    if (header->size > m_bufSize) {
+        unsigned char *buf = (unsigned char *)realloc(m_buf, header->size);
+        if (!buf) {
+            fprintf(stderr, "Failed to allocate %u bytes for a capture record\n",
+                    header->size);
+            return false;
+        }
+        m_buf = buf;
+        m_bufSize = header->size;
+    }
+
+    if (header->size > 0 && fread(m_buf, header->size, 1, m_fp) != 1) {
+        fprintf(stderr, "Truncated capture record\n");
+        return false;
+    }
+
+    *data = m_buf;
+    return true;
+}
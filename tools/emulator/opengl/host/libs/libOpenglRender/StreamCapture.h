@@ -0,0 +1,93 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIB_OPENGL_RENDER_STREAM_CAPTURE_H
+#define _LIB_OPENGL_RENDER_STREAM_CAPTURE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <utils/threads.h>
+
+//
+// Command stream capture files.
+// The renderer records the raw byte stream received on every connection
+// when ANDROID_GL_CAPTURE_FILE is set to a file name; emulator_replayer
+// feeds such a file back through the decoders without a guest.
+//
+// The file is a CaptureFileHeader followed by records, each made of a
+// CaptureRecordHeader and 'size' bytes of data, in host byte order.
+// Records of all connections are written in the order they were
+// received, timestamps are in microseconds from the capture start.
+//
+#define CAPTURE_FILE_MAGIC   0x50414347   // "GCAP"
+#define CAPTURE_FILE_VERSION 1
+
+typedef enum {
+    CAPTURE_OPEN = 0,       // a connection was accepted, no data
+    CAPTURE_DATA = 1,       // bytes received on the connection
+    CAPTURE_CLOSE = 2       // the connection went away, no data
+} CaptureRecordType;
+
+struct CaptureFileHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct CaptureRecordHeader {
+    uint64_t timeUS;
+    uint32_t connection;
+    uint32_t type;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+class StreamCapture
+{
+public:
+    // returns the capture file of the process, NULL if capture is off
+    static StreamCapture *get();
+
+    void record(int connection, CaptureRecordType type,
+                const void *data, size_t size);
+
+private:
+    StreamCapture(FILE *fp);
+
+private:
+    android::Mutex m_lock;
+    FILE *m_fp;
+    long long m_startTime;
+    long long m_lastFlush;
+};
+
+class CaptureReader
+{
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const char *fileName);
+
+    // reads the next record; *data stays valid until the next call.
+    // Returns false at the end of the file or if it is corrupted.
+    bool next(CaptureRecordHeader *header, const unsigned char **data);
+
+private:
+    FILE *m_fp;
+    unsigned char *m_buf;
+    size_t m_bufSize;
+};
+
+#endif
@@ -27,6 +27,11 @@ RenderThreadInfo *getRenderThreadInfo()
     return tinfo;
 }
 
+void setRenderThreadInfo(RenderThreadInfo *p_tinfo)
+{
+    tinfo = p_tinfo;
+}
+
 #else
 
 #include <cutils/threads.h>
@@ -19,8 +19,13 @@
 #include "RenderContext.h"
 #include "WindowSurface.h"
 
+class RenderChannel;
+
 struct RenderThreadInfo
 {
+    RenderThreadInfo() : channel(NULL) {}
+
+    RenderChannel *channel;     // connection served by the thread
     RenderContextPtr currContext;
     WindowSurfacePtr currDrawSurf;
     WindowSurfacePtr currReadSurf;
@@ -28,4 +33,10 @@ struct RenderThreadInfo
 
 RenderThreadInfo *getRenderThreadInfo();
 
+#ifdef __linux__
+// used by render workers to switch between the connections they serve,
+// the caller keeps ownership of tinfo.
+void setRenderThreadInfo(RenderThreadInfo *tinfo);
+#endif
+
 #endif
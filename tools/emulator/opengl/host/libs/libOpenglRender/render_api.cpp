@@ -22,10 +22,12 @@
 static osUtils::childProcess *s_renderProc = NULL;
 static RenderServer *s_renderThread = NULL;
 static int s_renderPort = 0;
+static RenderStreamType s_streamType = RENDER_STREAM_TCP;
 
 bool initOpenGLRenderer(FBNativeWindowType window,
                         int x, int y, int width, int height,
-                        int portNum)
+                        int portNum,
+                        RenderStreamType streamType)
 {
 
     //
@@ -36,6 +38,7 @@ bool initOpenGLRenderer(FBNativeWindowType window,
     }
 
     s_renderPort = portNum;
+    s_streamType = streamType;
 
 #ifdef RENDER_API_USE_THREAD  // should be defined for mac
     //
@@ -47,7 +50,7 @@ bool initOpenGLRenderer(FBNativeWindowType window,
         return false;
     }
 
-    s_renderThread = RenderServer::create(portNum);
+    s_renderThread = RenderServer::create(portNum, streamType);
     if (!s_renderThread) {
         return false;
     }
@@ -58,9 +61,10 @@ bool initOpenGLRenderer(FBNativeWindowType window,
     //
     // Launch emulator_renderer
     //
-    char cmdLine[128];
-    snprintf(cmdLine, 128, "emulator_renderer -windowid %d -port %d -x %d -y %d -width %d -height %d",
-             (int)window, portNum, x, y, width, height);
+    char cmdLine[160];
+    snprintf(cmdLine, 160, "emulator_renderer -windowid %d -port %d -x %d -y %d -width %d -height %d -stream %s",
+             (int)window, portNum, x, y, width, height,
+             streamType == RENDER_STREAM_SHM ? "shm" : "tcp");
 
     s_renderProc = osUtils::childProcess::create(cmdLine, NULL);
     if (!s_renderProc) {
@@ -121,6 +125,11 @@ bool stopOpenGLRenderer()
         // flag the thread it should exit
         s_renderThread->flagNeedExit();
 
+#ifdef __linux__
+        // the exit request wakes the server up by itself
+        int status;
+        ret = s_renderThread->wait(&status);
+#else
         // open a dummy connection to the renderer to make it 
         // realize the exit request
         IOStream *dummy = createRenderThread(8);
@@ -131,6 +140,7 @@ bool stopOpenGLRenderer()
     
             delete dummy;
         }
+#endif
 
         delete s_renderThread;
         s_renderThread = NULL;
@@ -141,6 +151,22 @@ bool stopOpenGLRenderer()
 
 IOStream *createRenderThread(int p_stream_buffer_size)
 {
+#ifdef __linux__
+    if (s_streamType == RENDER_STREAM_SHM) {
+        ShmStream *stream = new ShmStream(p_stream_buffer_size);
+        if (!stream) {
+            return NULL;
+        }
+
+        if (stream->connect(s_renderPort) < 0) {
+            delete stream;
+            return NULL;
+        }
+
+        return stream;
+    }
+#endif
+
     TcpStream *stream = new TcpStream(p_stream_buffer_size);
     if (!stream) {
         return NULL;
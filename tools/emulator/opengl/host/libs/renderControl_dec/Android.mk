@@ -32,5 +32,9 @@ $(GEN): $(EMUGEN) \
 	$(emulatorOpengl)/system/renderControl_enc/renderControl.types
 	$(transform-generated-source)
 
+ifneq (,$(BUILD_EMULATOR_OPENGL_TRACE))
+LOCAL_CFLAGS += -DCODEC_TRACE
+endif
+
 LOCAL_GENERATED_SOURCES += $(GEN)
 include $(BUILD_HOST_SHARED_LIBRARY)
@@ -28,6 +28,7 @@ static void printUsage(const char *progName)
     fprintf(stderr, "    -y <num>               - render subwindow y position\n");
     fprintf(stderr, "    -width <num>           - render subwindow width\n");
     fprintf(stderr, "    -height <num>          - render subwindow height\n");
+    fprintf(stderr, "    -stream <tcp|shm>      - transport to listen on (default tcp)\n");
     exit(-1);
 }
 
@@ -40,6 +41,7 @@ int main(int argc, char *argv[])
     int winHeight = 480;
     FBNativeWindowType windowId = NULL;
     int iWindowId  = 0;
+    RenderStreamType streamType = RENDER_STREAM_TCP;
 
     //
     // Parse command line arguments
@@ -76,6 +78,16 @@ int main(int argc, char *argv[])
                 printUsage(argv[0]);
             }
         }
+        else if (!strncmp(argv[i], "-stream", 7)) {
+            if (++i >= argc) {
+                printUsage(argv[0]);
+            }
+            if (!strcmp(argv[i], "shm")) {
+                streamType = RENDER_STREAM_SHM;
+            } else if (strcmp(argv[i], "tcp")) {
+                printUsage(argv[0]);
+            }
+        }
     }
 
     windowId = (FBNativeWindowType)iWindowId;
@@ -97,7 +109,7 @@ int main(int argc, char *argv[])
     //
     // Create and run a render server listening to the givven port number
     //
-    RenderServer *server = RenderServer::create(portNum);
+    RenderServer *server = RenderServer::create(portNum, streamType);
     if (!server) {
         fprintf(stderr,"Cannot initialize render server\n");
         return -1;
@@ -0,0 +1,43 @@
+LOCAL_PATH:=$(call my-dir)
+
+# capture replay needs to switch the render thread info, linux only
+ifeq ($(HOST_OS),linux)
+# command stream replay tool ###########################
+include $(CLEAR_VARS)
+
+emulatorOpengl := $(LOCAL_PATH)/../..
+
+LOCAL_MODULE := emulator_replayer
+LOCAL_MODULE_TAGS := debug
+
+LOCAL_SRC_FILES := \
+    ReplayStream.cpp \
+    main.cpp
+
+PREBUILT := $(HOST_PREBUILT_TAG)
+SDL_CONFIG ?= prebuilt/$(PREBUILT)/sdl/bin/sdl-config
+SDL_CFLAGS := $(shell $(SDL_CONFIG) --cflags)
+SDL_LDLIBS := $(filter-out %.a %.lib,$(shell $(SDL_CONFIG) --static-libs))
+
+LOCAL_CFLAGS += $(SDL_CFLAGS)
+LOCAL_LDLIBS += $(SDL_LDLIBS)
+
+LOCAL_C_INCLUDES := $(emulatorOpengl)/host/include \
+                    $(emulatorOpengl)/host/include/libOpenglRender \
+                    $(emulatorOpengl)/shared/OpenglOsUtils \
+                    $(emulatorOpengl)/shared/OpenglCodecCommon \
+                    $(emulatorOpengl)/host/libs/libOpenglRender \
+                    $(emulatorOpengl)/host/libs/GLESv1_dec \
+                    $(emulatorOpengl)/system/GLESv1_enc \
+                    $(emulatorOpengl)/system/renderControl_enc \
+                    $(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv1_dec, HOST) \
+                    $(call intermediates-dir-for, SHARED_LIBRARIES, lib_renderControl_dec, HOST)
+
+LOCAL_STATIC_LIBRARIES := libOpenglCodecCommon
+
+LOCAL_SHARED_LIBRARIES := libOpenglRender \
+        libGLESv1_dec \
+        lib_renderControl_dec
+
+include $(BUILD_HOST_EXECUTABLE)
+endif # HOST_OS == linux
@@ -0,0 +1,93 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "ReplayStream.h"
+#include <stdlib.h>
+#include <string.h>
+
+ReplayStream::ReplayStream(size_t bufsize) :
+    IOStream(bufsize),
+    m_bufsize(bufsize),
+    m_buf(NULL),
+    m_data(NULL),
+    m_dataLen(0)
+{
+}
+
+ReplayStream::~ReplayStream()
+{
+    free(m_buf);
+}
+
+void ReplayStream::feed(const unsigned char *data, size_t len)
+{
+    m_data = data;
+    m_dataLen = len;
+}
+
+void *ReplayStream::allocBuffer(size_t minSize)
+{
+    size_t allocSize = (m_bufsize < minSize ? minSize : m_bufsize);
+    if (!m_buf) {
+        m_buf = (unsigned char *)malloc(allocSize);
+    }
+    else if (m_bufsize < allocSize) {
+        unsigned char *p = (unsigned char *)realloc(m_buf, allocSize);
+        if (p != NULL) {
+            m_buf = p;
+            m_bufsize = allocSize;
+        } else {
+            free(m_buf);
+            m_buf = NULL;
+            m_bufsize = 0;
+        }
+    }
+
+    return m_buf;
+}
+
+int ReplayStream::commitBuffer(size_t size)
+{
+    return 0;
+}
+
+int ReplayStream::commitBufferv(const Segment *segments, int count)
+{
+    return 0;
+}
+
+const unsigned char *ReplayStream::readFully(void *buf, size_t len)
+{
+    if (len > m_dataLen) {
+        return NULL;
+    }
+    size_t n = len;
+    return read(buf, &n);
+}
+
+const unsigned char *ReplayStream::read(void *buf, size_t *inout_len)
+{
+    if (!m_dataLen) {
+        return NULL;
+    }
+
+    size_t n = (*inout_len < m_dataLen ? *inout_len : m_dataLen);
+    memcpy(buf, m_data, n);
+    m_data += n;
+    m_dataLen -= n;
+
+    *inout_len = n;
+    return (const unsigned char *)buf;
+}
@@ -0,0 +1,49 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _REPLAY_STREAM_H
+#define _REPLAY_STREAM_H
+
+#include "IOStream.h"
+
+//
+// ReplayStream - IOStream standing in for a guest connection when
+// replaying a capture: reads return the data fed from the capture file,
+// anything the decoders send back is dropped.
+//
+class ReplayStream : public IOStream {
+public:
+    explicit ReplayStream(size_t bufsize = 10000);
+    ~ReplayStream();
+
+    // makes data available to read(), it must stay valid until
+    // pending() returns 0.
+    void feed(const unsigned char *data, size_t len);
+    size_t pending() const { return m_dataLen; }
+
+    virtual void *allocBuffer(size_t minSize);
+    virtual int commitBuffer(size_t size);
+    virtual int commitBufferv(const Segment *segments, int count);
+    virtual const unsigned char *readFully( void *buf, size_t len);
+    virtual const unsigned char *read( void *buf, size_t *inout_len);
+
+private:
+    size_t m_bufsize;
+    unsigned char *m_buf;
+    const unsigned char *m_data;
+    size_t m_dataLen;
+};
+
+#endif
@@ -0,0 +1,210 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#undef HAVE_MALLOC_H
+#include <SDL.h>
+#include <SDL_syswm.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <map>
+#include "FrameBuffer.h"
+#include "RenderChannel.h"
+#include "StreamCapture.h"
+#include "ThreadInfo.h"
+#include "TimeUtils.h"
+#include "ReplayStream.h"
+
+//
+// emulator_replayer - feeds a command stream capture recorded by the
+// renderer (see StreamCapture.h) through the decoders into a
+// FrameBuffer, without a guest. All the captured connections are
+// replayed on one thread in the order their data was received, the
+// GL context is switched whenever the replay moves to another
+// connection.
+//
+
+struct ReplayConnection
+{
+    ReplayStream *stream;
+    RenderChannel *channel;
+};
+
+typedef std::map<uint32_t, ReplayConnection> ReplayConnectionMap;
+
+static ReplayConnection *s_current = NULL;
+
+static void printUsage(const char *progName)
+{
+    fprintf(stderr, "Usage: %s [options] <capture file>\n", progName);
+    fprintf(stderr, "    -width <num>           - render window width\n");
+    fprintf(stderr, "    -height <num>          - render window height\n");
+    fprintf(stderr, "    -realtime              - replay at the captured pace instead of\n");
+    fprintf(stderr, "                             as fast as possible\n");
+    fprintf(stderr, "Set ANDROID_GL_STATS_FILE to get the per opcode statistics of the replay.\n");
+    exit(-1);
+}
+
+static void activate(ReplayConnection *conn)
+{
+    if (s_current == conn) {
+        return;
+    }
+    setRenderThreadInfo(conn->channel->threadInfo());
+    FrameBuffer::getFB()->restoreContext();
+    s_current = conn;
+}
+
+static void closeConnection(ReplayConnection *conn)
+{
+    activate(conn);
+    conn->channel->unbind();
+    delete conn->channel;   // deletes the stream as well
+    setRenderThreadInfo(NULL);
+    s_current = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int winWidth = 320;
+    int winHeight = 480;
+    bool realtime = false;
+    const char *fileName = NULL;
+
+    //
+    // Parse command line arguments
+    //
+    for (int i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "-width")) {
+            if (++i >= argc || sscanf(argv[i],"%d", &winWidth) != 1) {
+                printUsage(argv[0]);
+            }
+        }
+        else if (!strcmp(argv[i], "-height")) {
+            if (++i >= argc || sscanf(argv[i],"%d", &winHeight) != 1) {
+                printUsage(argv[0]);
+            }
+        }
+        else if (!strcmp(argv[i], "-realtime")) {
+            realtime = true;
+        }
+        else if (argv[i][0] != '-' && !fileName) {
+            fileName = argv[i];
+        }
+        else {
+            printUsage(argv[0]);
+        }
+    }
+
+    if (!fileName) {
+        printUsage(argv[0]);
+    }
+
+    CaptureReader reader;
+    if (!reader.open(fileName)) {
+        return -1;
+    }
+
+    //
+    // Inialize SDL window
+    //
+    if (SDL_Init(SDL_INIT_NOPARACHUTE | SDL_INIT_VIDEO)) {
+        fprintf(stderr,"SDL init failed: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    SDL_Surface *surface = SDL_SetVideoMode(winWidth, winHeight, 32, SDL_SWSURFACE);
+    if (surface == NULL) {
+        fprintf(stderr,"Failed to set video mode: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    SDL_SysWMinfo  wminfo;
+    memset(&wminfo, 0, sizeof(wminfo));
+    SDL_GetWMInfo(&wminfo);
+    FBNativeWindowType windowId = wminfo.info.x11.window;
+
+    //
+    // initialize Framebuffer
+    //
+    bool inited = FrameBuffer::initialize(windowId,
+                                          0, 0, winWidth, winHeight);
+    if (!inited) {
+        fprintf(stderr,"Failed to initialize Framebuffer\n");
+        return -1;
+    }
+
+    //
+    // replay the records
+    //
+    ReplayConnectionMap conns;
+    CaptureRecordHeader rec;
+    const unsigned char *data;
+    unsigned long long totalBytes = 0;
+    unsigned int numRecords = 0;
+    long long t0 = GetCurrentTimeUS();
+
+    while (reader.next(&rec, &data)) {
+        numRecords++;
+
+        if (realtime) {
+            long long wait = t0 + (long long)rec.timeUS - GetCurrentTimeUS();
+            if (wait >= 1000) {
+                TimeSleepMS(wait / 1000);
+            }
+        }
+
+        ReplayConnectionMap::iterator c( conns.find(rec.connection) );
+
+        if (rec.type == CAPTURE_OPEN || c == conns.end()) {
+            if (c != conns.end()) {
+                closeConnection(&(*c).second);
+                conns.erase(c);
+            }
+            ReplayConnection conn;
+            conn.stream = new ReplayStream();
+            conn.channel = new RenderChannel(conn.stream);
+            c = conns.insert(std::make_pair(rec.connection, conn)).first;
+        }
+
+        ReplayConnection *conn = &(*c).second;
+        if (rec.type == CAPTURE_DATA) {
+            activate(conn);
+            conn->stream->feed(data, rec.size);
+            while (conn->stream->pending() > 0) {
+                if (!conn->channel->process()) {
+                    break;
+                }
+            }
+            totalBytes += rec.size;
+        }
+        else if (rec.type == CAPTURE_CLOSE) {
+            closeConnection(conn);
+            conns.erase(c);
+        }
+    }
+
+    for (ReplayConnectionMap::iterator c = conns.begin(); c != conns.end(); c++) {
+        closeConnection(&(*c).second);
+    }
+    conns.clear();
+
+    float dts = (float)(GetCurrentTimeUS() - t0) / 1000000.0f;
+    printf("replayed %u records, %llu bytes in %.3f sec (%.3f MB/s)\n",
+           numRecords, totalBytes, dts,
+           dts > 0 ? ((float)totalBytes / dts) / (1024.0f*1024.0f) : 0.0f);
+
+    return 0;
+}
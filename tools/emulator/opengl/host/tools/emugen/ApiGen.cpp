@@ -214,12 +214,27 @@ int ApiGen::genOpcodes(const std::string &filename)
     for (size_t i = 0; i < size(); i++) {
         fprintf(fp, "#define OP_%s \t\t\t\t\t%u\n", at(i).name().c_str(), (unsigned int)i + m_baseOpcode);
     }
-    fprintf(fp, "#define OP_last \t\t\t\t\t%u\n", (unsigned int)size() + m_baseOpcode);
+    size_t n = size();
+    if (hasBatchable()) {
+        fprintf(fp, "#define OP_%s_repeat \t\t\t\t\t%u\n", m_basename.c_str(), (unsigned int)n + m_baseOpcode);
+        n++;
+    }
+    fprintf(fp, "#define OP_last \t\t\t\t\t%u\n", (unsigned int)n + m_baseOpcode);
     fprintf(fp,"\n\n#endif\n");
     fclose(fp);
     return 0;
 
 }
+bool ApiGen::hasBatchable()
+{
+    for (size_t i = 0; i < size(); i++) {
+        if (at(i).batchable()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int ApiGen::genAttributesTemplate(const std::string &filename )
 {
     FILE *fp = fopen(filename.c_str(), "wt");
@@ -254,6 +269,11 @@ int ApiGen::genEncoderHeader(const std::string &filename)
     fprintf(fp, "#define GUARD_%s\n\n", classname.c_str());
 
     fprintf(fp, "#include \"IOStream.h\"\n");
+    fprintf(fp, "#include \"PayloadCodec.h\"\n");
+    fprintf(fp, "#include \"PacketHeader.h\"\n");
+    fprintf(fp, "#include \"CallBatcher.h\"\n");
+    fprintf(fp, "#include \"ReplyStatus.h\"\n");
+    fprintf(fp, "#include \"CodecTrace.h\"\n");
     fprintf(fp, "#include \"%s_%s_context.h\"\n\n\n", m_basename.c_str(), sideString(CLIENT_SIDE));
 
     for (size_t i = 0; i < m_encoderHeaders.size(); i++) {
@@ -263,7 +283,11 @@ int ApiGen::genEncoderHeader(const std::string &filename)
 
     fprintf(fp, "struct %s : public %s_%s_context_t {\n\n",
             classname.c_str(), m_basename.c_str(), sideString(CLIENT_SIDE));
-    fprintf(fp, "\tIOStream *m_stream;\n\n");
+    fprintf(fp, "\tIOStream *m_stream;\n");
+    fprintf(fp, "\tPayloadCompressor m_compressor;\n");
+    fprintf(fp, "\tint m_packetFormat; // PACKET_FORMAT_*\n");
+    fprintf(fp, "\tCallBatcher m_batcher;\n");
+    fprintf(fp, "\tReplyStatus *m_replyStatus; // set if a status word follows each reply\n\n");
 
     fprintf(fp, "\t%s(IOStream *stream);\n\n", classname.c_str());
     fprintf(fp, "\n};\n\n");
@@ -282,6 +306,139 @@ int ApiGen::genEncoderHeader(const std::string &filename)
     return 0;
 }
 
+// an 'in' buffer copied verbatim into the stream may instead be
+// attached to it by reference when it is large enough.
+static bool isAttachable(Var &var)
+{
+    if (!var.isPointer() || var.packExpression().size() != 0) {
+        return false;
+    }
+    return var.pointerDir() == Var::POINTER_IN || var.pointerDir() == Var::POINTER_INOUT;
+}
+
+// number of 'in' pointers of a single entry that may be sent
+// compressed, must not exceed PAYLOAD_MAX_SLOTS
+#define MAX_COMPRESSED_POINTERS 4
+
+// compressSlot - returns the payload slot used for compressing the data
+// of the j'th parameter of 'e', or -1 if that data is never compressed.
+static int compressSlot(EntryPoint *e, size_t j)
+{
+    VarsArray &evars = e->vars();
+    if (!evars[j].isPointer() || evars[j].pointerDir() != Var::POINTER_IN) {
+        return -1;
+    }
+
+    int slot = 0;
+    for (size_t k = 0; k < j; k++) {
+        if (evars[k].isPointer() && evars[k].pointerDir() == Var::POINTER_IN) {
+            slot++;
+        }
+    }
+    return slot < MAX_COMPRESSED_POINTERS ? slot : -1;
+}
+
+// paramIndex - returns the index of the parameter of 'e' that is not a
+// pointer and whose name is all of 'expression', or -1 if there is none.
+static int paramIndex(EntryPoint *e, const std::string &expression)
+{
+    size_t first = expression.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return -1;
+    }
+    std::string name = expression.substr(first, expression.find_last_not_of(" \t") + 1 - first);
+
+    VarsArray &evars = e->vars();
+    for (size_t k = 0; k < evars.size(); k++) {
+        if (!evars[k].isVoid() && !evars[k].isPointer() && evars[k].name() == name) {
+            return (int)k;
+        }
+    }
+    return -1;
+}
+
+// printWireSize - prints the expression of the number of bytes that the
+// data of parameter j takes in the packet, without its length word for
+// a pointer
+static void printWireSize(FILE *fp, EntryPoint *e, size_t j)
+{
+    Var &var = e->vars()[j];
+    if (var.isPointer()) {
+        Var::PointerDir dir = var.pointerDir();
+        if (compressSlot(e, j) >= 0) {
+            fprintf(fp, "(__wire_%s ? __wire_%s : __size_%s)",
+                    var.name().c_str(), var.name().c_str(), var.name().c_str());
+        } else if (var.nullAllowed() ||
+                   dir == Var::POINTER_IN || dir == Var::POINTER_INOUT) {
+            fprintf(fp, "__size_%s", var.name().c_str());
+        } else {
+            fprintf(fp, "0");
+        }
+    } else {
+        fprintf(fp, "%u", (unsigned int) var.type()->bytes());
+    }
+}
+
+// fixedParamSize - returns true if the parameters of 'e' always take the
+// same size on the wire, which is then stored in *out_size. Only 'out'
+// pointers, that carry just their length, keep the size fixed.
+static bool fixedParamSize(EntryPoint *e, unsigned int *out_size)
+{
+    VarsArray &evars = e->vars();
+    unsigned int size = 0;
+    for (size_t j = 0; j < evars.size(); j++) {
+        if (evars[j].isPointer()) {
+            if (evars[j].pointerDir() != Var::POINTER_OUT || evars[j].nullAllowed()) {
+                return false;
+            }
+            size += 4;
+        } else {
+            size += evars[j].type()->bytes();
+        }
+    }
+    *out_size = size;
+    return true;
+}
+
+// emits the code reading the status word that follows a reply
+static void genReplyStatusRead(FILE *fp)
+{
+    fprintf(fp, "\tif (ctx->m_replyStatus != NULL) ctx->m_replyStatus->read(ctx->m_stream);\n");
+}
+
+// emits the code copying uncompressed 'in' pointer data into the stream
+static void genPointerDataCopy(FILE *fp, Var &var, const char *indent)
+{
+    const char *varname = var.name().c_str();
+
+    if (isAttachable(var)) {
+        fprintf(fp, "%sif (__ref_%s) {\n", indent, varname);
+        fprintf(fp, "%s\tctx->m_stream->attach(ptr, %s, __size_%s);\n",
+                indent, varname, varname);
+        fprintf(fp, "%s} else {\n%s\t", indent, indent);
+        if (var.nullAllowed()) {
+            fprintf(fp, "if (%s != NULL) ", varname);
+        }
+        fprintf(fp, "memcpy(ptr, %s, __size_%s); ptr += __size_%s;\n",
+                varname, varname, varname);
+        fprintf(fp, "%s}\n", indent);
+        return;
+    }
+
+    fprintf(fp, "%s", indent);
+    if (var.nullAllowed()) {
+        fprintf(fp, "if (%s != NULL) ", varname);
+    }
+
+    if (var.packExpression().size() != 0) {
+        fprintf(fp, "%s;", var.packExpression().c_str());
+    } else {
+        fprintf(fp, "memcpy(ptr, %s, __size_%s);", varname, varname);
+    }
+
+    fprintf(fp, "ptr += __size_%s;\n", varname);
+}
+
 int ApiGen::genEncoderImpl(const std::string &filename)
 {
     FILE *fp = fopen(filename.c_str(), "wt");
@@ -294,7 +451,10 @@ int ApiGen::genEncoderImpl(const std::string &filename)
     fprintf(fp, "\n\n#include <string.h>\n");
     fprintf(fp, "#include \"%s_opcodes.h\"\n\n", m_basename.c_str());
     fprintf(fp, "#include \"%s_enc.h\"\n\n\n", m_basename.c_str());
-    fprintf(fp, "#include <stdio.h>\n");
+    fprintf(fp, "#include <stdio.h>\n\n");
+    fprintf(fp, "#if PAYLOAD_MAX_SLOTS < %d\n", MAX_COMPRESSED_POINTERS);
+    fprintf(fp, "#error \"PAYLOAD_MAX_SLOTS is too small for this encoder\"\n");
+    fprintf(fp, "#endif\n\n");
     std::string classname = m_basename + "_encoder_context_t";
     size_t n = size();
 
@@ -311,128 +471,238 @@ int ApiGen::genEncoderImpl(const std::string &filename)
         e->print(fp, true, "_enc", /* classname + "::" */"", "void *self");
         fprintf(fp, "{\n");
 
-        fprintf(fp, "\n\t%s *ctx = (%s *)self;\n\n",
+        fprintf(fp, "\n\t%s *ctx = (%s *)self;\n",
                 classname.c_str(),
                 classname.c_str());
-
-        // size calculation ;
-        fprintf(fp, "\t size_t packetSize = ");
+        fprintf(fp, "\tCODEC_TRACE_BEGIN();\n\n");
 
         VarsArray & evars = e->vars();
         size_t nvars = evars.size();
         size_t npointers = 0;
+
+        // pointer data sizes;
         for (size_t j = 0; j < nvars; j++) {
-            fprintf(fp, "%s ", j == 0 ? "" : " +");
-            if (evars[j].isPointer()) {
-                npointers++;
+            if (!evars[j].isPointer()) continue;
+            npointers++;
 
-                if (evars[j].lenExpression() == "") {
-                    fprintf(stderr, "%s: data len is undefined for '%s'\n",
-                            e->name().c_str(), evars[j].name().c_str());
-                }
+            if (evars[j].lenExpression() == "") {
+                fprintf(stderr, "%s: data len is undefined for '%s'\n",
+                        e->name().c_str(), evars[j].name().c_str());
+            }
 
-                if (evars[j].nullAllowed()) {
-                    fprintf(fp, "(%s != NULL ? %s : 0)",
-                            evars[j].name().c_str(),
-                            evars[j].lenExpression().c_str());
+            if (evars[j].nullAllowed()) {
+                fprintf(fp, "\tconst unsigned int __size_%s = (%s != NULL) ? %s : 0;\n",
+                        evars[j].name().c_str(),
+                        evars[j].name().c_str(),
+                        evars[j].lenExpression().c_str());
+            } else {
+                fprintf(fp, "\tconst unsigned int __size_%s = %s;\n",
+                        evars[j].name().c_str(),
+                        evars[j].lenExpression().c_str());
+            }
+        }
+
+        // compress large 'in' buffers if the renderer accepts it;
+        for (size_t j = 0; j < nvars; j++) {
+            int slot = compressSlot(e, j);
+            if (slot < 0) continue;
+
+            const char *varname = evars[j].name().c_str();
+            if (evars[j].packExpression().size() != 0) {
+                fprintf(fp, "\tunsigned int __wire_%s = 0;\n", varname);
+                fprintf(fp, "\tif (ctx->m_compressor.shouldCompress(__size_%s)) {\n", varname);
+                fprintf(fp, "\t\tunsigned char *__packed = ctx->m_compressor.packBuffer(__size_%s);\n", varname);
+                fprintf(fp, "\t\tunsigned char *ptr = __packed;\n");
+                fprintf(fp, "\t\t%s;\n", evars[j].packExpression().c_str());
+                fprintf(fp, "\t\t__wire_%s = ctx->m_compressor.compress(%d, __packed, __size_%s);\n",
+                        varname, slot, varname);
+                fprintf(fp, "\t}\n");
+            } else {
+                fprintf(fp, "\tconst unsigned int __wire_%s = ctx->m_compressor.shouldCompress(__size_%s) ? "
+                        "ctx->m_compressor.compress(%d, %s, __size_%s) : 0;\n",
+                        varname, varname, slot, varname, varname);
+            }
+        }
+
+        // large 'in' buffers are sent by reference rather than copied
+        // into the stream buffer;
+        bool hasAttach = false;
+        for (size_t j = 0; j < nvars; j++) {
+            if (isAttachable(evars[j])) {
+                if (compressSlot(e, j) >= 0) {
+                    fprintf(fp, "\tconst bool __ref_%s = ctx->m_stream->reserveAttach(__wire_%s ? 0 : __size_%s);\n",
+                            evars[j].name().c_str(), evars[j].name().c_str(), evars[j].name().c_str());
                 } else {
-                    if (evars[j].pointerDir() == Var::POINTER_IN ||
-                        evars[j].pointerDir() == Var::POINTER_INOUT) {
-                        fprintf(fp, "%s", evars[j].lenExpression().c_str());
-                    } else {
-                        fprintf(fp, "0");
-                    }
+                    fprintf(fp, "\tconst bool __ref_%s = ctx->m_stream->reserveAttach(__size_%s);\n",
+                            evars[j].name().c_str(), evars[j].name().c_str());
                 }
-            } else {
-                fprintf(fp, "%u", (unsigned int) evars[j].type()->bytes());
+                hasAttach = true;
+            }
+        }
+        if (npointers > 0) {
+            fprintf(fp, "\n");
+        }
+
+        // size calculation ;
+        fprintf(fp, "\t const size_t paramSize = ");
+
+        for (size_t j = 0; j < nvars; j++) {
+            fprintf(fp, "%s ", j == 0 ? "" : " +");
+            printWireSize(fp, e, j);
+        }
+        fprintf(fp, " %s %u * 4;\n", nvars != 0 ? "+" : "", (unsigned int) npointers);
+
+        // the parameter whose data is aligned in the stream, if any;
+        size_t aligned = nvars;
+        for (size_t j = 0; j < nvars; j++) {
+            if (evars[j].aligned()) {
+                aligned = j;
             }
         }
-        fprintf(fp, " %s 8 + %u * 4;\n", nvars != 0 ? "+" : "", (unsigned int) npointers);
 
-        // allocate buffer from the stream;
-        fprintf(fp, "\t unsigned char *ptr = ctx->m_stream->alloc(packetSize);\n\n");
+        unsigned int fixedSize;
+        const char *fixed = fixedParamSize(e, &fixedSize) ? "true" : "false";
+        if (e->batchable()) {
+            // may be merged with the previous call;
+            fprintf(fp, "\t unsigned char *ptr = ctx->m_batcher.alloc(ctx->m_stream, ctx->m_packetFormat, "
+                    "OP_%s, paramSize);\n\n", e->name().c_str());
+        } else {
+            if (aligned < nvars) {
+                // offset of the data in the parameters
+                fprintf(fp, "\t const size_t headerSize = alignedHeaderSize(ctx->m_packetFormat, paramSize, "
+                        "ctx->m_stream->position(), ");
+                for (size_t j = 0; j < aligned; j++) {
+                    printWireSize(fp, e, j);
+                    fprintf(fp, "%s + ", evars[j].isPointer() ? " + 4" : "");
+                }
+                fprintf(fp, "4);\n");
+            } else {
+                fprintf(fp, "\t const size_t headerSize = packetHeaderSize(ctx->m_packetFormat, %s, paramSize);\n",
+                        fixed);
+            }
 
-        // encode into the stream;
-        fprintf(fp, "\t*(unsigned int *)(ptr) = OP_%s; ptr += 4;\n",  e->name().c_str());
-        fprintf(fp, "\t*(unsigned int *)(ptr) = (unsigned int) packetSize;  ptr += 4;\n\n");
+            // allocate buffer from the stream;
+            fprintf(fp, "\t unsigned char *ptr = ctx->m_stream->alloc(headerSize + paramSize");
+            for (size_t j = 0; j < nvars; j++) {
+                if (isAttachable(evars[j])) {
+                    fprintf(fp, " - (__ref_%s ? __size_%s : 0)",
+                            evars[j].name().c_str(), evars[j].name().c_str());
+                }
+            }
+            fprintf(fp, ");\n\n");
+
+            // encode into the stream;
+            if (aligned < nvars) {
+                fprintf(fp, "\tptr = packAlignedHeader(ptr, ctx->m_packetFormat, OP_%s, paramSize, headerSize);\n\n",
+                        e->name().c_str());
+            } else {
+                fprintf(fp, "\tptr = packPacketHeader(ptr, ctx->m_packetFormat, OP_%s, %s, paramSize);\n\n",
+                        e->name().c_str(), fixed);
+            }
+        }
 
         // out variables
         for (size_t j = 0; j < nvars; j++) {
             if (evars[j].isPointer()) {
+                const char *varname = evars[j].name().c_str();
+
+                int slot = compressSlot(e, j);
+
                 // encode a pointer header
-                if (evars[j].nullAllowed()) {
-                    fprintf(fp, "\t*(unsigned int *)(ptr) = (%s != NULL) ? %s : 0; ptr += 4; \n",
-                            evars[j].name().c_str(), evars[j].lenExpression().c_str());
+                if (slot >= 0) {
+                    fprintf(fp, "\tPack<uint32_t>(ptr, __wire_%s ? (__wire_%s | CODEC_COMPRESSED_PAYLOAD) : __size_%s); ptr += 4; \n",
+                            varname, varname, varname);
                 } else {
-                    fprintf(fp, "\t*(unsigned int *)(ptr) = %s; ptr += 4; \n",
-                            evars[j].lenExpression().c_str());
+                    fprintf(fp, "\tPack<uint32_t>(ptr, __size_%s); ptr += 4; \n", varname);
                 }
 
                 Var::PointerDir dir = evars[j].pointerDir();
-                if (dir == Var::POINTER_INOUT || dir == Var::POINTER_IN) {
-                    if (evars[j].nullAllowed()) {
-                        fprintf(fp, "\tif (%s != NULL) ", evars[j].name().c_str());
-                    } else {
-                        fprintf(fp, "\t");
-                    }
-
-                    if (evars[j].packExpression().size() != 0) {
-                        fprintf(fp, "%s;", evars[j].packExpression().c_str());
-                    } else {
-                        fprintf(fp, "memcpy(ptr, %s, %s);",
-                                evars[j].name().c_str(),
-                                evars[j].lenExpression().c_str());
-                    }
-
-                    if (evars[j].nullAllowed()) {
-                        fprintf(fp, "ptr += %s == NULL ? 0 : %s; \n", evars[j].name().c_str(), evars[j].lenExpression().c_str());
-                    } else {
-                        fprintf(fp, "ptr += %s;\n", evars[j].lenExpression().c_str());
-                    }
+                if (slot >= 0) {
+                    fprintf(fp, "\tif (__wire_%s) {\n", varname);
+                    fprintf(fp, "\t\tmemcpy(ptr, ctx->m_compressor.data(%d), __wire_%s); ptr += __wire_%s;\n",
+                            slot, varname, varname);
+                    fprintf(fp, "\t} else {\n");
+                    genPointerDataCopy(fp, evars[j], "\t\t");
+                    fprintf(fp, "\t}\n");
+                } else if (dir == Var::POINTER_INOUT || dir == Var::POINTER_IN) {
+                    genPointerDataCopy(fp, evars[j], "\t");
                 }
             } else {
                 // encode a non pointer variable
                 if (!evars[j].isVoid()) {
-                    fprintf(fp, "\t*(%s *) (ptr) = %s; ptr += %u;\n",
+                    fprintf(fp, "\tPack<%s>(ptr, %s); ptr += %u;\n",
                             evars[j].type()->name().c_str(), evars[j].name().c_str(),
                             (uint) evars[j].type()->bytes());
                 }
             }
         }
         // in variables;
+        bool hasReadback = false;
         for (size_t j = 0; j < nvars; j++) {
             if (evars[j].isPointer()) {
                 Var::PointerDir dir = evars[j].pointerDir();
                 if (dir == Var::POINTER_INOUT || dir == Var::POINTER_OUT) {
                     if (evars[j].nullAllowed()) {
-                        fprintf(fp, "\tif (%s != NULL) ctx->m_stream->readback(%s, %s);\n",
+                        fprintf(fp, "\tif (%s != NULL) ctx->m_stream->readback(%s, __size_%s);\n",
                                 evars[j].name().c_str(),
                                 evars[j].name().c_str(),
-                                evars[j].lenExpression().c_str());
+                                evars[j].name().c_str());
                     } else {
-                        fprintf(fp, "\tctx->m_stream->readback(%s, %s);\n",
+                        fprintf(fp, "\tctx->m_stream->readback(%s, __size_%s);\n",
                                 evars[j].name().c_str(),
-                                evars[j].lenExpression().c_str());
+                                evars[j].name().c_str());
                     }
+                    hasReadback = true;
                 }
             }
         }
+        if (e->retval().type()->name() != "void" && !e->retval().isPointer()) {
+            hasReadback = true;
+        }
+
+        // attached data is owned by the caller and must be sent before
+        // returning, a readback would flush it anyway.
+        if (hasAttach && !hasReadback) {
+            fprintf(fp, "\tif (");
+            bool first = true;
+            for (size_t j = 0; j < nvars; j++) {
+                if (isAttachable(evars[j])) {
+                    fprintf(fp, "%s__ref_%s", first ? "" : " || ", evars[j].name().c_str());
+                    first = false;
+                }
+            }
+            fprintf(fp, ") ctx->m_stream->flush();\n");
+        }
         // todo - return value for pointers
         if (e->retval().isPointer()) {
             fprintf(stderr, "WARNING: %s : return value of pointer is unsupported\n",
                     e->name().c_str());
+            fprintf(fp, "\tCODEC_TRACE_END(\"enc\", \"%s\", paramSize);\n", e->name().c_str());
             fprintf(fp, "\t return NULL;\n");
         } else if (e->retval().type()->name() != "void") {
             fprintf(fp, "\n\t%s retval;\n", e->retval().type()->name().c_str());
             fprintf(fp, "\tctx->m_stream->readback(&retval, %u);\n",(uint) e->retval().type()->bytes());
+            genReplyStatusRead(fp);
+            fprintf(fp, "\tCODEC_TRACE_END(\"enc\", \"%s\", paramSize);\n", e->name().c_str());
             fprintf(fp, "\treturn retval;\n");
+        } else {
+            if (hasReadback) {
+                genReplyStatusRead(fp);
+            }
+            fprintf(fp, "\tCODEC_TRACE_END(\"enc\", \"%s\", paramSize);\n", e->name().c_str());
         }
         fprintf(fp, "}\n\n");
     }
 
     // constructor
     fprintf(fp, "%s::%s(IOStream *stream)\n{\n", classname.c_str(), classname.c_str());
-    fprintf(fp, "\tm_stream = stream;\n\n");
+    fprintf(fp, "\tm_stream = stream;\n");
+    fprintf(fp, "\tm_packetFormat = PACKET_FORMAT_CLASSIC;\n");
+    fprintf(fp, "\tm_replyStatus = NULL;\n");
+    if (hasBatchable()) {
+        fprintf(fp, "\tm_batcher.setRepeatOpcode(OP_%s_repeat);\n", m_basename.c_str());
+    }
+    fprintf(fp, "\n");
 
     for (size_t i = 0; i < n; i++) {
         EntryPoint *e = &at(i);
@@ -473,6 +743,9 @@ int ApiGen::genDecoderHeader(const std::string &filename)
     fprintf(fp, "#define GUARD_%s\n\n", classname.c_str());
 
     fprintf(fp, "#include \"IOStream.h\" \n");
+    fprintf(fp, "#include \"PayloadCodec.h\"\n");
+    fprintf(fp, "#include \"DecoderStats.h\"\n");
+    fprintf(fp, "#include \"OpcodeDispatcher.h\"\n");
     fprintf(fp, "#include \"%s_%s_context.h\"\n\n\n", m_basename.c_str(), sideString(SERVER_SIDE));
 
     for (size_t i = 0; i < m_decoderHeaders.size(); i++) {
@@ -482,7 +755,11 @@ int ApiGen::genDecoderHeader(const std::string &filename)
 
     fprintf(fp, "struct %s : public %s_%s_context_t {\n\n",
             classname.c_str(), m_basename.c_str(), sideString(SERVER_SIDE));
+    fprintf(fp, "\t%s();\n", classname.c_str());
     fprintf(fp, "\tsize_t decode(void *buf, size_t bufsize, IOStream *stream);\n");
+    fprintf(fp, "\n\tstatic const DecoderInfo s_info;\n");
+    fprintf(fp, "\n\tPayloadDecompressor m_payloads;\n");
+    fprintf(fp, "\tDecoderStats m_stats;\n");
     fprintf(fp, "\n};\n\n");
     fprintf(fp, "#endif");
 
@@ -539,24 +816,16 @@ int ApiGen::genDecoderImpl(const std::string &filename)
 
     fprintf(fp, "\n\n#include <string.h>\n");
     fprintf(fp, "#include \"%s_opcodes.h\"\n\n", m_basename.c_str());
-    fprintf(fp, "#include \"%s_dec.h\"\n\n\n", m_basename.c_str());
+    fprintf(fp, "#include \"%s_dec.h\"\n", m_basename.c_str());
+    fprintf(fp, "#include \"ProtocolUtils.h\"\n");
+    fprintf(fp, "#include \"CodecTrace.h\"\n\n\n");
     fprintf(fp, "#include <stdio.h>\n\n");
+    fprintf(fp, "#if PAYLOAD_MAX_SLOTS < %d\n", MAX_COMPRESSED_POINTERS);
+    fprintf(fp, "#error \"PAYLOAD_MAX_SLOTS is too small for this decoder\"\n");
+    fprintf(fp, "#endif\n\n");
 
-    // decoder switch;
-    fprintf(fp, "size_t %s::decode(void *buf, size_t len, IOStream *stream)\n{\n", classname.c_str());
-    fprintf(fp,
-            "                           \n\
-\tsize_t pos = 0;\n\
-\tif (len < 8) return pos; \n\
-\tunsigned char *ptr = (unsigned char *)buf;\n\
-\tbool unknownOpcode = false;  \n\
-\twhile ((len - pos >= 8) && !unknownOpcode) {   \n\
-\t\tvoid *params[%u]; \n\
-\t\tint opcode = *(int *)ptr;   \n\
-\t\tunsigned int packetLen = *(int *)(ptr + 4);\n\
-\t\tif (len - pos < packetLen)  return pos; \n\
-\t\tswitch(opcode) {\n",
-            (uint) m_maxEntryPointsParams);
+    // one handler function per opcode;
+    std::vector<bool> sendsReply(n, false);
 
     for (size_t f = 0; f < n; f++) {
         enum Pass_t { PASS_TmpBuffAlloc = 0, PASS_MemAlloc, PASS_DebugPrint, PASS_FunctionCall, PASS_Epilog, PASS_LAST };
@@ -571,12 +840,16 @@ int ApiGen::genDecoderImpl(const std::string &filename)
         printString += "";
         // TODO - add for return value;
 
-        fprintf(fp, "\t\t\tcase OP_%s:\n", e->name().c_str());
-        fprintf(fp, "\t\t\t{\n");
+        fprintf(fp, "static bool dec_%s(void *self, unsigned char *ptr, size_t len, IOStream *stream)\n{\n",
+                e->name().c_str());
+        fprintf(fp, "\t\t\t%s *ctx = (%s *)self;\n", classname.c_str(), classname.c_str());
+        fprintf(fp, "\t\t\tCODEC_TRACE_BEGIN();\n");
 
         bool totalTmpBuffExist = false;
         std::string totalTmpBuffOffset = "0";
         std::string *tmpBufOffset = new std::string[e->vars().size()];
+        // offset of each parameter in the packet, set in the first pass;
+        std::string *paramOffset = new std::string[e->vars().size()];
 
         // construct retval type string
         std::string retvalType;
@@ -584,17 +857,23 @@ int ApiGen::genDecoderImpl(const std::string &filename)
             retvalType = e->retval().type()->name();
         }
 
+        // the return value is stored through Pack() since tmpBuf offsets
+        // are not necessarily aligned for its type;
+        bool packRetval = !e->retval().isVoid() && !e->retval().isPointer();
+        // size of the parameters, for the trace;
+        std::string paramBytes = "0";
+
         for (int pass = PASS_TmpBuffAlloc; pass < PASS_LAST; pass++) {
-            if (pass == PASS_FunctionCall && !e->retval().isVoid() && !e->retval().isPointer()) {
-                fprintf(fp, "\t\t\t*(%s *)(&tmpBuf[%s]) = ", retvalType.c_str(),
+            if (pass == PASS_FunctionCall && packRetval) {
+                fprintf(fp, "\t\t\tPack<%s>(&tmpBuf[%s], ", retvalType.c_str(),
                         totalTmpBuffOffset.c_str());
             }
 
 
             if (pass == PASS_FunctionCall) {
-                fprintf(fp, "\t\t\tthis->%s(", e->name().c_str());
+                fprintf(fp, "%sctx->%s(", packRetval ? "" : "\t\t\t", e->name().c_str());
                 if (e->customDecoder()) {
-                    fprintf(fp, "this"); // add a context to the call
+                    fprintf(fp, "ctx"); // add a context to the call
                 }
             } else if (pass == PASS_DebugPrint) {
                 fprintf(fp, "#ifdef DEBUG_PRINTOUT\n");
@@ -602,45 +881,100 @@ int ApiGen::genDecoderImpl(const std::string &filename)
                 if (e->vars().size() > 0 && !e->vars()[0].isVoid()) fprintf(fp, ",");
             }
 
-            std::string varoffset = "8"; // skip the header
+            std::string varoffset = "0"; // ptr points past the header
             VarsArray & evars = e->vars();
             // allocate memory for out pointers;
             for (size_t j = 0; j < evars.size(); j++) {
                 Var *v = & evars[j];
+                if (pass == PASS_TmpBuffAlloc) paramOffset[j] = varoffset;
                 if (!v->isVoid()) {
                     if ((pass == PASS_FunctionCall) && (j != 0 || e->customDecoder())) fprintf(fp, ", ");
                     if (pass == PASS_DebugPrint && j != 0) fprintf(fp, ", ");
 
                     if (!v->isPointer()) {
                         if (pass == PASS_FunctionCall || pass == PASS_DebugPrint) {
-                            fprintf(fp, "*(%s *)(ptr + %s)", v->type()->name().c_str(), varoffset.c_str());
+                            fprintf(fp, "Unpack<%s>(ptr + %s)", v->type()->name().c_str(), varoffset.c_str());
                         }
                         varoffset += " + " + toString(v->type()->bytes());
                     } else {
-                        if (v->pointerDir() == Var::POINTER_IN || v->pointerDir() == Var::POINTER_INOUT) {
+                        int slot = compressSlot(e, j);
+                        if (slot >= 0) {
+                            // in pointer, possibly compressed;
+                            if (pass == PASS_MemAlloc) {
+                                fprintf(fp, "\t\t\tunsigned char *inPtr%u = ptr + %s + 4;\n",
+                                        (uint) j, varoffset.c_str());
+                                fprintf(fp, "\t\t\tif (Unpack<uint32_t>(ptr + %s) & CODEC_COMPRESSED_PAYLOAD) {\n",
+                                        varoffset.c_str());
+                                fprintf(fp, "\t\t\t\tsize_t wireLen%u = Unpack<uint32_t>(ptr + %s) & ~CODEC_COMPRESSED_PAYLOAD;\n",
+                                        (uint) j, varoffset.c_str());
+                                // the compressed data must be in the packet
+                                // and inflate to the length the call gives
+                                // for it, when that is one of its parameters;
+                                fprintf(fp, "\t\t\t\tif ((size_t)(%s) + 4 > len || wireLen%u > len - (%s) - 4) {\n",
+                                        varoffset.c_str(), (uint) j, varoffset.c_str());
+                                fprintf(fp, "\t\t\t\t\tinPtr%u = NULL;\n", (uint) j);
+                                int lenVar = paramIndex(e, v->lenExpression());
+                                if (lenVar >= 0) {
+                                    Var *lv = &evars[lenVar];
+                                    fprintf(fp, "\t\t\t\t} else if (wireLen%u < 4 || (size_t)(%s) + %u > len ||\n",
+                                            (uint) j, paramOffset[lenVar].c_str(), (uint) lv->type()->bytes());
+                                    fprintf(fp, "\t\t\t\t           Unpack<uint32_t>(inPtr%u) != (uint32_t)Unpack<%s>(ptr + %s)) {\n",
+                                            (uint) j, lv->type()->name().c_str(), paramOffset[lenVar].c_str());
+                                    fprintf(fp, "\t\t\t\t\tinPtr%u = NULL;\n", (uint) j);
+                                }
+                                fprintf(fp, "\t\t\t\t} else {\n");
+                                fprintf(fp, "\t\t\t\t\tinPtr%u = ctx->m_payloads.inflate(%d, inPtr%u, wireLen%u);\n",
+                                        (uint) j, slot, (uint) j, (uint) j);
+                                fprintf(fp, "\t\t\t\t}\n");
+                                fprintf(fp, "\t\t\t\tif (inPtr%u == NULL) {\n", (uint) j);
+                                fprintf(fp, "\t\t\t\t\tfprintf(stderr, \"%s: bad compressed %s, call dropped\\n\");\n",
+                                        e->name().c_str(), v->name().c_str());
+                                if (totalTmpBuffExist) {
+                                    // the guest waits for the reply all the same
+                                    fprintf(fp, "\t\t\t\t\tmemset(tmpBuf, 0, totalTmpSize);\n");
+                                    fprintf(fp, "\t\t\t\t\treturn true;\n");
+                                } else {
+                                    fprintf(fp, "\t\t\t\t\treturn false;\n");
+                                }
+                                fprintf(fp, "\t\t\t\t}\n");
+                                fprintf(fp, "\t\t\t}\n");
+                            } else if (pass == PASS_FunctionCall) {
+                                if (v->nullAllowed()) {
+                                    fprintf(fp, "Unpack<uint32_t>(ptr + %s) == 0 ? NULL : (%s)(inPtr%u)",
+                                            varoffset.c_str(), v->type()->name().c_str(), (uint) j);
+                                } else {
+                                    fprintf(fp, "(%s)(inPtr%u)", v->type()->name().c_str(), (uint) j);
+                                }
+                            } else if (pass == PASS_DebugPrint) {
+                                fprintf(fp, "(%s)(inPtr%u), Unpack<uint32_t>(ptr + %s)",
+                                        v->type()->name().c_str(), (uint) j,
+                                        varoffset.c_str());
+                            }
+                            varoffset += " + 4 + (Unpack<uint32_t>(ptr + " + varoffset + ") & ~CODEC_COMPRESSED_PAYLOAD)";
+                        } else if (v->pointerDir() == Var::POINTER_IN || v->pointerDir() == Var::POINTER_INOUT) {
                             if (pass == PASS_MemAlloc && v->pointerDir() == Var::POINTER_INOUT) {
-                                fprintf(fp, "\t\t\tsize_t tmpPtr%uSize = (size_t)*(unsigned int *)(ptr + %s);\n",
+                                fprintf(fp, "\t\t\tsize_t tmpPtr%uSize = (size_t)Unpack<uint32_t>(ptr + %s);\n",
                                         (uint) j, varoffset.c_str());
                                 fprintf(fp, "unsigned char *tmpPtr%u = (ptr + %s + 4);\n",
                                         (uint) j, varoffset.c_str());
                             }
                             if (pass == PASS_FunctionCall) {
                                 if (v->nullAllowed()) {
-                                    fprintf(fp, "*((unsigned int *)(ptr + %s)) == 0 ? NULL : (%s)(ptr + %s + 4)",
+                                    fprintf(fp, "Unpack<uint32_t>(ptr + %s) == 0 ? NULL : (%s)(ptr + %s + 4)",
                                             varoffset.c_str(), v->type()->name().c_str(), varoffset.c_str());
                                 } else {
                                     fprintf(fp, "(%s)(ptr + %s + 4)",
                                             v->type()->name().c_str(), varoffset.c_str());
                                 }
                             } else if (pass == PASS_DebugPrint) {
-                                fprintf(fp, "(%s)(ptr + %s + 4), *(unsigned int *)(ptr + %s)",
+                                fprintf(fp, "(%s)(ptr + %s + 4), Unpack<uint32_t>(ptr + %s)",
                                         v->type()->name().c_str(), varoffset.c_str(),
                                         varoffset.c_str());
                             }
-                            varoffset += " + 4 + *(size_t *)(ptr +" + varoffset + ")";
+                            varoffset += " + 4 + Unpack<uint32_t>(ptr + " + varoffset + ")";
                         } else { // out pointer;
                             if (pass == PASS_TmpBuffAlloc) {
-                                fprintf(fp, "\t\t\tsize_t tmpPtr%uSize = (size_t)*(unsigned int *)(ptr + %s);\n",
+                                fprintf(fp, "\t\t\tsize_t tmpPtr%uSize = (size_t)Unpack<uint32_t>(ptr + %s);\n",
                                         (uint) j, varoffset.c_str());
                                 if (!totalTmpBuffExist) {
                                     fprintf(fp, "\t\t\tsize_t totalTmpSize = tmpPtr%uSize;\n", (uint)j);
@@ -663,7 +997,7 @@ int ApiGen::genDecoderImpl(const std::string &filename)
                                     fprintf(fp, "(%s)(tmpPtr%u)", v->type()->name().c_str(), (uint) j);
                                 }
                             } else if (pass == PASS_DebugPrint) {
-                                fprintf(fp, "(%s)(tmpPtr%u), *(unsigned int *)(ptr + %s)",
+                                fprintf(fp, "(%s)(tmpPtr%u), Unpack<uint32_t>(ptr + %s)",
                                         v->type()->name().c_str(), (uint) j,
                                         varoffset.c_str());
                             }
@@ -673,7 +1007,9 @@ int ApiGen::genDecoderImpl(const std::string &filename)
                 }
             }
 
-            if (pass == PASS_FunctionCall || pass == PASS_DebugPrint) fprintf(fp, ");\n");
+            if (pass == PASS_FunctionCall) paramBytes = varoffset;
+            if (pass == PASS_FunctionCall && packRetval) fprintf(fp, "));\n");
+            else if (pass == PASS_FunctionCall || pass == PASS_DebugPrint) fprintf(fp, ");\n");
             if (pass == PASS_DebugPrint) fprintf(fp, "#endif\n");
 
             if (pass == PASS_TmpBuffAlloc) {
@@ -691,27 +1027,365 @@ int ApiGen::genDecoderImpl(const std::string &filename)
             }
 
             if (pass == PASS_Epilog) {
-                // send back out pointers data as well as retval
-                if (totalTmpBuffExist) {
-                    fprintf(fp, "\t\t\tstream->flush();\n");
-                }
-
-                fprintf(fp, "\t\t\tpos += *(int *)(ptr + 4);\n");
-                fprintf(fp, "\t\t\tptr += *(int *)(ptr + 4);\n");
+                // out pointers data and retval were written in place into
+                // the stream; the decode loop flushes them once it runs
+                // out of input, so that a burst of queries is answered
+                // with a single write.
+                fprintf(fp, "\t\t\tCODEC_TRACE_END(\"dec\", \"%s\", %s);\n",
+                        e->name().c_str(), paramBytes.c_str());
+                fprintf(fp, "\t\t\treturn %s;\n", totalTmpBuffExist ? "true" : "false");
             }
 
         } // pass;
-        fprintf(fp, "\t\t\t}\n");
-        fprintf(fp, "\t\t\tbreak;\n");
+        fprintf(fp, "}\n\n");
+        sendsReply[f] = totalTmpBuffExist;
 
         delete [] tmpBufOffset;
+        delete [] paramOffset;
+    }
+
+    // repeat packets, see CallBatcher.h; each batchable entry point gets
+    // its own loop so that the calls cost no dispatch;
+    bool batchable = hasBatchable();
+    if (batchable) {
+        fprintf(fp, "static bool dec_%s_repeat(void *self, unsigned char *ptr, size_t len, IOStream *stream)\n{\n",
+                m_basename.c_str());
+        fprintf(fp, "\t\t\t%s *ctx = (%s *)self;\n", classname.c_str(), classname.c_str());
+        fprintf(fp, "\t\t\tif (len < 8) {\n");
+        fprintf(fp, "\t\t\t\tfprintf(stderr, \"%s: repeat packet of %%u bytes\\n\", (unsigned int)len);\n",
+                m_basename.c_str());
+        fprintf(fp, "\t\t\t\treturn false;\n");
+        fprintf(fp, "\t\t\t}\n");
+        fprintf(fp, "\t\t\tunsigned int opcode = Unpack<uint32_t>(ptr);\n");
+        fprintf(fp, "\t\t\tunsigned int count = Unpack<uint32_t>(ptr + 4);\n");
+        fprintf(fp, "\t\t\tunsigned char *p = ptr + 8;\n");
+        fprintf(fp, "\t\t\tCODEC_TRACE_BEGIN();\n");
+        fprintf(fp, "\t\t\tswitch (opcode) {\n");
+        for (size_t f = 0; f < n; f++) {
+            EntryPoint *e = &at(f);
+            if (!e->batchable()) continue;
+
+            unsigned int paramSize;
+            fixedParamSize(e, &paramSize);
+            fprintf(fp, "\t\t\tcase OP_%s:\n", e->name().c_str());
+            // the count is checked against what the packet holds
+            fprintf(fp, "\t\t\t\tif (count > (len - 8) / %u) {\n", paramSize ? paramSize : 1);
+            fprintf(fp, "\t\t\t\t\tfprintf(stderr, \"%s_repeat: %%u calls do not fit in %%u bytes\\n\", count, (unsigned int)len);\n",
+                    m_basename.c_str());
+            fprintf(fp, "\t\t\t\t\tbreak;\n");
+            fprintf(fp, "\t\t\t\t}\n");
+            fprintf(fp, "\t\t\t\tfor (unsigned int i = 0; i < count; i++, p += %u) {\n", paramSize);
+            fprintf(fp, "\t\t\t\t\tctx->%s(%s", e->name().c_str(), e->customDecoder() ? "ctx" : "");
+            unsigned int offset = 0;
+            bool first = !e->customDecoder();
+            for (size_t j = 0; j < e->vars().size(); j++) {
+                Var *v = &e->vars()[j];
+                if (v->isVoid()) continue;
+                fprintf(fp, "%sUnpack<%s>(p + %u)", first ? "" : ", ",
+                        v->type()->name().c_str(), offset);
+                offset += v->type()->bytes();
+                first = false;
+            }
+            fprintf(fp, ");\n");
+            fprintf(fp, "\t\t\t\t}\n");
+            fprintf(fp, "\t\t\t\tbreak;\n");
+        }
+        fprintf(fp, "\t\t\tdefault:\n");
+        fprintf(fp, "\t\t\t\tfprintf(stderr, \"%s: opcode %%u cannot be repeated\\n\", opcode);\n",
+                m_basename.c_str());
+        fprintf(fp, "\t\t\t\tbreak;\n");
+        fprintf(fp, "\t\t\t}\n");
+        fprintf(fp, "\t\t\tCODEC_TRACE_END(\"dec\", \"%s_repeat\", p - ptr);\n", m_basename.c_str());
+        fprintf(fp, "\t\t\treturn false;\n");
+        fprintf(fp, "}\n\n");
+    }
+    size_t numOpcodes = batchable ? n + 1 : n;
+
+    // handlers table, indexed by opcode - base_opcode;
+    fprintf(fp, "static const OpcodeHandler s_handlers[] = {\n");
+    for (size_t f = 0; f < n; f++) {
+        fprintf(fp, "\tdec_%s,\n", at(f).name().c_str());
+    }
+    if (batchable) {
+        fprintf(fp, "\tdec_%s_repeat,\n", m_basename.c_str());
+    }
+    fprintf(fp, "};\n\n");
+
+    // opcode names, for the statistics;
+    fprintf(fp, "static const char * const s_opcodeNames[] = {\n");
+    for (size_t f = 0; f < n; f++) {
+        fprintf(fp, "\t\"%s\",\n", at(f).name().c_str());
+    }
+    if (batchable) {
+        fprintf(fp, "\t\"%s_repeat\",\n", m_basename.c_str());
+    }
+    fprintf(fp, "};\n\n");
+
+    // the size of the packets with fixed size parameters is implied by
+    // their opcode in the compact header format;
+    std::vector<unsigned int> paramSizes(n, 0);
+    fprintf(fp, "static const unsigned char s_opcodeFlags[] = {\n");
+    for (size_t f = 0; f < n; f++) {
+        bool fixed = fixedParamSize(&at(f), &paramSizes[f]);
+        fprintf(fp, "\t%s%s%s,\n",
+                sendsReply[f] ? "OPCODE_FLAG_REPLY" : "",
+                sendsReply[f] && fixed ? " | " : "",
+                fixed ? "OPCODE_FLAG_FIXED_SIZE" : (sendsReply[f] ? "" : "0"));
+    }
+    if (batchable) {
+        fprintf(fp, "\t0,\n");
+    }
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "static const unsigned int s_paramSizes[] = {\n");
+    for (size_t f = 0; f < n; f++) {
+        fprintf(fp, "\t%u,\n", paramSizes[f]);
+    }
+    if (batchable) {
+        fprintf(fp, "\t0,\n");
+    }
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "const DecoderInfo %s::s_info = {\n", classname.c_str());
+    fprintf(fp, "\t\"%s\", %u, %u, s_handlers, s_opcodeNames, s_opcodeFlags, s_paramSizes\n};\n\n",
+            m_basename.c_str(), (uint) m_baseOpcode, (uint) numOpcodes);
+
+    fprintf(fp, "%s::%s() :\n", classname.c_str(), classname.c_str());
+    fprintf(fp, "\tm_stats(s_info.api, s_info.baseOpcode, s_info.numOpcodes, s_info.names)\n{\n}\n\n");
+
+    // decode loop, for streams that carry this api only, in the classic
+    // header format;
+    fprintf(fp, "size_t %s::decode(void *buf, size_t len, IOStream *stream)\n{\n", classname.c_str());
+    fprintf(fp,
+            "\tsize_t pos = 0;\n\
+\tbool replied = false;\n\
+\tunsigned char *ptr = (unsigned char *)buf;\n\
+\twhile (len - pos >= 8) {\n\
+\t\tunsigned int opcode = Unpack<uint32_t>(ptr);\n\
+\t\tunsigned int packetLen = Unpack<uint32_t>(ptr + 4);\n\
+\t\tif (packetLen < 8 || len - pos < packetLen) break;\n\
+\t\tif (opcode - %uU >= %uU) break; // not one of ours\n\
+\t\tuint64_t startTime = m_stats.enabled() ? DecoderStats::now() : 0;\n\
+\t\tbool roundTrip = s_handlers[opcode - %uU](this, ptr + 8, packetLen - 8, stream);\n\
+\t\tif (m_stats.enabled()) {\n\
+\t\t\tm_stats.record(opcode, packetLen, startTime, roundTrip);\n\
+\t\t}\n\
+\t\treplied |= roundTrip;\n\
+\t\tpos += packetLen;\n\
+\t\tptr += packetLen;\n\
+\t}\n\
+\tif (replied) stream->flush();\n\
+\treturn pos;\n\
+}\n",
+            (uint) m_baseOpcode, (uint) numOpcodes, (uint) m_baseOpcode);
+
+    fclose(fp);
+    return 0;
+}
+
+// true if the expression refers to the encoder context, whose state the
+// benchmark does not set up
+static bool usesEncoderState(const std::string & expression)
+{
+    return expression.find("self") != std::string::npos;
+}
+
+int ApiGen::genBenchmark(const std::string &filename)
+{
+    FILE *fp = fopen(filename.c_str(), "wt");
+    if (fp == NULL) {
+        perror(filename.c_str());
+        return -1;
+    }
+
+    printHeader(fp);
+    std::string encname = m_basename + "_encoder_context_t";
+    std::string decname = m_basename + "_decoder_context_t";
+
+    fprintf(fp, "\n#include <stdio.h>\n");
+    fprintf(fp, "#include <stdlib.h>\n");
+    fprintf(fp, "#include <string.h>\n");
+    fprintf(fp, "#include \"%s_enc.h\"\n", m_basename.c_str());
+    fprintf(fp, "#include \"%s_dec.h\"\n", m_basename.c_str());
+    fprintf(fp, "#include \"OpcodeDispatcher.h\"\n");
+    fprintf(fp, "#include \"TimeUtils.h\"\n");
+    fprintf(fp, "#include \"BenchStream.h\"\n\n");
+
+    fprintf(fp, "#define BENCH_DEFAULT_CALLS 10000\n");
+    fprintf(fp, "#define BENCH_DATA_SIZE 4096 // pointer data of a call, per parameter\n");
+    fprintf(fp, "#define BENCH_STREAM_SIZE (4 * 1024 * 1024)\n\n");
+    fprintf(fp, "static unsigned char s_data[BENCH_DATA_SIZE];\n\n");
+    fprintf(fp, "static bool benchDataFits(size_t len)\n{\n");
+    fprintf(fp, "\treturn len > 0 && len <= BENCH_DATA_SIZE;\n}\n\n");
+
+    // null server side implementation
+    for (size_t i = 0; i < size(); i++) {
+        EntryPoint *e = &at(i);
+        e->print(fp, true, "", "null_", e->customDecoder() ? "void *ctx" : "");
+        fprintf(fp, "{\n");
+        if (!e->retval().isVoid()) {
+            fprintf(fp, "\treturn (%s)0;\n", e->retval().type()->name().c_str());
+        }
+        fprintf(fp, "}\n\n");
+    }
+
+    fprintf(fp, "static void initNullDispatch(%s *dec)\n{\n", decname.c_str());
+    for (size_t i = 0; i < size(); i++) {
+        EntryPoint *e = &at(i);
+        fprintf(fp, "\tdec->%s = null_%s;\n", e->name().c_str(), e->name().c_str());
     }
-    fprintf(fp, "\t\t\tdefault:\n");
-    fprintf(fp, "\t\t\t\tunknownOpcode = true;\n");
-    fprintf(fp, "\t\t} //switch\n");
-    fprintf(fp, "\t} // while\n");
-    fprintf(fp, "\treturn pos;\n");
-    fprintf(fp, "}\n");
+    fprintf(fp, "}\n\n");
+
+    // encoding of '__count' calls with synthesized arguments: s_data for
+    // the pointers, the bench_value of their name or 1 for the scalars.
+    // Returns false if this gives no representative call.
+    for (size_t i = 0; i < size(); i++) {
+        EntryPoint *e = &at(i);
+        if (e->unsupported()) continue;
+
+        VarsArray & evars = e->vars();
+        bool usable = true;
+        for (size_t j = 0; j < evars.size(); j++) {
+            if (usesEncoderState(evars[j].lenExpression()) ||
+                usesEncoderState(evars[j].packExpression())) {
+                usable = false;
+            }
+        }
+
+        fprintf(fp, "static bool bench_%s(void *self, int __count)\n{\n", e->name().c_str());
+        if (!usable) {
+            fprintf(fp, "\t// the data size depends on the encoder state\n");
+            fprintf(fp, "\treturn false;\n}\n\n");
+            continue;
+        }
+        for (size_t j = 0; j < evars.size(); j++) {
+            if (evars[j].isVoid()) continue;
+            std::string value = "1";
+            if (evars[j].isPointer()) {
+                value = "s_data";
+            } else if (m_benchValues.find(evars[j].name()) != m_benchValues.end()) {
+                value = "(" + m_benchValues[evars[j].name()] + ")";
+            }
+            fprintf(fp, "\t%s %s = (%s)%s;\n",
+                    evars[j].type()->name().c_str(), evars[j].name().c_str(),
+                    evars[j].type()->name().c_str(), value.c_str());
+        }
+        for (size_t j = 0; j < evars.size(); j++) {
+            if (!evars[j].isPointer() || evars[j].lenExpression() == "") continue;
+            fprintf(fp, "\tif (!benchDataFits(%s)) return false;\n",
+                    evars[j].lenExpression().c_str());
+        }
+        fprintf(fp, "\tfor (int __i = 0; __i < __count; __i++) {\n");
+        fprintf(fp, "\t\t%s_enc(self", e->name().c_str());
+        for (size_t j = 0; j < evars.size(); j++) {
+            if (evars[j].isVoid()) continue;
+            fprintf(fp, ", %s", evars[j].name().c_str());
+        }
+        fprintf(fp, ");\n\t}\n");
+        fprintf(fp, "\treturn true;\n}\n\n");
+    }
+
+    fprintf(fp, "struct BenchEntry {\n");
+    fprintf(fp, "\tconst char *name;\n");
+    fprintf(fp, "\tbool (*run)(void *self, int count);\n");
+    fprintf(fp, "};\n\n");
+    fprintf(fp, "static const BenchEntry s_entries[] = {\n");
+    for (size_t i = 0; i < size(); i++) {
+        EntryPoint *e = &at(i);
+        if (e->unsupported()) continue;
+        fprintf(fp, "\t{ \"%s\", bench_%s },\n", e->name().c_str(), e->name().c_str());
+    }
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "\
+static void usage(const char *prog)\n\
+{\n\
+\tfprintf(stderr, \"Usage: %%s [-c] [-n calls]\\n\", prog);\n\
+\tfprintf(stderr, \"\\t-c: use the compact packet header\\n\");\n\
+\tfprintf(stderr, \"\\t-n: calls per entry point, %%d by default\\n\", BENCH_DEFAULT_CALLS);\n\
+}\n\
+\n\
+int main(int argc, char **argv)\n\
+{\n\
+\tint count = BENCH_DEFAULT_CALLS;\n\
+\tint format = PACKET_FORMAT_CLASSIC;\n\
+\tfor (int i = 1; i < argc; i++) {\n\
+\t\tif (!strcmp(argv[i], \"-c\")) {\n\
+\t\t\tformat = PACKET_FORMAT_COMPACT;\n\
+\t\t} else if (!strcmp(argv[i], \"-n\") && i + 1 < argc) {\n\
+\t\t\tcount = atoi(argv[++i]);\n\
+\t\t} else {\n\
+\t\t\tusage(argv[0]);\n\
+\t\t\treturn 1;\n\
+\t\t}\n\
+\t}\n\
+\tif (count <= 0) {\n\
+\t\tusage(argv[0]);\n\
+\t\treturn 1;\n\
+\t}\n\
+\n\
+\tBenchStream stream(BENCH_STREAM_SIZE);\n\
+\tBenchStream replies(BENCH_STREAM_SIZE);\n\
+\t%s *dec = new %s();\n\
+\tinitNullDispatch(dec);\n\
+\tOpcodeDispatcher dispatcher;\n\
+\tdec->m_stats.setEnabled(false);\n\
+\tdispatcher.addDecoder(&%s::s_info, dec, &dec->m_stats);\n\
+\tdispatcher.setPacketFormat(format);\n\
+\n\
+\tint skipped = 0, failed = 0;\n\
+\tlong long totalEnc = 0, totalDec = 0, totalBytes = 0, totalCalls = 0;\n\
+\tprintf(\"%%-32s %%12s %%12s %%12s\\n\", \"%s\", \"enc ns/call\", \"dec ns/call\", \"bytes/call\");\n\
+\tfor (size_t n = 0; n < sizeof(s_entries) / sizeof(s_entries[0]); n++) {\n\
+\t\tconst BenchEntry *entry = &s_entries[n];\n\
+\t\tstream.reset();\n\
+\t\t%s *enc = new %s(&stream);\n\
+\t\tenc->m_packetFormat = format;\n\
+\n\
+\t\tlong long start = GetCurrentTimeNS();\n\
+\t\tbool ran = entry->run(enc, count);\n\
+\t\tstream.flush();\n\
+\t\tlong long encoded = GetCurrentTimeNS();\n\
+\t\tdelete enc;\n\
+\t\tif (!ran) {\n\
+\t\t\tprintf(\"%%-32s skipped, no representative arguments\\n\", entry->name);\n\
+\t\t\tskipped++;\n\
+\t\t\tcontinue;\n\
+\t\t}\n\
+\n\
+\t\treplies.reset();\n\
+\t\tsize_t len = stream.size();\n\
+\t\tlong long decodeStart = GetCurrentTimeNS();\n\
+\t\tsize_t done = dispatcher.decode(stream.data(), len, &replies);\n\
+\t\tlong long decoded = GetCurrentTimeNS();\n\
+\t\tif (done != len || dispatcher.failed()) {\n\
+\t\t\tprintf(\"%%-32s FAILED, decoded %%u of %%u bytes\\n\", entry->name,\n\
+\t\t\t       (unsigned int)done, (unsigned int)len);\n\
+\t\t\tfailed++;\n\
+\t\t\tbreak;\n\
+\t\t}\n\
+\n\
+\t\tprintf(\"%%-32s %%12.1f %%12.1f %%12.1f\\n\", entry->name,\n\
+\t\t       (double)(encoded - start) / count,\n\
+\t\t       (double)(decoded - decodeStart) / count,\n\
+\t\t       (double)len / count);\n\
+\t\ttotalEnc += encoded - start;\n\
+\t\ttotalDec += decoded - decodeStart;\n\
+\t\ttotalBytes += len;\n\
+\t\ttotalCalls += count;\n\
+\t}\n\
+\n\
+\tif (totalCalls > 0) {\n\
+\t\tprintf(\"%%-32s %%12.1f %%12.1f %%12.1f\\n\", \"average\",\n\
+\t\t       (double)totalEnc / totalCalls, (double)totalDec / totalCalls,\n\
+\t\t       (double)totalBytes / totalCalls);\n\
+\t}\n\
+\tprintf(\"%%d entry points skipped, %%d failed\\n\", skipped, failed);\n\
+\tdelete dec;\n\
+\treturn failed ? 1 : 0;\n\
+}\n",
+            decname.c_str(), decname.c_str(), decname.c_str(), m_basename.c_str(),
+            encname.c_str(), encname.c_str());
 
     fclose(fp);
     return 0;
@@ -830,6 +1504,15 @@ int ApiGen::setGlobalAttribute(const std::string & line, size_t lc)
             str = getNextToken(line, pos, &last, WHITESPACE);
             pos = last;
         }
+    } else if (token == "bench_value") {
+        std::string varname = getNextToken(line, pos, &last, WHITESPACE);
+        pos = last;
+        std::string value = trim(line.substr(pos));
+        if (varname.size() == 0 || value.size() == 0) {
+            fprintf(stderr, "line %u: bench_value expects a parameter name and a value\n", (uint) lc);
+        } else {
+            m_benchValues[varname] = value;
+        }
     } else if (token == "decoder_headers") {
         std::string str = getNextToken(line, pos, &last, WHITESPACE);
         pos = last;
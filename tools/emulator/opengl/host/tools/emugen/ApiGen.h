@@ -17,6 +17,7 @@
 #define __API_GEN_H_
 
 #include <vector>
+#include <map>
 #include <string.h>
 #include "EntryPoint.h"
 
@@ -25,6 +26,7 @@ class ApiGen : public std::vector<EntryPoint> {
 
 public:
     typedef std::vector<std::string> StringVec;
+    typedef std::map<std::string, std::string> StringMap;
     typedef enum { CLIENT_SIDE, SERVER_SIDE, WRAPPER_SIDE } SideType;
 
     ApiGen(const std::string & basename) :
@@ -64,6 +66,9 @@ public:
     StringVec & decoderHeaders() { return m_decoderHeaders; }
 
     EntryPoint * findEntryByName(const std::string & name);
+    // true if the api has batchable entry points, which adds the
+    // OP_<basename>_repeat opcode after the last entry point
+    bool hasBatchable();
     int genOpcodes(const std::string &filename);
     int genAttributesTemplate(const std::string &filename);
     int genProcTypes(const std::string &filename, SideType side);
@@ -79,6 +84,8 @@ public:
     int genDecoderHeader(const std::string &filename);
     int genDecoderImpl(const std::string &filename);
 
+    int genBenchmark(const std::string &filename);
+
 protected:
     virtual void printHeader(FILE *fp) const;
     std::string m_basename;
@@ -86,6 +93,7 @@ protected:
     StringVec m_encoderHeaders;
     StringVec m_serverContextHeaders;
     StringVec m_decoderHeaders;
+    StringMap m_benchValues; // parameter name -> value used by the benchmark
     size_t m_maxEntryPointsParams; // record the maximum number of parameters in the entry points;
     int m_baseOpcode;
     int setGlobalAttribute(const std::string & line, size_t lc);
@@ -34,6 +34,7 @@ void EntryPoint::reset()
 {
     m_unsupported = false;
     m_customDecoder = false;
+    m_batchable = false;
     m_vars.empty();
 }
 
@@ -280,6 +281,18 @@ int EntryPoint::setAttribute(const std::string &line, size_t lc)
                 fprintf(stderr, "WARNING: %u: setting nullAllowed for non-pointer variable %s\n",
                         (unsigned int) lc, v->name().c_str());
             }
+        } else if (flag == "aligned") {
+            // only the data of one pointer per call can be aligned
+            bool other = false;
+            for (size_t i = 0; i < m_vars.size(); i++) {
+                other |= m_vars[i].aligned() && &m_vars[i] != v;
+            }
+            if (!v->isPointer() || v->pointerDir() == Var::POINTER_OUT || other) {
+                fprintf(stderr, "WARNING: %u: %s cannot be aligned\n",
+                        (unsigned int) lc, v->name().c_str());
+            } else {
+                v->setAligned(true);
+            }
         } else {
             fprintf(stderr, "WARNING: %u: unknow flag %s\n", (unsigned int)lc, flag.c_str());
         }
@@ -312,6 +325,15 @@ int EntryPoint::setAttribute(const std::string &line, size_t lc)
             setUnsupported(true);
         } else if (flag == "custom_decoder") {
             setCustomDecoder(true);
+        } else if (flag == "batchable") {
+            // calls are merged by the encoder, so they cannot return
+            // anything
+            if (hasPointers() || !m_retval.isVoid()) {
+                fprintf(stderr, "WARNING: %u: %s cannot be batchable\n",
+                        (unsigned int)lc, m_name.c_str());
+            } else {
+                setBatchable(true);
+            }
         } else {
             fprintf(stderr, "WARNING: %u: unknown flag %s\n", (unsigned int)lc, flag.c_str());
         }
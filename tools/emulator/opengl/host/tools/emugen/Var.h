@@ -30,6 +30,7 @@ public:
         m_lenExpression(""),
         m_pointerDir(POINTER_IN),
         m_nullAllowed(false),
+        m_aligned(false),
         m_packExpression("")
 
     {
@@ -45,6 +46,7 @@ public:
         m_lenExpression(lenExpression),
         m_pointerDir(dir),
         m_nullAllowed(false),
+        m_aligned(false),
         m_packExpression(packExpression)
     {
     }
@@ -58,7 +60,7 @@ public:
         m_packExpression = packExpression;
         m_pointerDir = dir;
         m_nullAllowed = false;
-
+        m_aligned = false;
     }
 
     const std::string & name() const { return m_name; }
@@ -73,6 +75,8 @@ public:
     PointerDir pointerDir() { return m_pointerDir; }
     void setNullAllowed(bool state) { m_nullAllowed = state; }
     bool nullAllowed() const { return m_nullAllowed; }
+    void setAligned(bool state) { m_aligned = state; }
+    bool aligned() const { return m_aligned; }
     void printType(FILE *fp) { fprintf(fp, "%s", m_type->name().c_str()); }
     void printTypeName(FILE *fp) { printType(fp); fprintf(fp, " %s", m_name.c_str()); }
 
@@ -83,6 +87,7 @@ private:
     std::string m_lenExpression; // an expression to calcualte a pointer data size
     PointerDir m_pointerDir;
     bool m_nullAllowed;
+    bool m_aligned; // data 4 byte aligned in the stream
     std::string m_packExpression; // an expression to pack data into the stream
 
 };
@@ -35,6 +35,7 @@ void usage(const char *filename)
     fprintf(stderr, "\t-i: input dir, local directory by default\n");
     fprintf(stderr, "\t-T : generate attribute template into the input directory\n\t\tno other files are generated\n");
     fprintf(stderr, "\t-W : generate wrapper into dir\n");
+    fprintf(stderr, "\t-B <dir>: generate encoder/decoder benchmark into dir\n");
 }
 
 int main(int argc, char *argv[])
@@ -42,15 +43,19 @@ int main(int argc, char *argv[])
     std::string encoderDir = "";
     std::string decoderDir = "";
     std::string wrapperDir = "";
+    std::string benchDir = "";
     std::string inDir = ".";
     bool generateAttributesTemplate = false;
 
     int c;
-    while((c = getopt(argc, argv, "TE:D:i:hW:")) != -1) {
+    while((c = getopt(argc, argv, "TE:D:i:hW:B:")) != -1) {
         switch(c) {
         case 'W':
             wrapperDir = std::string(optarg);
             break;
+        case 'B':
+            benchDir = std::string(optarg);
+            break;
         case 'T':
             generateAttributesTemplate = true;
             break;
@@ -84,7 +89,8 @@ int main(int argc, char *argv[])
     if (encoderDir.size() == 0 &&
         decoderDir.size() == 0 &&
         generateAttributesTemplate == false &&
-        wrapperDir.size() == 0) {
+        wrapperDir.size() == 0 &&
+        benchDir.size() == 0) {
         fprintf(stderr, "No output specified - aborting\n");
         return BAD_USAGE;
     }
@@ -147,6 +153,10 @@ int main(int argc, char *argv[])
         apiEntries.genEntryPoints(wrapperDir + "/" + baseName + "_wrapper_entry.cpp", ApiGen::WRAPPER_SIDE);
     }
 
+    if (benchDir.size() != 0) {
+        apiEntries.genBenchmark(benchDir + "/" + baseName + "_bench.cpp");
+    }
+
 #ifdef DEBUG_DUMP
     int withPointers = 0;
     printf("%d functions found\n", int(apiEntries.size()));
@@ -7,10 +7,16 @@ emulatorOpengl := $(LOCAL_PATH)/../..
 include $(CLEAR_VARS)
 
 OpenglCodecCommon := \
+        CallBatcher.cpp \
+        CodecTrace.cpp \
         GLClientState.cpp \
+        GLStateShadow.cpp \
         glUtils.cpp \
+        PayloadCodec.cpp \
+        ProgramCache.cpp \
         TcpStream.cpp \
-        TimeUtils.cpp
+        TimeUtils.cpp \
+        VertexArrayCache.cpp
 
 LOCAL_SRC_FILES :=  $(OpenglCodecCommon)
 
@@ -25,7 +31,13 @@ include $(BUILD_STATIC_LIBRARY)
 ### OpenglCodecCommon  host ##############################################
 include $(CLEAR_VARS)
 
-LOCAL_SRC_FILES :=  $(OpenglCodecCommon)
+LOCAL_SRC_FILES :=  $(OpenglCodecCommon) \
+        DecoderStats.cpp \
+        OpcodeDispatcher.cpp
+
+ifeq ($(HOST_OS),linux)
+    LOCAL_SRC_FILES += ShmStream.cpp
+endif
 
 LOCAL_C_INCLUDES += $(emulatorOpengl)/host/include/libOpenglRender 
 
@@ -0,0 +1,107 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "CallBatcher.h"
+#include "PacketHeader.h"
+#include <string.h>
+
+bool CallBatcher::canAppend(IOStream *stream, int format, uint32_t opcode) const
+{
+    return m_repeatOpcode != 0 &&
+           m_end != NULL &&
+           opcode == m_opcode &&
+           format == m_format &&
+           m_end == stream->tail() &&
+           m_commits == stream->commits();
+}
+
+//
+// toRepeat - rewrites the m_count plain packets of the run into a
+// single repeat packet, the stream tail is moved to its end.
+//
+void CallBatcher::toRepeat(IOStream *stream, size_t plainHeaderSize, uint32_t paramSize)
+{
+    size_t repeatHeaderSize = growableHeaderSize(m_format) + REPEAT_PARAMS_SIZE;
+    size_t plainSize = m_count * (plainHeaderSize + paramSize);
+    size_t repeatSize = repeatHeaderSize + m_count * paramSize;
+
+    unsigned char *params = (unsigned char *)m_scratch.alloc(m_count * paramSize);
+    for (uint32_t i = 0; i < m_count; i++) {
+        memcpy(params + i * paramSize,
+               m_start + i * (plainHeaderSize + paramSize) + plainHeaderSize,
+               paramSize);
+    }
+
+    if (repeatSize > plainSize) {
+        stream->alloc(repeatSize - plainSize);
+    } else {
+        stream->unalloc(plainSize - repeatSize);
+    }
+
+    unsigned char *ptr = packGrowableHeader(m_start, m_format, m_repeatOpcode,
+                                            REPEAT_PARAMS_SIZE + m_count * paramSize);
+    Pack<uint32_t>(ptr, m_opcode);
+    Pack<uint32_t>(ptr + 4, m_count);
+    memcpy(ptr + REPEAT_PARAMS_SIZE, params, m_count * paramSize);
+
+    m_end = m_start + repeatSize;
+    m_repeat = true;
+}
+
+unsigned char *CallBatcher::alloc(IOStream *stream, int format, uint32_t opcode,
+                                  uint32_t paramSize)
+{
+    size_t plainHeaderSize = packetHeaderSize(format, true, paramSize);
+
+    if (canAppend(stream, format, opcode)) {
+        size_t repeatHeaderSize = growableHeaderSize(format) + REPEAT_PARAMS_SIZE;
+
+        // a repeat packet pays off once it saves more plain headers than
+        // its own header costs; allocations that fit in tailRoom() do not
+        // flush, so the run stays in place.
+        if (!m_repeat && (m_count + 1) * plainHeaderSize > repeatHeaderSize &&
+            stream->tailRoom() >= repeatHeaderSize + paramSize) {
+            toRepeat(stream, plainHeaderSize, paramSize);
+        }
+
+        if (m_repeat && stream->tailRoom() >= paramSize) {
+            unsigned char *ptr = stream->alloc(paramSize);
+            m_count++;
+            Pack<uint32_t>(m_start + repeatHeaderSize - 4, m_count);
+            setPacketParamLen(m_start, format, REPEAT_PARAMS_SIZE + m_count * paramSize);
+            m_end = ptr + paramSize;
+            return ptr;
+        }
+
+        if (!m_repeat && stream->tailRoom() >= plainHeaderSize + paramSize) {
+            unsigned char *ptr = stream->alloc(plainHeaderSize + paramSize);
+            ptr = packPacketHeader(ptr, format, opcode, true, paramSize);
+            m_count++;
+            m_end = ptr + paramSize;
+            return ptr;
+        }
+    }
+
+    // start a new run
+    m_start = stream->alloc(plainHeaderSize + paramSize);
+    unsigned char *ptr = packPacketHeader(m_start, format, opcode, true, paramSize);
+    m_end = ptr + paramSize;
+    m_commits = stream->commits();
+    m_format = format;
+    m_opcode = opcode;
+    m_count = 1;
+    m_repeat = false;
+    return ptr;
+}
@@ -0,0 +1,77 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _CALL_BATCHER_H
+#define _CALL_BATCHER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "IOStream.h"
+#include "FixedBuffer.h"
+
+//
+// Merging of consecutive calls to the same 'batchable' entry point.
+//
+// A repeat packet carries several calls to one entry point with fixed
+// size parameters:
+//     header of an OP_<api>_repeat packet
+//     uint32_t opcode;               // of the repeated entry point
+//     uint32_t count;
+//     parameters of each call, back to back
+//
+// The calls of a run are first written as plain packets. Once the run is
+// long enough for a repeat packet to be smaller, and as long as it is
+// still at the end of the stream buffer, its packets are rewritten into
+// one repeat packet that the following calls extend.
+//
+#define REPEAT_PARAMS_SIZE  8   // opcode and count
+
+class CallBatcher {
+public:
+    CallBatcher() :
+        m_repeatOpcode(0),
+        m_start(NULL),
+        m_end(NULL),
+        m_commits(0),
+        m_format(0),
+        m_opcode(0),
+        m_count(0),
+        m_repeat(false) {}
+
+    // sets the opcode of the api's repeat packets, batching is disabled
+    // while it is 0.
+    void setRepeatOpcode(uint32_t opcode) { m_repeatOpcode = opcode; }
+
+    // alloc - returns where the parameters of a call to 'opcode' are to
+    // be written, either in a new packet or at the end of the last one.
+    unsigned char *alloc(IOStream *stream, int format, uint32_t opcode,
+                         uint32_t paramSize);
+
+private:
+    bool canAppend(IOStream *stream, int format, uint32_t opcode) const;
+    void toRepeat(IOStream *stream, size_t plainHeaderSize, uint32_t paramSize);
+
+    uint32_t m_repeatOpcode;
+    unsigned char *m_start;     // current run, in the stream buffer
+    unsigned char *m_end;
+    unsigned int m_commits;     // stream commits when it was written
+    int m_format;
+    uint32_t m_opcode;
+    uint32_t m_count;           // calls in the run
+    bool m_repeat;              // the run is a repeat packet already
+    FixedBuffer m_scratch;
+};
+
+#endif
@@ -0,0 +1,216 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "CodecTrace.h"
+#include "TimeUtils.h"
+#include <cutils/threads.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+#define TRACE_RING_SIZE 16384   // events per thread, a power of 2
+
+struct TraceEvent {
+    const char *category;
+    const char *name;
+    uint64_t start;             // ns
+    uint32_t duration;          // ns
+    uint32_t bytes;
+    int tid;                    // id of the ring when it was recorded
+};
+
+//
+// Written by its thread only. head counts the events ever recorded, it is
+// published after the event is written so that the dump can read the ring
+// while the thread is running; the events being overwritten at that time
+// may be garbled, which is acceptable for a trace.
+//
+struct TraceRing {
+    TraceEvent events[TRACE_RING_SIZE];
+    volatile uint32_t head;
+    int id;                     // new for each thread that owns the ring
+    volatile bool active;       // owned by a live thread
+    TraceRing *next;
+};
+
+static mutex_t s_lock = MUTEX_INITIALIZER;
+static TraceRing *s_rings = NULL;
+static int s_nextId = 1;
+static thread_store_t s_tls = THREAD_STORE_INITIALIZER;
+
+static enum { TRACE_UNKNOWN, TRACE_OFF, TRACE_ON } s_state = TRACE_UNKNOWN;
+static const char *s_path = NULL;
+// set by SIGUSR2, the dump is done by the next traced call
+static volatile int s_dumpRequested = 0;
+
+static void dumpAtExit()
+{
+    codecTraceDump(s_path);
+}
+
+#ifndef _WIN32
+static void onDumpSignal(int sig)
+{
+    s_dumpRequested = 1;
+}
+
+static void installDumpSignal()
+{
+    struct sigaction sa;
+    if (sigaction(SIGUSR2, NULL, &sa) != 0 || sa.sa_handler != SIG_DFL) {
+        return;     // the process uses it
+    }
+    sa.sa_handler = onDumpSignal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &sa, NULL);
+}
+#endif
+
+static bool traceEnabled()
+{
+    if (s_state == TRACE_UNKNOWN) {
+        mutex_lock(&s_lock);
+        if (s_state == TRACE_UNKNOWN) {
+            s_path = getenv("ANDROID_GL_TRACE_FILE");
+            if (s_path && *s_path) {
+                atexit(dumpAtExit);
+#ifndef _WIN32
+                installDumpSignal();
+#endif
+                s_state = TRACE_ON;
+            } else {
+                s_state = TRACE_OFF;
+            }
+        }
+        mutex_unlock(&s_lock);
+    }
+    return s_state == TRACE_ON;
+}
+
+static void releaseRing(void *ring)
+{
+    // the events are kept for the dump, the ring is reused, with a new
+    // id, by the next thread that starts tracing.
+    ((TraceRing *)ring)->active = false;
+}
+
+static TraceRing *threadRing()
+{
+    TraceRing *ring = (TraceRing *)thread_store_get(&s_tls);
+    if (ring) {
+        return ring;
+    }
+
+    mutex_lock(&s_lock);
+    for (ring = s_rings; ring != NULL; ring = ring->next) {
+        if (!ring->active) {
+            break;
+        }
+    }
+    if (!ring) {
+        ring = (TraceRing *)calloc(1, sizeof(TraceRing));
+        if (ring) {
+            ring->next = s_rings;
+            s_rings = ring;
+        }
+    }
+    if (ring) {
+        ring->id = s_nextId++;
+        ring->active = true;
+    }
+    mutex_unlock(&s_lock);
+
+    if (ring) {
+        thread_store_set(&s_tls, ring, releaseRing);
+    }
+    return ring;
+}
+
+uint64_t codecTraceBegin()
+{
+    if (!traceEnabled()) {
+        return 0;
+    }
+    return GetCurrentTimeNS();
+}
+
+void codecTraceEnd(const char *category, const char *name,
+                   uint64_t start, uint32_t bytes)
+{
+    TraceRing *ring = threadRing();
+    if (!ring) {
+        return;
+    }
+
+    uint32_t head = ring->head;
+    TraceEvent *ev = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    ev->category = category;
+    ev->name = name;
+    ev->start = start;
+    ev->duration = (uint32_t)(GetCurrentTimeNS() - start);
+    ev->bytes = bytes;
+    ev->tid = ring->id;
+    __sync_synchronize();
+    ring->head = head + 1;
+
+    if (s_dumpRequested && __sync_bool_compare_and_swap(&s_dumpRequested, 1, 0)) {
+        codecTraceDump(s_path);
+    }
+}
+
+int codecTraceDump(const char *path)
+{
+    if (!path) {
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "codecTraceDump: can't open %s\n", path);
+        return -1;
+    }
+
+    int pid = (int)getpid();
+    bool first = true;
+    fprintf(fp, "{\"traceEvents\":[\n");
+
+    mutex_lock(&s_lock);
+    for (TraceRing *ring = s_rings; ring != NULL; ring = ring->next) {
+        uint32_t head = ring->head;
+        uint32_t count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+        for (uint32_t i = head - count; i != head; i++) {
+            const TraceEvent *ev = &ring->events[i & (TRACE_RING_SIZE - 1)];
+            fprintf(fp, "%s{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"X\","
+                    "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,"
+                    "\"args\":{\"bytes\":%u}}",
+                    first ? "" : ",\n", ev->category, ev->name,
+                    ev->start / 1000.0, ev->duration / 1000.0,
+                    pid, ev->tid, ev->bytes);
+            first = false;
+        }
+    }
+    mutex_unlock(&s_lock);
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    return 0;
+}
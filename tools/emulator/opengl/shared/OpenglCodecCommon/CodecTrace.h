@@ -0,0 +1,57 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _CODEC_TRACE_H
+#define _CODEC_TRACE_H
+
+#include <stdint.h>
+
+//
+// Per call tracing of the generated encoders and decoders.
+//
+// The hooks are compiled in only when CODEC_TRACE is defined, which the
+// codec modules do when BUILD_EMULATOR_OPENGL_TRACE is set, and record
+// nothing unless the ANDROID_GL_TRACE_FILE environment variable names a
+// file. Each thread records the start time, duration and parameters size
+// of the calls it makes into a ring of its own, without taking any lock;
+// once the ring is full the oldest events are overwritten. The events of
+// all threads are written to the file, in the Chrome trace event format
+// (chrome://tracing), at exit, when codecTraceDump() is called, or on the
+// next traced call after the process got SIGUSR2 (unless the process
+// handles that signal itself).
+//
+#ifdef CODEC_TRACE
+
+#define CODEC_TRACE_BEGIN() \
+    uint64_t __codecTraceStart = codecTraceBegin()
+#define CODEC_TRACE_END(category, name, bytes) \
+    if (__codecTraceStart) codecTraceEnd(category, name, __codecTraceStart, bytes)
+
+#else
+
+#define CODEC_TRACE_BEGIN()
+#define CODEC_TRACE_END(category, name, bytes)
+
+#endif
+
+// returns the start time of the call or 0 if tracing is disabled.
+uint64_t codecTraceBegin();
+// category and name must be string literals, only their address is kept.
+void codecTraceEnd(const char *category, const char *name,
+                   uint64_t start, uint32_t bytes);
+// writes the events recorded so far, returns 0 on success.
+int codecTraceDump(const char *path);
+
+#endif
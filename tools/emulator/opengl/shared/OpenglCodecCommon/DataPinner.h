@@ -0,0 +1,40 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _DATA_PINNER_H
+#define _DATA_PINNER_H
+
+#include <stddef.h>
+
+//
+// DataPinner - lets a decoder keep using parameter data in the receive
+// buffer it was decoded from after the packet was consumed, instead of
+// copying it out. The client arrays of a draw come in the packets that
+// precede it, so the decoders pin the pointer data they receive and
+// release all of it once the draw ran.
+//
+class DataPinner {
+public:
+    virtual ~DataPinner() {}
+
+    // keeps the len bytes at data in place until unpinAll(). Returns
+    // false if they are not in the receive buffer, are not 4 byte
+    // aligned as GL reads arrays, or cannot be pinned; the caller has
+    // to copy them then.
+    virtual bool pin(const void *data, size_t len) = 0;
+    virtual void unpinAll() = 0;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "DecoderStats.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+
+DecoderStats::DecoderStats(const char *api, int baseOpcode, int numOpcodes,
+                           const char * const *names) :
+    m_api(api),
+    m_base(baseOpcode),
+    m_count(numOpcodes),
+    m_names(names),
+    m_enabled(true)
+{
+    m_stats = new OpcodeStats[numOpcodes];
+    reset();
+}
+
+DecoderStats::~DecoderStats()
+{
+    delete [] m_stats;
+}
+
+uint64_t DecoderStats::now()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    static bool bNotInit = true;
+    if ( bNotInit ) {
+        bNotInit = (QueryPerformanceFrequency( &freq ) == FALSE);
+    }
+    LARGE_INTEGER currVal;
+    QueryPerformanceCounter( &currVal );
+
+    return (uint64_t)((double)currVal.QuadPart * 1e9 / (double)freq.QuadPart);
+
+#elif defined(__linux__)
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+#else
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_usec * 1000ULL;
+
+#endif
+}
+
+int DecoderStats::copy(int opcode, int count, void *out) const
+{
+    if (!hasOpcode(opcode) || count < 0) {
+        return -1;
+    }
+
+    if (count > m_base + m_count - opcode) {
+        count = m_base + m_count - opcode;
+    }
+    memcpy(out, &m_stats[opcode - m_base], count * sizeof(OpcodeStats));
+    return count;
+}
+
+void DecoderStats::dumpJson(FILE *fp, long long timeMS, int connection) const
+{
+    for (int i = 0; i < m_count; i++) {
+        const OpcodeStats *s = &m_stats[i];
+        if (s->calls == 0) {
+            continue;
+        }
+        fprintf(fp, "{\"time_ms\":%lld,\"conn\":%d,\"api\":\"%s\","
+                    "\"op\":\"%s\",\"opcode\":%d,\"calls\":%llu,\"bytes\":%llu,"
+                    "\"ns\":%llu,\"round_trips\":%llu}\n",
+                timeMS, connection, m_api, m_names[i], m_base + i,
+                (unsigned long long)s->calls,
+                (unsigned long long)s->bytes,
+                (unsigned long long)s->nsecs,
+                (unsigned long long)s->roundTrips);
+    }
+}
+
+void DecoderStats::reset()
+{
+    memset(m_stats, 0, m_count * sizeof(OpcodeStats));
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _DECODER_STATS_H
+#define _DECODER_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+//
+// Per opcode counters kept by the generated decoders. The layout is
+// also the one returned to the guest by rcGetOpcodeStats.
+//
+struct OpcodeStats {
+    uint64_t calls;
+    uint64_t bytes;         // packet bytes, header included
+    uint64_t nsecs;         // time spent decoding and executing the call
+    uint64_t roundTrips;    // calls that sent back a reply
+};
+
+//
+// DecoderStats - the counters of all the opcodes of one decoder, i.e.
+// of one api on one connection. Counting costs two clock reads per call,
+// it is on by default and can be turned off with setEnabled().
+//
+class DecoderStats {
+public:
+    DecoderStats(const char *api, int baseOpcode, int numOpcodes,
+                 const char * const *names);
+    ~DecoderStats();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+
+    // monotonic time in nanoseconds
+    static uint64_t now();
+
+    // opcode must be one of the decoder's opcodes
+    void record(int opcode, unsigned int bytes, uint64_t startTime, bool roundTrip) {
+        OpcodeStats *s = &m_stats[opcode - m_base];
+        s->calls++;
+        s->bytes += bytes;
+        s->nsecs += now() - startTime;
+        if (roundTrip) {
+            s->roundTrips++;
+        }
+    }
+
+    const char *api() const { return m_api; }
+    bool hasOpcode(int opcode) const {
+        return opcode >= m_base && opcode < m_base + m_count;
+    }
+
+    // copies the counters of up to count opcodes starting at opcode into
+    // out, which needs not be aligned. Returns the number of entries
+    // copied or -1 if opcode does not belong to this decoder.
+    int copy(int opcode, int count, void *out) const;
+
+    // writes one JSON object per line for every opcode that was called,
+    // with the cumulative counters since the decoder was created.
+    void dumpJson(FILE *fp, long long timeMS, int connection) const;
+
+    void reset();
+
+private:
+    const char *m_api;
+    int m_base;
+    int m_count;
+    const char * const *m_names;
+    bool m_enabled;
+    OpcodeStats *m_stats;
+};
+
+#endif
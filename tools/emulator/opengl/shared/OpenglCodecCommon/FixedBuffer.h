@@ -16,6 +16,8 @@
 #ifndef _FIXED_BUFFER_H
 #define _FIXED_BUFFER_H
 
+#include <new>
+
 class FixedBuffer {
 public:
     FixedBuffer(size_t initialSize = 0) {
@@ -25,17 +27,19 @@ public:
     }
 
     ~FixedBuffer() {
-        delete m_buffer;
+        delete [] m_buffer;
         m_bufferLen = 0;
     }
 
     void * alloc(size_t size) {
         if (m_bufferLen >= size) return (void *)(m_buffer);
 
-        if (m_buffer != NULL) delete m_buffer;
+        if (m_buffer != NULL) delete [] m_buffer;
 
-        m_bufferLen = size;
-        m_buffer = new unsigned char[m_bufferLen];
+        // grow geometrically, buffers that keep growing are reallocated
+        // a few times only
+        m_bufferLen = size < 2 * m_bufferLen ? 2 * m_bufferLen : size;
+        m_buffer = new (std::nothrow) unsigned char[m_bufferLen];
         if (m_buffer == NULL) m_bufferLen = 0;
 
         return m_buffer;
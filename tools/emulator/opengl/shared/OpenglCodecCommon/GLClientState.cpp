@@ -28,12 +28,15 @@ GLClientState::GLClientState(int nLocations)
     }
     m_nLocations = nLocations;
     m_states = new VertexAttribState[m_nLocations];
+    m_interleaved = new int[m_nLocations];
+    m_interleavedAttribs = new GLuint[m_nLocations * CODEC_INTERLEAVED_FIELDS];
     for (int i = 0; i < m_nLocations; i++) {
         m_states[i].enabled = 0;
         m_states[i].enableDirty = false;
     }
     m_currentArrayVbo = 0;
     m_currentIndexVbo = 0;
+    m_pendingError = 0;
     // init gl constans;
     m_states[VERTEX_LOCATION].glConst = GL_VERTEX_ARRAY;
     m_states[NORMAL_LOCATION].glConst = GL_NORMAL_ARRAY;
@@ -58,6 +61,96 @@ GLClientState::GLClientState(int nLocations)
 GLClientState::~GLClientState()
 {
     delete m_states;
+    delete [] m_interleaved;
+    delete [] m_interleavedAttribs;
+}
+
+int GLClientState::findInterleavedArrays(unsigned int count)
+{
+    int nGroups = 0;
+    for (int i = 0; i < m_nLocations; i++) {
+        m_interleaved[i] = -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < m_nLocations; i++) {
+        const VertexAttribState *a = &m_states[i];
+        if (!a->enabled || a->bufferObject != 0 || a->data == NULL ||
+            a->stride == 0 || m_interleaved[i] != -1) {
+            continue;
+        }
+        uintptr_t lo = (uintptr_t)a->data;
+        uintptr_t hi = lo + a->elementSize;
+        size_t used = a->elementSize;
+        int members = 1;
+        m_interleaved[i] = i;
+
+        for (int j = i + 1; j < m_nLocations; j++) {
+            const VertexAttribState *b = &m_states[j];
+            if (!b->enabled || b->bufferObject != 0 || b->data == NULL ||
+                b->stride != a->stride || m_interleaved[j] != -1) {
+                continue;
+            }
+            uintptr_t p = (uintptr_t)b->data;
+            uintptr_t newLo = p < lo ? p : lo;
+            uintptr_t newHi = p + b->elementSize > hi ? p + b->elementSize : hi;
+            if (newHi - newLo > (uintptr_t)a->stride) {
+                continue;
+            }
+            lo = newLo;
+            hi = newHi;
+            used += b->elementSize;
+            members++;
+            m_interleaved[j] = i;
+        }
+
+        // the block also carries the bytes of the arrays that are not
+        // enabled, it must not be larger than the arrays sent apart.
+        size_t blockSize = (count - 1) * a->stride + (hi - lo);
+        if (members < 2 || blockSize > used * count) {
+            for (int j = i; j < m_nLocations; j++) {
+                if (m_interleaved[j] == i) m_interleaved[j] = -1;
+            }
+            continue;
+        }
+        nGroups++;
+    }
+    return nGroups;
+}
+
+int GLClientState::getInterleavedBlock(int lead, unsigned int first, unsigned int count,
+                                       const GLuint **attribs, unsigned char **data,
+                                       GLuint *datalen, GLsizei *stride)
+{
+    uintptr_t lo = (uintptr_t)m_states[lead].data;
+    uintptr_t hi = lo;
+    for (int i = lead; i < m_nLocations; i++) {
+        if (m_interleaved[i] != lead) continue;
+        uintptr_t p = (uintptr_t)m_states[i].data;
+        if (p < lo) lo = p;
+        if (p + m_states[i].elementSize > hi) hi = p + m_states[i].elementSize;
+    }
+
+    int n = 0;
+    for (int i = lead; i < m_nLocations; i++) {
+        if (m_interleaved[i] != lead) continue;
+        const VertexAttribState *state = &m_states[i];
+        GLuint *rec = m_interleavedAttribs + n * CODEC_INTERLEAVED_FIELDS;
+        rec[CODEC_INTERLEAVED_LOCATION] = i;
+        rec[CODEC_INTERLEAVED_SIZE] = state->size;
+        rec[CODEC_INTERLEAVED_TYPE] = state->type;
+        rec[CODEC_INTERLEAVED_NORMALIZED] = state->normalized;
+        rec[CODEC_INTERLEAVED_OFFSET] = (uintptr_t)state->data - lo;
+        n++;
+    }
+
+    *stride = m_states[lead].stride;
+    *attribs = m_interleavedAttribs;
+    *data = (unsigned char *)lo + first * *stride;
+    *datalen = (count - 1) * *stride + (hi - lo);
+    return n;
 }
 
 void GLClientState::enable(int location, int state)
@@ -29,8 +29,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "ErrorLog.h"
 #include "codec_defs.h"
+#include "GLStateShadow.h"
+#include "ProgramCache.h"
+#include "VertexArrayCache.h"
 
 class GLClientState {
 public:
@@ -84,8 +88,27 @@ public:
     const VertexAttribState  *getState(int location);
     const VertexAttribState  *getStateAndEnableDirty(int location, bool *enableChanged);
     int getLocation(GLenum loc);
+
+    // Groups the enabled client arrays that share one interleaved block,
+    // when sending 'count' vertices of the block costs no more than
+    // sending the arrays apart. Returns the number of groups, see
+    // interleavedGroup().
+    int findInterleavedArrays(unsigned int count);
+    // the first location of the group of 'location', or -1 if none.
+    int interleavedGroup(int location) const { return m_interleaved[location]; }
+    // the block of the group led by 'lead' for vertices first to first +
+    // count - 1, and the glInterleavedPointerData attribute records of
+    // its arrays. Returns the number of records.
+    int getInterleavedBlock(int lead, unsigned int first, unsigned int count,
+                            const GLuint **attribs, unsigned char **data,
+                            GLuint *datalen, GLsizei *stride);
     void setActiveTexture(int texUnit) {m_activeTexture = texUnit; };
     int getActiveTexture() const { return m_activeTexture; }
+    GLStateShadow *shadow() { return &m_shadow; }
+    VertexArrayCache *vertexArrayCache() { return &m_vertexArrayCache; }
+    ProgramCache *programCache() { return &m_programCache; }
+    // the error that came with a reply and was not taken yet, see ReplyStatus
+    uint32_t *pendingError() { return &m_pendingError; }
 
     int bindBuffer(GLenum target, GLuint id)
     {
@@ -124,9 +147,15 @@ private:
     PixelStoreState m_pixelStore;
     VertexAttribState *m_states;
     int m_nLocations;
+    int *m_interleaved;
+    GLuint *m_interleavedAttribs;
     GLuint m_currentArrayVbo;
     GLuint m_currentIndexVbo;
     int m_activeTexture;
+    GLStateShadow m_shadow;
+    VertexArrayCache m_vertexArrayCache;
+    ProgramCache m_programCache;
+    uint32_t m_pendingError;
 
 
     bool validLocation(int location) { return (location >= 0 && location < m_nLocations); }
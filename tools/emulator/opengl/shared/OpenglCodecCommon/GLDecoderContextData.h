@@ -19,6 +19,7 @@
 #include <assert.h>
 #include <string.h>
 #include "FixedBuffer.h"
+#include "DataPinner.h"
 #include "codec_defs.h"
 
 class  GLDecoderContextData {
@@ -45,24 +46,38 @@ public:
         m_nLocations(nLocations)
     {
         m_pointerData = new FixedBuffer[m_nLocations];
+        m_pinnedData = new void *[m_nLocations];
+        memset(m_pinnedData, 0, m_nLocations * sizeof(void *));
     }
 
     ~GLDecoderContextData() {
-        delete m_pointerData;
+        delete [] m_pointerData;
+        delete [] m_pinnedData;
     }
 
-    void storePointerData(unsigned int loc, void *data, size_t len) {
+    // stages the client array data of a location. If pinner is not NULL
+    // and pins the data where it was received, the data is used in place
+    // until the next draw releases it; otherwise it is copied.
+    void storePointerData(unsigned int loc, void *data, size_t len, DataPinner *pinner = NULL) {
 
         assert(loc < m_nLocations);
+        if (pinner != NULL && pinner->pin(data, len)) {
+            m_pinnedData[loc] = data;
+            return;
+        }
+        m_pinnedData[loc] = NULL;
         m_pointerData[loc].alloc(len);
         memcpy(m_pointerData[loc].ptr(), data, len);
     }
+    // the data last stored for loc, only valid until the next draw
     void *pointerData(unsigned int loc) {
         assert(loc < m_nLocations);
-        return m_pointerData[loc].ptr();
+        return m_pinnedData[loc] != NULL ? m_pinnedData[loc] : m_pointerData[loc].ptr();
     }
+    unsigned int nLocations() const { return m_nLocations; }
 private:
     FixedBuffer *m_pointerData;
+    void **m_pinnedData;        // NULL where the data was copied
     int m_nLocations;
 };
 
@@ -0,0 +1,301 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "GLStateShadow.h"
+#include <string.h>
+
+GLStateShadow::GLStateShadow() :
+    m_api(GLES1)
+{
+    m_maxTextureUnits.known = false;
+    reset();
+}
+
+void GLStateShadow::setApi(Api api)
+{
+    if (api != m_api) {
+        m_api = api;
+        m_maxTextureUnits.known = false;
+        reset();
+    }
+}
+
+void GLStateShadow::reset()
+{
+    memset(m_textures, 0, sizeof(m_textures));
+    m_capsKnown = 0;
+    m_capsEnabled = 0;
+
+    Value *values[] = { &m_activeTexture, &m_program, &m_depthFunc,
+                        &m_depthMask, &m_cullFace, &m_frontFace,
+                        &m_blend[0], &m_blend[1], &m_blend[2], &m_blend[3] };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        values[i]->known = false;
+    }
+
+    // GL defaults
+    m_activeTexture.set(0);
+    m_program.set(0);
+    for (int i = 0; i < SHADOW_MAX_TEXTURE_UNITS; i++) {
+        for (int t = 0; t < TEXTURE_TARGETS; t++) {
+            m_textures[i][t].set(0);
+        }
+    }
+}
+
+int GLStateShadow::gl2CapIndex(GLenum cap)
+{
+    switch(cap) {
+    case GL_BLEND:                      return 0;
+    case GL_CULL_FACE:                  return 1;
+    case GL_DEPTH_TEST:                 return 2;
+    case GL_DITHER:                     return 3;
+    case GL_POLYGON_OFFSET_FILL:        return 4;
+    case GL_SAMPLE_ALPHA_TO_COVERAGE:   return 5;
+    case GL_SAMPLE_COVERAGE:            return 6;
+    case GL_SCISSOR_TEST:               return 7;
+    case GL_STENCIL_TEST:               return 8;
+    }
+    return -1;
+}
+
+int GLStateShadow::capIndex(GLenum cap) const
+{
+    if (m_api == GLES2) {
+        return gl2CapIndex(cap);
+    }
+    // texture targets are enabled per texture unit in GLES 1, they are
+    // not shadowed.
+    switch(cap) {
+    case GL_ALPHA_TEST:                 return 0;
+    case GL_BLEND:                      return 1;
+    case GL_COLOR_LOGIC_OP:             return 2;
+    case GL_COLOR_MATERIAL:             return 3;
+    case GL_CULL_FACE:                  return 4;
+    case GL_DEPTH_TEST:                 return 5;
+    case GL_DITHER:                     return 6;
+    case GL_FOG:                        return 7;
+    case GL_LIGHTING:                   return 8;
+    case GL_LINE_SMOOTH:                return 9;
+    case GL_MULTISAMPLE:                return 10;
+    case GL_NORMALIZE:                  return 11;
+    case GL_POINT_SMOOTH:               return 12;
+    case GL_POINT_SPRITE_OES:           return 13;
+    case GL_POLYGON_OFFSET_FILL:        return 14;
+    case GL_RESCALE_NORMAL:             return 15;
+    case GL_SAMPLE_ALPHA_TO_COVERAGE:   return 16;
+    case GL_SAMPLE_ALPHA_TO_ONE:        return 17;
+    case GL_SAMPLE_COVERAGE:            return 18;
+    case GL_SCISSOR_TEST:               return 19;
+    case GL_STENCIL_TEST:               return 20;
+    }
+    if (cap >= GL_LIGHT0 && cap <= GL_LIGHT7) {
+        return 21 + cap - GL_LIGHT0;
+    }
+    if (cap >= GL_CLIP_PLANE0 && cap <= GL_CLIP_PLANE5) {
+        return 29 + cap - GL_CLIP_PLANE0;
+    }
+    return -1;
+}
+
+int GLStateShadow::textureTargetIndex(GLenum target)
+{
+    switch(target) {
+    case GL_TEXTURE_2D:             return 0;
+    case GL_TEXTURE_CUBE_MAP:       return 1;
+    case GL_TEXTURE_EXTERNAL_OES:   return 2;
+    }
+    return -1;
+}
+
+bool GLStateShadow::enable(GLenum cap, bool enabled)
+{
+    int index = capIndex(cap);
+    if (index < 0) {
+        return true;
+    }
+    uint64_t bit = 1ULL << index;
+    if ((m_capsKnown & bit) && ((m_capsEnabled & bit) != 0) == enabled) {
+        return false;
+    }
+    m_capsKnown |= bit;
+    if (enabled) {
+        m_capsEnabled |= bit;
+    } else {
+        m_capsEnabled &= ~bit;
+    }
+    return true;
+}
+
+bool GLStateShadow::isEnabled(GLenum cap, GLboolean *enabled) const
+{
+    int index = capIndex(cap);
+    if (index < 0 || !(m_capsKnown & (1ULL << index))) {
+        return false;
+    }
+    *enabled = (m_capsEnabled & (1ULL << index)) ? GL_TRUE : GL_FALSE;
+    return true;
+}
+
+bool GLStateShadow::activeTexture(GLenum texture)
+{
+    GLint unit = texture - GL_TEXTURE0;
+    if (!m_maxTextureUnits.known || unit < 0 || unit >= m_maxTextureUnits.value ||
+        unit >= SHADOW_MAX_TEXTURE_UNITS) {
+        // out of what we track or of what the server has, the bindings
+        // are not shadowed until a tracked unit is selected again.
+        m_activeTexture.known = false;
+        return true;
+    }
+    return m_activeTexture.set(unit);
+}
+
+bool GLStateShadow::bindTexture(GLenum target, GLuint texture)
+{
+    int t = textureTargetIndex(target);
+    if (t < 0 || !m_activeTexture.known) {
+        return true;
+    }
+    return m_textures[m_activeTexture.value][t].set(texture);
+}
+
+void GLStateShadow::deleteTextures(GLsizei n, const GLuint *textures)
+{
+    // deleted textures that are bound revert to the default texture
+    for (GLsizei i = 0; i < n; i++) {
+        if (textures[i] == 0) continue;
+        for (int u = 0; u < SHADOW_MAX_TEXTURE_UNITS; u++) {
+            for (int t = 0; t < TEXTURE_TARGETS; t++) {
+                if (m_textures[u][t].value == (GLint)textures[i]) {
+                    m_textures[u][t].value = 0;
+                }
+            }
+        }
+    }
+}
+
+bool GLStateShadow::isBlendFactor(GLenum factor, bool src) const
+{
+    switch(factor) {
+    case GL_ZERO:
+    case GL_ONE:
+    case GL_SRC_ALPHA:
+    case GL_ONE_MINUS_SRC_ALPHA:
+    case GL_DST_ALPHA:
+    case GL_ONE_MINUS_DST_ALPHA:
+        return true;
+    case GL_SRC_COLOR:
+    case GL_ONE_MINUS_SRC_COLOR:
+        return m_api == GLES2 || !src;
+    case GL_DST_COLOR:
+    case GL_ONE_MINUS_DST_COLOR:
+        return m_api == GLES2 || src;
+    case GL_SRC_ALPHA_SATURATE:
+        return src;
+    case GL_CONSTANT_COLOR:
+    case GL_ONE_MINUS_CONSTANT_COLOR:
+    case GL_CONSTANT_ALPHA:
+    case GL_ONE_MINUS_CONSTANT_ALPHA:
+        return m_api == GLES2;
+    }
+    return false;
+}
+
+bool GLStateShadow::blendFuncSeparate(GLenum srcRGB, GLenum dstRGB,
+                                      GLenum srcAlpha, GLenum dstAlpha)
+{
+    // the server keeps all four values if one is invalid
+    if (!isBlendFactor(srcRGB, true) || !isBlendFactor(dstRGB, false) ||
+        !isBlendFactor(srcAlpha, true) || !isBlendFactor(dstAlpha, false)) {
+        return true;
+    }
+    // not short circuited, all four are recorded
+    bool changed = m_blend[0].set(srcRGB);
+    changed |= m_blend[1].set(dstRGB);
+    changed |= m_blend[2].set(srcAlpha);
+    changed |= m_blend[3].set(dstAlpha);
+    return changed;
+}
+
+bool GLStateShadow::useProgram(GLuint program)
+{
+    return m_program.set(program);
+}
+
+bool GLStateShadow::depthFunc(GLenum func)
+{
+    if (func < GL_NEVER || func > GL_ALWAYS) {
+        return true;
+    }
+    return m_depthFunc.set(func);
+}
+
+bool GLStateShadow::cullFace(GLenum mode)
+{
+    if (mode != GL_FRONT && mode != GL_BACK && mode != GL_FRONT_AND_BACK) {
+        return true;
+    }
+    return m_cullFace.set(mode);
+}
+
+bool GLStateShadow::frontFace(GLenum mode)
+{
+    if (mode != GL_CW && mode != GL_CCW) {
+        return true;
+    }
+    return m_frontFace.set(mode);
+}
+
+bool GLStateShadow::getIntParameter(GLenum param, GLint *value) const
+{
+    const Value *v = NULL;
+    switch(param) {
+    case GL_ACTIVE_TEXTURE:
+        if (m_activeTexture.known) {
+            *value = GL_TEXTURE0 + m_activeTexture.value;
+            return true;
+        }
+        return false;
+    case GL_TEXTURE_BINDING_2D:
+    case GL_TEXTURE_BINDING_CUBE_MAP:
+    case GL_TEXTURE_BINDING_EXTERNAL_OES:
+    case GL_CURRENT_PROGRAM:
+        // possibly rejected by the server, see the class comment
+        return false;
+    case GL_BLEND_SRC:
+    case GL_BLEND_SRC_RGB:      v = &m_blend[0]; break;
+    case GL_BLEND_DST:
+    case GL_BLEND_DST_RGB:      v = &m_blend[1]; break;
+    case GL_BLEND_SRC_ALPHA:    v = &m_blend[2]; break;
+    case GL_BLEND_DST_ALPHA:    v = &m_blend[3]; break;
+    case GL_DEPTH_FUNC:         v = &m_depthFunc; break;
+    case GL_DEPTH_WRITEMASK:    v = &m_depthMask; break;
+    case GL_CULL_FACE_MODE:     v = &m_cullFace; break;
+    case GL_FRONT_FACE:         v = &m_frontFace; break;
+    default: {
+        GLboolean enabled;
+        if (isEnabled(param, &enabled)) {
+            *value = enabled;
+            return true;
+        }
+        return false;
+        }
+    }
+    if (!v->known) {
+        return false;
+    }
+    *value = v->value;
+    return true;
+}
@@ -0,0 +1,157 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _GL_STATE_SHADOW_H_
+#define _GL_STATE_SHADOW_H_
+
+#ifdef GL_API
+    #undef GL_API
+#endif
+#define GL_API
+
+#ifdef GL_APIENTRY
+    #undef GL_APIENTRY
+#endif
+
+#ifdef GL_APIENTRYP
+    #undef GL_APIENTRYP
+#endif
+#define GL_APIENTRYP
+
+#ifndef ANDROID
+#define GL_APIENTRY
+#endif
+
+#include <GLES/gl.h>
+#include <GLES/glext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include <stdint.h>
+
+#define SHADOW_MAX_TEXTURE_UNITS 32
+
+//
+// GLStateShadow - a copy of the part of the server GL state that
+// applications set over and over: capabilities, the active texture and
+// texture bindings, the blend functions, the current program and a few
+// depth and face settings.
+//
+// The setters return false when the call would not change the state, in
+// which case it need not be sent. Values are unknown, and calls that set
+// them are always sent, until set once, except the active texture,
+// texture bindings and program which start at their GL defaults; the
+// shadow must therefore be created along with its context. The getters
+// answer glGet*() and glIsEnabled() for known values and return false
+// otherwise.
+//
+// Only the capabilities of the api set with setApi() are shadowed, and
+// texture units are not until the server limit, queried with
+// maxTextureUnitsParam(), is given to setMaxTextureUnits(). Enum values
+// the api does not accept are not recorded either, and the setters
+// return true for them so that the server raises the error each time.
+// As binding a texture or using a program also fails on objects of the
+// wrong kind, the bindings and the program only filter calls and are
+// never answered to queries.
+//
+class GLStateShadow {
+public:
+    enum Api { GLES1, GLES2 };
+
+    GLStateShadow();
+    // forgets every value, which then need to be set again.
+    void reset();
+    // the capabilities differ between the apis, changing it resets.
+    void setApi(Api api);
+
+    bool maxTextureUnitsKnown() const { return m_maxTextureUnits.known; }
+    GLenum maxTextureUnitsParam() const {
+        return m_api == GLES2 ? GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS : GL_MAX_TEXTURE_UNITS;
+    }
+    void setMaxTextureUnits(GLint units) { m_maxTextureUnits.set(units); }
+
+    bool enable(GLenum cap, bool enabled);
+    bool activeTexture(GLenum texture);
+    bool bindTexture(GLenum target, GLuint texture);
+    void deleteTextures(GLsizei n, const GLuint *textures);
+    bool blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+    bool blendFunc(GLenum src, GLenum dst) { return blendFuncSeparate(src, dst, src, dst); }
+    bool useProgram(GLuint program);
+    // the program to use might have been rejected before it was linked
+    void programLinked() { m_program.known = false; }
+    bool depthFunc(GLenum func);
+    bool depthMask(GLboolean flag) { return m_depthMask.set(flag ? GL_TRUE : GL_FALSE); }
+    bool cullFace(GLenum mode);
+    bool frontFace(GLenum mode);
+
+    bool isEnabled(GLenum cap, GLboolean *enabled) const;
+
+    template <class T>
+    bool getParameter(GLenum param, T *ptr) const
+    {
+        GLint value;
+        if (!getIntParameter(param, &value)) {
+            return false;
+        }
+        *ptr = (T)value;
+        return true;
+    }
+
+private:
+    struct Value {
+        bool known;
+        GLint value;
+        bool set(GLint v) {
+            if (known && value == v) return false;
+            known = true;
+            value = v;
+            return true;
+        }
+    };
+
+    int capIndex(GLenum cap) const;
+    static int gl2CapIndex(GLenum cap);
+    bool isBlendFactor(GLenum factor, bool src) const;
+    static int textureTargetIndex(GLenum target);
+    bool getIntParameter(GLenum param, GLint *value) const;
+
+    enum { TEXTURE_TARGETS = 3 };
+
+    Api m_api;
+    Value m_maxTextureUnits;
+    uint64_t m_capsKnown;
+    uint64_t m_capsEnabled;
+    Value m_activeTexture;      // unit index
+    Value m_textures[SHADOW_MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    Value m_blend[4];           // src rgb, dst rgb, src alpha, dst alpha
+    Value m_program;
+    Value m_depthFunc;
+    Value m_depthMask;
+    Value m_cullFace;
+    Value m_frontFace;
+};
+
+template <>
+inline bool GLStateShadow::getParameter<GLboolean>(GLenum param, GLboolean *ptr) const
+{
+    GLint value;
+    if (!getIntParameter(param, &value)) {
+        return false;
+    }
+    *ptr = value != 0 ? GL_TRUE : GL_FALSE;
+    return true;
+}
+
+#endif
@@ -0,0 +1,230 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "OpcodeDispatcher.h"
+#include "ErrorLog.h"
+#include "ProtocolUtils.h"
+#include <string.h>
+
+OpcodeDispatcher::OpcodeDispatcher() :
+    m_table(NULL),
+    m_base(0),
+    m_count(0),
+    m_failed(false),
+    m_packetFormat(PACKET_FORMAT_CLASSIC),
+    m_replyStatusProc(NULL),
+    m_replyStatusData(NULL)
+{
+}
+
+OpcodeDispatcher::~OpcodeDispatcher()
+{
+    delete [] m_table;
+}
+
+bool OpcodeDispatcher::addDecoder(const DecoderInfo *info, void *decoder,
+                                  DecoderStats *stats)
+{
+    unsigned int first = info->baseOpcode;
+    unsigned int last = info->baseOpcode + info->numOpcodes;
+
+    for (unsigned int op = first; op < last; op++) {
+        if (op - m_base < m_count && m_table[op - m_base].handler != NULL) {
+            ERR("OpcodeDispatcher: %s opcode %u is already used\n", info->api, op);
+            return false;
+        }
+    }
+
+    //
+    // grow the table to cover both the current and the new range
+    //
+    if (m_count > 0) {
+        if (m_base < first) first = m_base;
+        if (m_base + m_count > last) last = m_base + m_count;
+    }
+
+    if (first != m_base || last - first != m_count) {
+        Slot *table = new Slot[last - first];
+        memset(table, 0, (last - first) * sizeof(Slot));
+        if (m_count > 0) {
+            memcpy(table + (m_base - first), m_table, m_count * sizeof(Slot));
+        }
+        delete [] m_table;
+        m_table = table;
+        m_base = first;
+        m_count = last - first;
+    }
+
+    for (unsigned int i = 0; i < info->numOpcodes; i++) {
+        Slot *s = &m_table[info->baseOpcode + i - m_base];
+        s->handler = info->handlers[i];
+        s->decoder = decoder;
+        s->stats = stats;
+        s->flags = info->flags[i];
+        s->paramSize = info->paramSizes[i];
+    }
+    return true;
+}
+
+bool OpcodeDispatcher::setPacketFormat(unsigned int format)
+{
+    if (format != PACKET_FORMAT_CLASSIC && format != PACKET_FORMAT_COMPACT) {
+        ERR("OpcodeDispatcher: unknown packet format %u\n", format);
+        return false;
+    }
+    m_packetFormat = format;
+    return true;
+}
+
+//
+// parseHeader - parses the header of the packet at ptr, of which avail
+// bytes were received. Returns the size of the whole packet, or 0 if the
+// header is incomplete or invalid, in which case m_failed is set.
+//
+size_t OpcodeDispatcher::parseHeader(const unsigned char *ptr, size_t avail,
+                                     unsigned int *out_opcode, size_t *out_headerLen)
+{
+    if (m_packetFormat == PACKET_FORMAT_CLASSIC) {
+        if (avail < CLASSIC_HEADER_SIZE) {
+            return 0;
+        }
+        unsigned int opcode = Unpack<uint32_t>(ptr);
+        unsigned int packetLen = Unpack<uint32_t>(ptr + 4);
+        if (packetLen < CLASSIC_HEADER_SIZE) {
+            ERR("OpcodeDispatcher: invalid packet length %u (opcode %u)\n",
+                packetLen, opcode);
+            m_failed = true;
+            return 0;
+        }
+        *out_opcode = opcode;
+        *out_headerLen = CLASSIC_HEADER_SIZE;
+        return packetLen;
+    }
+
+    if (avail < 2) {
+        return 0;
+    }
+    unsigned int opcode = Unpack<uint16_t>(ptr);
+    unsigned int index = opcode - m_base;
+    if (index >= m_count || m_table[index].handler == NULL) {
+        // without the spec of the opcode its size cannot be told
+        ERR("OpcodeDispatcher: unknown opcode %u in a compact stream\n", opcode);
+        m_failed = true;
+        return 0;
+    }
+    *out_opcode = opcode;
+
+    const Slot *s = &m_table[index];
+    if (s->flags & OPCODE_FLAG_FIXED_SIZE) {
+        *out_headerLen = 2;
+        return 2 + s->paramSize;
+    }
+
+    uint32_t paramLen;
+    size_t n = unpackVarint(ptr + 2, avail - 2, &paramLen);
+    if (n == 0) {
+        if (avail - 2 >= VARINT_MAX_SIZE) {
+            ERR("OpcodeDispatcher: invalid packet length (opcode %u)\n", opcode);
+            m_failed = true;
+        }
+        return 0;
+    }
+    if (paramLen > 0xffffffffU - COMPACT_HEADER_MAX_SIZE) {
+        ERR("OpcodeDispatcher: invalid packet length %u (opcode %u)\n",
+            paramLen, opcode);
+        m_failed = true;
+        return 0;
+    }
+    *out_headerLen = 2 + n;
+    return 2 + n + paramLen;
+}
+
+size_t OpcodeDispatcher::decode(void *buf, size_t len, IOStream *stream)
+{
+    size_t pos = 0;
+    bool replied = false;
+    unsigned char *ptr = (unsigned char *)buf;
+
+    while (!m_failed && pos < len) {
+        unsigned int opcode;
+        size_t headerLen;
+        size_t packetLen = parseHeader(ptr, len - pos, &opcode, &headerLen);
+        if (packetLen == 0 || len - pos < packetLen) {
+            break;
+        }
+
+        // opcodes below m_base wrap around and fail the range check too
+        unsigned int index = opcode - m_base;
+        if (index >= m_count || m_table[index].handler == NULL) {
+            ERR("OpcodeDispatcher: unknown opcode %u, skipping %u bytes\n",
+                opcode, (unsigned int)packetLen);
+        } else {
+            const Slot *s = &m_table[index];
+            // a handler enabling the status word does not get one
+            ReplyStatusProc statusProc = m_replyStatusProc;
+            bool roundTrip;
+            if (s->stats != NULL && s->stats->enabled()) {
+                uint64_t startTime = DecoderStats::now();
+                roundTrip = s->handler(s->decoder, ptr + headerLen, packetLen - headerLen, stream);
+                s->stats->record(opcode, packetLen, startTime, roundTrip);
+            } else {
+                roundTrip = s->handler(s->decoder, ptr + headerLen, packetLen - headerLen, stream);
+            }
+            if (roundTrip && statusProc != NULL) {
+                unsigned char *status = stream->alloc(4);
+                if (status != NULL) {
+                    Pack<uint32_t>(status, statusProc(m_replyStatusData));
+                }
+            }
+            replied |= roundTrip;
+        }
+
+        pos += packetLen;
+        ptr += packetLen;
+    }
+
+    // the client is waiting for the replies before it sends anything
+    // else, so they must go out before the caller waits for input.
+    if (replied) {
+        stream->flush();
+    }
+    return pos;
+}
+
+size_t OpcodeDispatcher::scan(const void *buf, size_t len, bool *out_reply)
+{
+    size_t pos = 0;
+    const unsigned char *ptr = (const unsigned char *)buf;
+
+    *out_reply = false;
+    while (!m_failed && pos < len) {
+        unsigned int opcode;
+        size_t headerLen;
+        size_t packetLen = parseHeader(ptr, len - pos, &opcode, &headerLen);
+        if (packetLen == 0 || len - pos < packetLen) {
+            break;
+        }
+
+        pos += packetLen;
+        ptr += packetLen;
+
+        unsigned int index = opcode - m_base;
+        if (index < m_count && (m_table[index].flags & OPCODE_FLAG_REPLY)) {
+            *out_reply = true;
+            break;
+        }
+    }
+    return pos;
+}
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _OPCODE_DISPATCHER_H
+#define _OPCODE_DISPATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "IOStream.h"
+#include "DecoderStats.h"
+#include "PacketHeader.h"
+
+//
+// Decodes and executes a packet using the given decoder context; ptr
+// points to its len bytes of parameters, past the header. Returns true
+// if a reply was written to the stream, which is left to the caller to
+// flush.
+//
+typedef bool (*OpcodeHandler)(void *decoder, unsigned char *ptr, size_t len, IOStream *stream);
+
+// returns the status word appended to a reply, see setReplyStatus()
+typedef uint32_t (*ReplyStatusProc)(void *data);
+
+// opcode flags
+#define OPCODE_FLAG_REPLY       0x1     // the call sends back a reply
+#define OPCODE_FLAG_FIXED_SIZE  0x2     // the parameters size is always the same
+
+//
+// Describes the opcodes of one generated decoder; emugen emits one as
+// the static s_info member of each <api>_decoder_context_t.
+//
+struct DecoderInfo {
+    const char *api;
+    unsigned int baseOpcode;
+    unsigned int numOpcodes;
+    const OpcodeHandler *handlers;      // numOpcodes entries
+    const char * const *names;          // numOpcodes entries
+    const unsigned char *flags;         // numOpcodes entries, OPCODE_FLAG_*
+    const unsigned int *paramSizes;     // numOpcodes entries, for OPCODE_FLAG_FIXED_SIZE
+};
+
+//
+// OpcodeDispatcher - decodes a stream that mixes the packets of several
+// apis. The opcode ranges of all the added decoders are laid out in a
+// single table, so that each packet costs one lookup whatever api it
+// belongs to. Packets with an opcode that no decoder claims are skipped.
+//
+class OpcodeDispatcher {
+public:
+    OpcodeDispatcher();
+    ~OpcodeDispatcher();
+
+    // decoder is passed back to the handlers of info. Fails if the
+    // opcode range of info overlaps one that was already added.
+    bool addDecoder(const DecoderInfo *info, void *decoder, DecoderStats *stats);
+
+    // decodes every complete packet in buf, returns the number of bytes
+    // consumed. The replies of the decoded calls are flushed together
+    // before returning.
+    size_t decode(void *buf, size_t len, IOStream *stream);
+
+    // validates the packets in buf without executing them. Returns the
+    // size of the complete packets found at the start of buf, up to and
+    // including the first one that sends a reply, in which case
+    // *out_reply is set to true.
+    size_t scan(const void *buf, size_t len, bool *out_reply);
+
+    // true once a packet with an invalid length was found; the stream
+    // cannot be decoded any further.
+    bool failed() const { return m_failed; }
+
+    // selects the header format, PACKET_FORMAT_*, of the packets that
+    // follow. Returns false if the format is unknown.
+    bool setPacketFormat(unsigned int format);
+
+    // when proc is not NULL, every reply written after the one of the
+    // packet being decoded is followed by the 32 bit word proc returns
+    // (see ReplyStatus.h).
+    void setReplyStatus(ReplyStatusProc proc, void *data) {
+        m_replyStatusProc = proc;
+        m_replyStatusData = data;
+    }
+
+private:
+    struct Slot {
+        OpcodeHandler handler;
+        void *decoder;
+        DecoderStats *stats;
+        unsigned int flags;
+        unsigned int paramSize;
+    };
+
+    size_t parseHeader(const unsigned char *ptr, size_t avail,
+                       unsigned int *out_opcode, size_t *out_headerLen);
+
+    Slot *m_table;
+    unsigned int m_base;
+    unsigned int m_count;
+    bool m_failed;
+    // set by a handler of the executing thread. In pipelined mode scan()
+    // runs on the reading thread, which only sees packets in the new
+    // format after the guest got the reply to rcSetPacketFormat().
+    volatile unsigned int m_packetFormat;
+    ReplyStatusProc m_replyStatusProc;
+    void *m_replyStatusData;
+};
+
+#endif
@@ -0,0 +1,199 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _PACKET_HEADER_H
+#define _PACKET_HEADER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "ProtocolUtils.h"
+
+//
+// Packet header formats.
+//
+// The classic header is:
+//     uint32_t opcode;
+//     uint32_t packetLen;            // header included
+//
+// The compact header is:
+//     uint16_t opcode;
+//     varint   paramLen;             // parameters only
+//
+// where paramLen is left out for opcodes with a fixed parameter size,
+// which both sides know from the api spec (OPCODE_FLAG_FIXED_SIZE on the
+// decoder side). The varint is little endian base 128, 7 bits per byte
+// with the top bit set on all bytes but the last one. It may be padded
+// with groups of zero bits, up to VARINT_MAX_SIZE bytes, which encoders
+// use to align the data of a packet (see alignedHeaderSize()).
+//
+// Connections start with the classic format. Encoders only use the
+// compact one once the renderer reports RENDERER_CAP_COMPACT_HEADER and
+// accepted it with rcSetPacketFormat().
+//
+#define PACKET_FORMAT_CLASSIC   0
+#define PACKET_FORMAT_COMPACT   1
+
+#define CLASSIC_HEADER_SIZE     8
+#define COMPACT_HEADER_MAX_SIZE 10
+
+// size of a 32 bit varint holding any value, and its maximum size with
+// padding
+#define VARINT_FIXED_SIZE       5
+#define VARINT_MAX_SIZE         8
+
+static inline size_t varintSize(uint32_t value)
+{
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static inline unsigned char *packVarint(unsigned char *ptr, uint32_t value)
+{
+    while (value >= 0x80) {
+        *ptr++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *ptr++ = (unsigned char)value;
+    return ptr;
+}
+
+//
+// unpackVarint - decodes the varint at ptr, of which at most avail bytes
+// are available. Returns its encoded size, or 0 if it is incomplete,
+// longer than VARINT_MAX_SIZE or has value bits in its padding.
+//
+static inline size_t unpackVarint(const unsigned char *ptr, size_t avail,
+                                  uint32_t *out_value)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < avail && i < VARINT_MAX_SIZE; i++) {
+        if (i < VARINT_FIXED_SIZE) {
+            value |= (uint32_t)(ptr[i] & 0x7f) << (7 * i);
+        } else if (ptr[i] & 0x7f) {
+            return 0;
+        }
+        if (!(ptr[i] & 0x80)) {
+            *out_value = value;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// writes value as a varint of exactly size bytes, which must be at
+// least varintSize(value) and at most VARINT_MAX_SIZE
+static inline unsigned char *packVarintSized(unsigned char *ptr, uint32_t value, size_t size)
+{
+    for (size_t i = 0; i < size - 1; i++) {
+        *ptr++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *ptr++ = (unsigned char)value;
+    return ptr;
+}
+
+// writes value as a varint of exactly VARINT_FIXED_SIZE bytes, so that
+// it can be rewritten in place
+static inline unsigned char *packVarintPadded(unsigned char *ptr, uint32_t value)
+{
+    return packVarintSized(ptr, value, VARINT_FIXED_SIZE);
+}
+
+// size of the header of a packet carrying paramLen bytes of parameters
+static inline size_t packetHeaderSize(int format, bool fixedSize, uint32_t paramLen)
+{
+    if (format != PACKET_FORMAT_COMPACT) {
+        return CLASSIC_HEADER_SIZE;
+    }
+    return fixedSize ? 2 : 2 + varintSize(paramLen);
+}
+
+// writes a packet header at ptr and returns where the parameters start
+static inline unsigned char *packPacketHeader(unsigned char *ptr, int format,
+                                              uint32_t opcode, bool fixedSize,
+                                              uint32_t paramLen)
+{
+    if (format != PACKET_FORMAT_COMPACT) {
+        Pack<uint32_t>(ptr, opcode);
+        Pack<uint32_t>(ptr + 4, paramLen + CLASSIC_HEADER_SIZE);
+        return ptr + CLASSIC_HEADER_SIZE;
+    }
+    Pack<uint16_t>(ptr, (uint16_t)opcode);
+    ptr += 2;
+    return fixedSize ? ptr : packVarint(ptr, paramLen);
+}
+
+//
+// Headers of packets with data that the decoder may use in place, which
+// GL reads in 4 byte units: the compact header is padded so that the
+// byte at dataOffset in the parameters lands on a multiple of 4 in the
+// stream, given that the packet starts at stream position pos (see
+// IOStream::position()). The receive buffer of the decoder keeps the
+// stream alignment. Classic headers are never padded.
+//
+static inline size_t alignedHeaderSize(int format, uint32_t paramLen,
+                                       unsigned int pos, size_t dataOffset)
+{
+    if (format != PACKET_FORMAT_COMPACT) {
+        return CLASSIC_HEADER_SIZE;
+    }
+    size_t n = varintSize(paramLen);
+    return 2 + n + ((4 - ((pos + 2 + n + dataOffset) & 3)) & 3);
+}
+
+static inline unsigned char *packAlignedHeader(unsigned char *ptr, int format,
+                                               uint32_t opcode, uint32_t paramLen,
+                                               size_t headerSize)
+{
+    if (format != PACKET_FORMAT_COMPACT) {
+        return packPacketHeader(ptr, format, opcode, false, paramLen);
+    }
+    Pack<uint16_t>(ptr, (uint16_t)opcode);
+    return packVarintSized(ptr + 2, paramLen, headerSize - 2);
+}
+
+//
+// Headers of packets that grow after they were written: their length is
+// always encoded with the same size, and set with setPacketParamLen().
+//
+static inline size_t growableHeaderSize(int format)
+{
+    return format == PACKET_FORMAT_COMPACT ? 2 + VARINT_FIXED_SIZE : CLASSIC_HEADER_SIZE;
+}
+
+static inline unsigned char *packGrowableHeader(unsigned char *ptr, int format,
+                                                uint32_t opcode, uint32_t paramLen)
+{
+    if (format != PACKET_FORMAT_COMPACT) {
+        return packPacketHeader(ptr, format, opcode, false, paramLen);
+    }
+    Pack<uint16_t>(ptr, (uint16_t)opcode);
+    return packVarintPadded(ptr + 2, paramLen);
+}
+
+static inline void setPacketParamLen(unsigned char *header, int format, uint32_t paramLen)
+{
+    if (format != PACKET_FORMAT_COMPACT) {
+        Pack<uint32_t>(header + 4, paramLen + CLASSIC_HEADER_SIZE);
+    } else {
+        packVarintPadded(header + 2, paramLen);
+    }
+}
+
+#endif
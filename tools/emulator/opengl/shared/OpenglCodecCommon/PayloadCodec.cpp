@@ -0,0 +1,272 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "PayloadCodec.h"
+#include "ErrorLog.h"
+#include <string.h>
+
+//
+// A small greedy compressor producing the LZ4 block format: a sequence
+// of (token, literals, 16 bit offset, match length) records, the last
+// one carrying literals only.
+//
+#define LZ_HASH_LOG         12
+#define LZ_MIN_MATCH        4
+#define LZ_LAST_LITERALS    5
+#define LZ_MF_LIMIT         12
+#define LZ_MAX_OFFSET       65535
+#define LZ_SKIP_TRIGGER     6
+
+static inline uint32_t read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lzHash(uint32_t seq)
+{
+    return (seq * 2654435761U) >> (32 - LZ_HASH_LOG);
+}
+
+static inline unsigned char *writeLength(unsigned char *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+size_t lzCompressBound(size_t len)
+{
+    return len + len / 255 + 16;
+}
+
+size_t lzCompress(const unsigned char *src, size_t srcLen,
+                  unsigned char *dst, size_t dstCapacity)
+{
+    const unsigned char *ip = src;
+    const unsigned char *anchor = src;
+    const unsigned char *end = src + srcLen;
+    unsigned char *op = dst;
+    unsigned char *oend = dst + dstCapacity;
+
+    if (srcLen >= LZ_MF_LIMIT + 1) {
+        uint32_t table[1 << LZ_HASH_LOG];
+        memset(table, 0, sizeof(table));
+
+        const unsigned char *mflimit = end - LZ_MF_LIMIT;
+        const unsigned char *matchlimit = end - LZ_LAST_LITERALS;
+        unsigned int misses = 0;
+
+        ip++;
+        while (ip < mflimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = lzHash(seq);
+            const unsigned char *ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+
+            if (ref >= ip || ip - ref > LZ_MAX_OFFSET || read32(ref) != seq) {
+                // skip faster through data that does not compress
+                ip += 1 + (misses++ >> LZ_SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            const unsigned char *mp = ip + LZ_MIN_MATCH;
+            const unsigned char *rp = ref + LZ_MIN_MATCH;
+            while (mp + 8 <= matchlimit && read64(mp) == read64(rp)) {
+                mp += 8;
+                rp += 8;
+            }
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+
+            size_t litLen = ip - anchor;
+            size_t matchLen = mp - ip - LZ_MIN_MATCH;
+            if (op + 1 + litLen / 255 + 1 + litLen + 2 + matchLen / 255 + 1 > oend) {
+                return 0;
+            }
+
+            unsigned char *token = op++;
+            *token = (unsigned char)((litLen >= 15 ? 15 : litLen) << 4);
+            if (litLen >= 15) {
+                op = writeLength(op, litLen - 15);
+            }
+            memcpy(op, anchor, litLen);
+            op += litLen;
+
+            size_t offset = ip - ref;
+            *op++ = (unsigned char)(offset & 0xff);
+            *op++ = (unsigned char)(offset >> 8);
+
+            *token |= (unsigned char)(matchLen >= 15 ? 15 : matchLen);
+            if (matchLen >= 15) {
+                op = writeLength(op, matchLen - 15);
+            }
+
+            ip = mp;
+            anchor = ip;
+            if (ip < mflimit) {
+                table[lzHash(read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+            }
+        }
+    }
+
+    // last literals
+    size_t litLen = end - anchor;
+    if (op + 1 + litLen / 255 + 1 + litLen > oend) {
+        return 0;
+    }
+    unsigned char *token = op++;
+    *token = (unsigned char)((litLen >= 15 ? 15 : litLen) << 4);
+    if (litLen >= 15) {
+        op = writeLength(op, litLen - 15);
+    }
+    memcpy(op, anchor, litLen);
+    op += litLen;
+
+    return op - dst;
+}
+
+bool lzDecompress(const unsigned char *src, size_t srcLen,
+                  unsigned char *dst, size_t dstLen)
+{
+    const unsigned char *ip = src;
+    const unsigned char *iend = src + srcLen;
+    unsigned char *op = dst;
+    unsigned char *oend = dst + dstLen;
+
+    while (ip < iend) {
+        unsigned int token = *ip++;
+
+        size_t litLen = token >> 4;
+        if (litLen == 15) {
+            unsigned int b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                litLen += b;
+            } while (b == 255);
+        }
+        if (litLen > (size_t)(iend - ip) || litLen > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, litLen);
+        op += litLen;
+        ip += litLen;
+
+        if (ip >= iend) {
+            break;  // the last sequence has no match
+        }
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return false;
+        }
+
+        size_t matchLen = token & 15;
+        if (matchLen == 15) {
+            unsigned int b;
+            do {
+                if (ip >= iend) return false;
+                b = *ip++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += LZ_MIN_MATCH;
+        if (matchLen > (size_t)(oend - op)) {
+            return false;
+        }
+
+        const unsigned char *ref = op - offset;
+        if (offset >= matchLen) {
+            memcpy(op, ref, matchLen);
+            op += matchLen;
+        } else {
+            // overlapping match, repeats the last 'offset' bytes
+            for (size_t i = 0; i < matchLen; i++) {
+                *op++ = *ref++;
+            }
+        }
+    }
+
+    return op == oend;
+}
+
+size_t PayloadCompressor::compress(int slot, const void *data, size_t len)
+{
+    // only worth it if it saves at least 1/8th of the data
+    size_t maxWire = len - len / 8;
+    unsigned char *out = (unsigned char *)m_out[slot].alloc(maxWire);
+    if (!out) {
+        return 0;
+    }
+
+    size_t clen = lzCompress((const unsigned char *)data, len, out + 4, maxWire - 4);
+    if (clen == 0) {
+        return 0;
+    }
+
+    uint32_t rawLen = (uint32_t)len;
+    memcpy(out, &rawLen, 4);
+    return clen + 4;
+}
+
+unsigned char *PayloadDecompressor::inflate(int slot, const unsigned char *wire, size_t wireLen)
+{
+    if (wireLen < 4) {
+        ERR("PayloadDecompressor: truncated payload (%u bytes)\n", (unsigned int)wireLen);
+        return NULL;
+    }
+    uint32_t rawLen;
+    memcpy(&rawLen, wire, 4);
+
+    if (rawLen > PAYLOAD_MAX_RAW_SIZE || rawLen / LZ_MAX_EXPANSION > wireLen - 4) {
+        ERR("PayloadDecompressor: %u bytes of payload cannot inflate to %u\n",
+            (unsigned int)wireLen - 4, rawLen);
+        return NULL;
+    }
+
+    unsigned char *out = (unsigned char *)m_out[slot].alloc(rawLen);
+    if (!out) {
+        ERR("PayloadDecompressor: failed to allocate %u bytes\n", rawLen);
+        return NULL;
+    }
+
+    if (!lzDecompress(wire + 4, wireLen - 4, out, rawLen)) {
+        ERR("PayloadDecompressor: corrupted payload (%u bytes)\n", (unsigned int)wireLen);
+        return NULL;
+    }
+    return out;
+}
@@ -0,0 +1,94 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _PAYLOAD_CODEC_H
+#define _PAYLOAD_CODEC_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "FixedBuffer.h"
+#include "codec_defs.h"
+
+//
+// Compression of 'in' pointer data on the wire.
+//
+// A compressed pointer is encoded as:
+//     uint32_t len | CODEC_COMPRESSED_PAYLOAD;   // len = 4 + compressed size
+//     uint32_t rawLen;                           // uncompressed size
+//     unsigned char data[len - 4];               // LZ4 block format
+//
+// Encoders only compress when the renderer reports
+// RENDERER_CAP_COMPRESSED_PAYLOAD; decoders always accept both forms.
+//
+
+// pointer data smaller than this is never compressed
+#define PAYLOAD_COMPRESS_THRESHOLD  (4 * 1024)
+// number of compressed pointers a single call may carry
+#define PAYLOAD_MAX_SLOTS           4
+// pointer data larger than this is never compressed, nor inflated
+#define PAYLOAD_MAX_RAW_SIZE        (64 * 1024 * 1024)
+// most bytes a byte of compressed data can inflate to
+#define LZ_MAX_EXPANSION            255
+
+// raw LZ block codec
+size_t lzCompressBound(size_t len);
+size_t lzCompress(const unsigned char *src, size_t srcLen,
+                  unsigned char *dst, size_t dstCapacity);
+bool lzDecompress(const unsigned char *src, size_t srcLen,
+                  unsigned char *dst, size_t dstLen);
+
+class PayloadCompressor {
+public:
+    PayloadCompressor() : m_enabled(false) {}
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+
+    bool shouldCompress(size_t len) const {
+        return m_enabled && len >= PAYLOAD_COMPRESS_THRESHOLD &&
+               len <= PAYLOAD_MAX_RAW_SIZE;
+    }
+
+    // scratch buffer for data that needs custom packing before it is
+    // compressed
+    unsigned char *packBuffer(size_t len) {
+        return (unsigned char *)m_pack.alloc(len);
+    }
+
+    // compress - compresses 'len' bytes into the wire form above (without
+    // the length word). Returns the wire size or 0 if the data does not
+    // compress well enough to be worth it.
+    size_t compress(int slot, const void *data, size_t len);
+    const unsigned char *data(int slot) { return (const unsigned char *)m_out[slot].ptr(); }
+
+private:
+    bool m_enabled;
+    FixedBuffer m_pack;
+    FixedBuffer m_out[PAYLOAD_MAX_SLOTS];
+};
+
+class PayloadDecompressor {
+public:
+    // inflate - returns the uncompressed data of a pointer sent in the
+    // wire form above; 'wireLen' is the length word without the flag.
+    // Returns NULL, after logging why, if the data is corrupted or its
+    // uncompressed size is larger than it can be.
+    unsigned char *inflate(int slot, const unsigned char *wire, size_t wireLen);
+
+private:
+    FixedBuffer m_out[PAYLOAD_MAX_SLOTS];
+};
+
+#endif
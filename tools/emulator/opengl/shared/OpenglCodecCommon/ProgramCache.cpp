@@ -0,0 +1,433 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "ProgramCache.h"
+#include "ProtocolUtils.h"
+#include "codec_defs.h"
+#include <stdlib.h>
+#include <string.h>
+
+ProgramCache::ProgramCache() :
+    m_programs(NULL),
+    m_nPrograms(0),
+    m_programsAllocated(0),
+    m_shaders(NULL),
+    m_nShaders(0),
+    m_shadersAllocated(0)
+{
+}
+
+ProgramCache::~ProgramCache()
+{
+    for (int i = 0; i < m_nPrograms; i++) {
+        clearInfo(m_programs[i]);
+        delete m_programs[i];
+    }
+    free(m_programs);
+    free(m_shaders);
+}
+
+uint32_t ProgramCache::hash(const char *name)
+{
+    // FNV-1a
+    uint32_t h = 0x811c9dc5;
+    while (*name) {
+        h = (h ^ (unsigned char)*name++) * 0x01000193;
+    }
+    return h;
+}
+
+ProgramCache::Program *ProgramCache::findProgram(GLuint program)
+{
+    for (int i = 0; i < m_nPrograms; i++) {
+        if (m_programs[i]->name == program) {
+            return m_programs[i];
+        }
+    }
+    return NULL;
+}
+
+void ProgramCache::clearInfo(Program *p)
+{
+    for (int i = 0; i < p->nLookups; i++) {
+        free(p->lookups[i].name);
+    }
+    delete [] p->vars;
+    delete [] p->names;
+    p->vars = NULL;
+    p->names = NULL;
+    p->nAttribs = 0;
+    p->nUniforms = 0;
+    p->nLookups = 0;
+    p->linked = false;
+    p->hasInfo = false;
+}
+
+void ProgramCache::createProgram(GLuint program)
+{
+    if (program == 0) {
+        return;
+    }
+    Program *p = findProgram(program);
+    if (p != NULL) {
+        // deleted by another context of the share group, and reused
+        clearInfo(p);
+        return;
+    }
+
+    if (m_nPrograms == m_programsAllocated) {
+        int n = m_programsAllocated ? m_programsAllocated * 2 : 16;
+        Program **programs = (Program **)realloc(m_programs, n * sizeof(Program *));
+        if (programs == NULL) {
+            return;
+        }
+        m_programs = programs;
+        m_programsAllocated = n;
+    }
+    p = new Program;
+    p->name = program;
+    p->vars = NULL;
+    p->names = NULL;
+    p->nLookups = 0;
+    clearInfo(p);
+    m_programs[m_nPrograms++] = p;
+}
+
+void ProgramCache::deleteProgram(GLuint program)
+{
+    for (int i = 0; i < m_nPrograms; i++) {
+        if (m_programs[i]->name == program) {
+            clearInfo(m_programs[i]);
+            delete m_programs[i];
+            m_programs[i] = m_programs[--m_nPrograms];
+            return;
+        }
+    }
+}
+
+void ProgramCache::linkProgram(GLuint program)
+{
+    Program *p = findProgram(program);
+    if (p != NULL) {
+        clearInfo(p);
+    }
+}
+
+bool ProgramCache::needsProgramInfo(GLuint program)
+{
+    Program *p = findProgram(program);
+    return p != NULL && !p->hasInfo;
+}
+
+bool ProgramCache::setProgramInfo(GLuint program, const void *block, size_t size)
+{
+    Program *p = findProgram(program);
+    if (p == NULL) {
+        return false;
+    }
+    clearInfo(p);
+
+    const unsigned char *ptr = (const unsigned char *)block;
+    if (size < CODEC_PROGRAM_HEADER_FIELDS * 4) {
+        return false;
+    }
+    GLint linked = Unpack<GLint>(ptr + CODEC_PROGRAM_LINK_STATUS * 4);
+    GLint nAttribs = Unpack<GLint>(ptr + CODEC_PROGRAM_NUM_ATTRIBS * 4);
+    GLint nUniforms = Unpack<GLint>(ptr + CODEC_PROGRAM_NUM_UNIFORMS * 4);
+    size_t maxVars = (size - CODEC_PROGRAM_HEADER_FIELDS * 4) / (CODEC_PROGRAM_VAR_FIELDS * 4);
+    if (nAttribs < 0 || nUniforms < 0 || (size_t)nAttribs + nUniforms > maxVars) {
+        return false;
+    }
+
+    GLuint nVars = nAttribs + nUniforms;
+    Variable *vars = new Variable[nVars];
+    // the names take less room than the block, terminators included
+    char *names = new char[size];
+    const unsigned char *rec = ptr + CODEC_PROGRAM_HEADER_FIELDS * 4;
+    const unsigned char *end = ptr + size;
+    char *name = names;
+    GLuint i;
+    for (i = 0; i < nVars; i++) {
+        if (end - rec < CODEC_PROGRAM_VAR_FIELDS * 4) {
+            break;
+        }
+        GLint length = Unpack<GLint>(rec + CODEC_PROGRAM_VAR_NAME_LENGTH * 4);
+        size_t recordSize = CODEC_PROGRAM_VAR_FIELDS * 4 + ((length + 3) & ~3);
+        if (length < 0 || recordSize > (size_t)(end - rec)) {
+            break;
+        }
+        Variable *v = &vars[i];
+        v->location = Unpack<GLint>(rec + CODEC_PROGRAM_VAR_LOCATION * 4);
+        v->size = Unpack<GLint>(rec + CODEC_PROGRAM_VAR_SIZE * 4);
+        v->type = Unpack<GLenum>(rec + CODEC_PROGRAM_VAR_TYPE * 4);
+        v->nameLength = length;
+        v->name = name;
+        v->uniform = i >= (GLuint)nAttribs;
+        memcpy(name, rec + CODEC_PROGRAM_VAR_FIELDS * 4, length);
+        name[length] = '\0';
+        v->hash = hash(name);
+        name += length + 1;
+        rec += recordSize;
+    }
+    if (i < nVars) {
+        delete [] vars;
+        delete [] names;
+        return false;
+    }
+
+    p->vars = vars;
+    p->names = names;
+    p->nAttribs = nAttribs;
+    p->nUniforms = nUniforms;
+    p->linked = linked != GL_FALSE;
+    p->hasInfo = true;
+    return true;
+}
+
+bool ProgramCache::getProgramiv(GLuint program, GLenum pname, GLint *param)
+{
+    Program *p = findProgram(program);
+    if (p == NULL || !p->hasInfo) {
+        return false;
+    }
+    if (pname == GL_LINK_STATUS) {
+        *param = p->linked ? GL_TRUE : GL_FALSE;
+        return true;
+    }
+    if (!p->linked) {
+        return false;
+    }
+
+    switch (pname) {
+    case GL_ACTIVE_ATTRIBUTES:
+        *param = p->nAttribs;
+        return true;
+    case GL_ACTIVE_UNIFORMS:
+        *param = p->nUniforms;
+        return true;
+    case GL_ACTIVE_ATTRIBUTE_MAX_LENGTH:
+    case GL_ACTIVE_UNIFORM_MAX_LENGTH: {
+        bool uniform = pname == GL_ACTIVE_UNIFORM_MAX_LENGTH;
+        GLint maxLength = 0;
+        for (GLuint i = 0; i < p->nAttribs + p->nUniforms; i++) {
+            if (p->vars[i].uniform == uniform && p->vars[i].nameLength + 1 > maxLength) {
+                maxLength = p->vars[i].nameLength + 1;
+            }
+        }
+        *param = maxLength;
+        return true;
+    }
+    }
+    return false;
+}
+
+bool ProgramCache::getLocation(GLuint program, const char *name, bool uniform, GLint *location)
+{
+    Program *p = findProgram(program);
+    if (p == NULL || !p->hasInfo || !p->linked || name == NULL) {
+        return false;
+    }
+
+    uint32_t h = hash(name);
+    for (GLuint i = 0; i < p->nAttribs + p->nUniforms; i++) {
+        const Variable *v = &p->vars[i];
+        if (v->uniform == uniform && v->hash == h && !strcmp(v->name, name)) {
+            *location = v->location;
+            return true;
+        }
+    }
+    for (int i = 0; i < p->nLookups; i++) {
+        const Variable *v = &p->lookups[i];
+        if (v->uniform == uniform && v->hash == h && !strcmp(v->name, name)) {
+            *location = v->location;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProgramCache::setLocation(GLuint program, const char *name, bool uniform, GLint location)
+{
+    Program *p = findProgram(program);
+    if (p == NULL || !p->hasInfo || !p->linked || name == NULL ||
+        p->nLookups == PROGRAM_CACHE_MAX_LOOKUPS) {
+        return;
+    }
+
+    Variable *v = &p->lookups[p->nLookups];
+    v->name = strdup(name);
+    if (v->name == NULL) {
+        return;
+    }
+    v->nameLength = strlen(name);
+    v->hash = hash(name);
+    v->location = location;
+    v->size = 0;
+    v->type = 0;
+    v->uniform = uniform;
+    p->nLookups++;
+}
+
+bool ProgramCache::getAttribLocation(GLuint program, const char *name, GLint *location)
+{
+    return getLocation(program, name, false, location);
+}
+
+bool ProgramCache::getUniformLocation(GLuint program, const char *name, GLint *location)
+{
+    return getLocation(program, name, true, location);
+}
+
+void ProgramCache::setAttribLocation(GLuint program, const char *name, GLint location)
+{
+    setLocation(program, name, false, location);
+}
+
+void ProgramCache::setUniformLocation(GLuint program, const char *name, GLint location)
+{
+    setLocation(program, name, true, location);
+}
+
+bool ProgramCache::getActive(GLuint program, GLuint index, bool uniform, GLsizei bufsize,
+                             GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+    Program *p = findProgram(program);
+    if (p == NULL || !p->hasInfo || !p->linked || bufsize < 0) {
+        return false;
+    }
+    GLuint count = uniform ? p->nUniforms : p->nAttribs;
+    if (index >= count) {
+        return false;
+    }
+
+    const Variable *v = &p->vars[uniform ? p->nAttribs + index : index];
+    GLsizei written = 0;
+    if (bufsize > 0 && name != NULL) {
+        written = v->nameLength < bufsize - 1 ? v->nameLength : bufsize - 1;
+        memcpy(name, v->name, written);
+        name[written] = '\0';
+    }
+    if (length != NULL) {
+        *length = written;
+    }
+    if (size != NULL) {
+        *size = v->size;
+    }
+    if (type != NULL) {
+        *type = v->type;
+    }
+    return true;
+}
+
+bool ProgramCache::getActiveAttrib(GLuint program, GLuint index, GLsizei bufsize,
+                                   GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+    return getActive(program, index, false, bufsize, length, size, type, name);
+}
+
+bool ProgramCache::getActiveUniform(GLuint program, GLuint index, GLsizei bufsize,
+                                    GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+    return getActive(program, index, true, bufsize, length, size, type, name);
+}
+
+int ProgramCache::shaderParamIndex(GLenum pname)
+{
+    switch (pname) {
+    case GL_SHADER_TYPE:            return SHADER_TYPE_INDEX;
+    case GL_COMPILE_STATUS:         return COMPILE_STATUS_INDEX;
+    case GL_INFO_LOG_LENGTH:        return INFO_LOG_LENGTH_INDEX;
+    case GL_SHADER_SOURCE_LENGTH:   return SHADER_SOURCE_LENGTH_INDEX;
+    }
+    return -1;
+}
+
+ProgramCache::Shader *ProgramCache::findShader(GLuint shader)
+{
+    for (int i = 0; i < m_nShaders; i++) {
+        if (m_shaders[i].name == shader) {
+            return &m_shaders[i];
+        }
+    }
+    return NULL;
+}
+
+void ProgramCache::createShader(GLuint shader, GLenum type)
+{
+    if (shader == 0) {
+        return;
+    }
+    Shader *s = findShader(shader);
+    if (s == NULL) {
+        if (m_nShaders == m_shadersAllocated) {
+            int n = m_shadersAllocated ? m_shadersAllocated * 2 : 16;
+            Shader *shaders = (Shader *)realloc(m_shaders, n * sizeof(Shader));
+            if (shaders == NULL) {
+                return;
+            }
+            m_shaders = shaders;
+            m_shadersAllocated = n;
+        }
+        s = &m_shaders[m_nShaders++];
+        s->name = shader;
+    }
+    s->valid = 1 << SHADER_TYPE_INDEX;
+    s->params[SHADER_TYPE_INDEX] = type;
+}
+
+void ProgramCache::deleteShader(GLuint shader)
+{
+    Shader *s = findShader(shader);
+    if (s != NULL) {
+        *s = m_shaders[--m_nShaders];
+    }
+}
+
+void ProgramCache::shaderSource(GLuint shader)
+{
+    Shader *s = findShader(shader);
+    if (s != NULL) {
+        s->valid &= ~(1 << SHADER_SOURCE_LENGTH_INDEX);
+    }
+}
+
+void ProgramCache::compileShader(GLuint shader)
+{
+    Shader *s = findShader(shader);
+    if (s != NULL) {
+        s->valid &= ~((1 << COMPILE_STATUS_INDEX) | (1 << INFO_LOG_LENGTH_INDEX));
+    }
+}
+
+bool ProgramCache::getShaderiv(GLuint shader, GLenum pname, GLint *param)
+{
+    Shader *s = findShader(shader);
+    int index = shaderParamIndex(pname);
+    if (s == NULL || index < 0 || !(s->valid & (1 << index))) {
+        return false;
+    }
+    *param = s->params[index];
+    return true;
+}
+
+void ProgramCache::setShaderiv(GLuint shader, GLenum pname, GLint param)
+{
+    Shader *s = findShader(shader);
+    int index = shaderParamIndex(pname);
+    if (s != NULL && index >= 0) {
+        s->params[index] = param;
+        s->valid |= 1 << index;
+    }
+}
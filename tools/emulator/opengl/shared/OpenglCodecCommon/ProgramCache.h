@@ -0,0 +1,149 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _PROGRAM_CACHE_H_
+#define _PROGRAM_CACHE_H_
+
+#ifdef GL_API
+    #undef GL_API
+#endif
+#define GL_API
+
+#ifdef GL_APIENTRY
+    #undef GL_APIENTRY
+#endif
+
+#ifdef GL_APIENTRYP
+    #undef GL_APIENTRYP
+#endif
+#define GL_APIENTRYP
+
+#ifndef ANDROID
+#define GL_APIENTRY
+#endif
+
+#include <GLES2/gl2.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// names looked up through the server, beyond the active variables, that
+// are remembered per program.
+#define PROGRAM_CACHE_MAX_LOOKUPS   64
+
+//
+// ProgramCache - answers program and shader queries that cannot change
+// until the object is linked or compiled again, so that they do not
+// each need a round trip to the server.
+//
+// The active attributes and uniforms of a program are loaded from the
+// block returned by glGetProgramInfoBlock (see codec_defs.h), which the
+// encoder asks for the first time a linked program is queried. Other
+// names are remembered as the server answers them. Only objects created
+// through this cache are tracked, so that queries on names it does not
+// know still reach the server and report their errors there.
+//
+// Objects created in another context of the same share group are not
+// seen, and a relink from such a context is not noticed either. The
+// cache must therefore be owned by the context the objects are used in.
+//
+class ProgramCache {
+public:
+    ProgramCache();
+    ~ProgramCache();
+
+    void createProgram(GLuint program);
+    void deleteProgram(GLuint program);
+    void linkProgram(GLuint program);
+    // true if 'program' is tracked but its info block was not loaded yet
+    bool needsProgramInfo(GLuint program);
+    // loads the block returned by glGetProgramInfoBlock, returns false
+    // if it is malformed.
+    bool setProgramInfo(GLuint program, const void *block, size_t size);
+
+    // The queries return false if the answer must come from the server.
+    bool getProgramiv(GLuint program, GLenum pname, GLint *param);
+    bool getAttribLocation(GLuint program, const char *name, GLint *location);
+    bool getUniformLocation(GLuint program, const char *name, GLint *location);
+    bool getActiveAttrib(GLuint program, GLuint index, GLsizei bufsize,
+                         GLsizei *length, GLint *size, GLenum *type, GLchar *name);
+    bool getActiveUniform(GLuint program, GLuint index, GLsizei bufsize,
+                          GLsizei *length, GLint *size, GLenum *type, GLchar *name);
+    // remember the answer of the server to a location query
+    void setAttribLocation(GLuint program, const char *name, GLint location);
+    void setUniformLocation(GLuint program, const char *name, GLint location);
+
+    void createShader(GLuint shader, GLenum type);
+    void deleteShader(GLuint shader);
+    void shaderSource(GLuint shader);
+    void compileShader(GLuint shader);
+    bool getShaderiv(GLuint shader, GLenum pname, GLint *param);
+    void setShaderiv(GLuint shader, GLenum pname, GLint param);
+
+private:
+    struct Variable {
+        GLint location;
+        GLint size;
+        GLenum type;
+        uint32_t hash;
+        GLsizei nameLength;
+        char *name;
+        bool uniform;
+    };
+
+    struct Program {
+        GLuint name;
+        bool hasInfo;
+        bool linked;
+        GLuint nAttribs;
+        GLuint nUniforms;
+        Variable *vars;     // attributes, then uniforms
+        char *names;        // names of vars
+        int nLookups;
+        Variable lookups[PROGRAM_CACHE_MAX_LOOKUPS];
+    };
+
+    enum {
+        SHADER_TYPE_INDEX,
+        COMPILE_STATUS_INDEX,
+        INFO_LOG_LENGTH_INDEX,
+        SHADER_SOURCE_LENGTH_INDEX,
+        SHADER_PARAMS
+    };
+
+    struct Shader {
+        GLuint name;
+        unsigned int valid;     // bit per param index
+        GLint params[SHADER_PARAMS];
+    };
+
+    Program *findProgram(GLuint program);
+    Shader *findShader(GLuint shader);
+    void clearInfo(Program *p);
+    bool getLocation(GLuint program, const char *name, bool uniform, GLint *location);
+    void setLocation(GLuint program, const char *name, bool uniform, GLint location);
+    bool getActive(GLuint program, GLuint index, bool uniform, GLsizei bufsize,
+                   GLsizei *length, GLint *size, GLenum *type, GLchar *name);
+    static int shaderParamIndex(GLenum pname);
+    static uint32_t hash(const char *name);
+
+    Program **m_programs;
+    int m_nPrograms;
+    int m_programsAllocated;
+    Shader *m_shaders;
+    int m_nShaders;
+    int m_shadersAllocated;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _PROTOCOL_UTILS_H
+#define _PROTOCOL_UTILS_H
+
+#include <string.h>
+#include <stdint.h>
+
+//
+// Loads and stores of wire values. Parameters are packed back to back in
+// the stream, so their addresses are not aligned for their types in
+// general; going through memcpy keeps the access well defined (and safe
+// on cpus that trap on unaligned access) while still compiling to a plain
+// load or store where the cpu allows it.
+//
+template <class T>
+static inline T Unpack(const void *ptr)
+{
+    T value;
+    memcpy(&value, ptr, sizeof(T));
+    return value;
+}
+
+template <class T>
+static inline void Pack(void *ptr, T value)
+{
+    memcpy(ptr, &value, sizeof(T));
+}
+
+#endif
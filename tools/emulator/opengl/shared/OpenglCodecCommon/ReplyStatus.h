@@ -0,0 +1,91 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _REPLY_STATUS_H
+#define _REPLY_STATUS_H
+
+#include <stdint.h>
+#include "IOStream.h"
+
+//
+// ReplyStatus - the 32 bit status word that the renderer appends to
+// every reply of a connection once rcSetReplyStatus enabled it. For the
+// GLES apis it is the error of the current context, read on the host
+// right after the call that replied, so that the guest learns about
+// errors without asking for them.
+//
+// The first non zero status is kept until it is taken, the way GL keeps
+// its error flag. The host has cleared it from its context by then, so
+// it is kept for the context it belongs to: the object is shared by the
+// encoders of a connection, which give it the word of the context they
+// encode for with setPending().
+//
+class ReplyStatus {
+public:
+    ReplyStatus() : m_status(0), m_pending(&m_status), m_last(0),
+                    m_stream(NULL), m_commits(0), m_tail(NULL) {}
+
+    // reads the status word following a reply
+    void read(IOStream *stream) {
+        uint32_t status = 0;
+        stream->readback(&status, sizeof(status));
+        m_last = status;
+        set(status);
+        m_stream = stream;
+        m_commits = stream->commits();
+        m_tail = stream->tail();
+    }
+
+    // keeps the pending status in 'pending', that of the current context,
+    // or in the object itself without one
+    void setPending(uint32_t *pending) {
+        m_pending = pending != NULL ? pending : &m_status;
+    }
+
+    // true if calls were written to the stream since the latest reply,
+    // their errors are not known yet.
+    bool unanswered(IOStream *stream) const {
+        return stream != m_stream || stream->commits() != m_commits ||
+               stream->tail() != m_tail;
+    }
+
+    // the status that came with the latest reply, zero if the call that
+    // replied and the ones before it did not fail
+    uint32_t last() const { return m_last; }
+
+    void set(uint32_t status) {
+        if (*m_pending == 0) {
+            *m_pending = status;
+        }
+    }
+
+    // returns the pending status and clears it
+    uint32_t take() {
+        uint32_t status = *m_pending;
+        *m_pending = 0;
+        return status;
+    }
+
+private:
+    uint32_t m_status;
+    uint32_t *m_pending;
+    uint32_t m_last;
+    // where the stream was when the latest reply was read
+    IOStream *m_stream;
+    unsigned int m_commits;
+    const unsigned char *m_tail;
+};
+
+#endif
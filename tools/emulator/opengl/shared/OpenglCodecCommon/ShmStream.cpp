@@ -0,0 +1,604 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "ShmStream.h"
+#include <cutils/sockets.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define SHM_STREAM_MAGIC        0x53484d31  // 'SHM1'
+#define SHM_STREAM_CTRL_SIZE    4096
+#define SHM_STREAM_MIN_RING     (256 * 1024)
+#define SHM_STREAM_SPIN_COUNT   256
+
+enum { CLIENT_SIDE = 0, SERVER_SIDE = 1 };
+
+//
+// Each ring is written only by its producer (head) and its consumer
+// (tail); the two indices are free running byte counters kept on
+// separate cache lines.
+//
+struct ShmStreamRing {
+    volatile uint32_t head;
+    uint32_t pad0[15];
+    volatile uint32_t tail;
+    uint32_t pad1[15];
+};
+
+struct ShmStreamControl {
+    uint32_t magic;
+    uint32_t ringSize;
+    volatile int32_t closed;
+    volatile int32_t waiting[2];    // indexed by CLIENT_SIDE/SERVER_SIDE
+    uint32_t pad[11];
+    ShmStreamRing rings[2];         // [0] client->server, [1] server->client
+};
+
+struct ShmStreamHello {
+    uint32_t magic;
+    uint32_t ringSize;
+};
+
+static void getSocketName(unsigned short port, char *name, size_t len)
+{
+    snprintf(name, len, "emulator-opengl-shm-%u", port);
+}
+
+static int createShmFd(size_t size)
+{
+    int fd = -1;
+#ifdef __NR_memfd_create
+    fd = syscall(__NR_memfd_create, "opengl-shm-stream", 0);
+#endif
+    if (fd < 0) {
+        char name[64];
+        snprintf(name, sizeof(name), "/opengl-shm-stream-%d-%p", getpid(), &fd);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            return -1;
+        }
+        shm_unlink(name);
+    }
+    if (ftruncate(fd, size) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static size_t ringSizeFor(size_t bufSize)
+{
+    size_t size = SHM_STREAM_MIN_RING;
+    while (size < bufSize) {
+        size <<= 1;
+    }
+    return size;
+}
+
+ShmStream::ShmStream(size_t bufSize) :
+    IOStream(bufSize),
+    m_sock(-1),
+    m_isListener(false),
+    m_bufsize(bufSize),
+    m_buf(NULL),
+    m_ctrl(NULL),
+    m_mapSize(0),
+    m_tx(NULL),
+    m_rx(NULL),
+    m_txData(NULL),
+    m_rxData(NULL),
+    m_ringSize(0),
+    m_selfWaiting(NULL),
+    m_peerWaiting(NULL),
+    m_selfEvent(-1),
+    m_peerEvent(-1)
+{
+}
+
+ShmStream::ShmStream(int sock, size_t bufSize) :
+    IOStream(bufSize),
+    m_sock(sock),
+    m_isListener(false),
+    m_bufsize(bufSize),
+    m_buf(NULL),
+    m_ctrl(NULL),
+    m_mapSize(0),
+    m_tx(NULL),
+    m_rx(NULL),
+    m_txData(NULL),
+    m_rxData(NULL),
+    m_ringSize(0),
+    m_selfWaiting(NULL),
+    m_peerWaiting(NULL),
+    m_selfEvent(-1),
+    m_peerEvent(-1)
+{
+}
+
+ShmStream::~ShmStream()
+{
+    if (m_ctrl) {
+        m_ctrl->closed = 1;
+        __sync_synchronize();
+        wakePeer();
+        munmap(m_ctrl, m_mapSize);
+    }
+    if (m_selfEvent >= 0) {
+        ::close(m_selfEvent);
+    }
+    if (m_peerEvent >= 0) {
+        ::close(m_peerEvent);
+    }
+    if (m_sock >= 0) {
+        ::close(m_sock);
+    }
+    if (m_buf != NULL) {
+        free(m_buf);
+    }
+}
+
+int ShmStream::listen(unsigned short port)
+{
+    char name[64];
+    getSocketName(port, name, sizeof(name));
+
+    m_sock = socket_local_server(name, ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
+    if (m_sock < 0) return int(ERR_INVALID_SOCKET);
+
+    m_isListener = true;
+    return 0;
+}
+
+ShmStream *ShmStream::accept()
+{
+    int clientSock = -1;
+
+    while (true) {
+        clientSock = ::accept(m_sock, NULL, NULL);
+        if (clientSock < 0 && errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+    if (clientSock < 0) {
+        return NULL;
+    }
+
+    //
+    // receive the segment and the two eventfds from the client
+    //
+    ShmStreamHello hello;
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+
+    char cbuf[CMSG_SPACE(3 * sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    ssize_t n;
+    do {
+        n = ::recvmsg(clientSock, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+
+    int fds[3] = { -1, -1, -1 };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(3 * sizeof(int))) {
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    }
+
+    if (n != (ssize_t)sizeof(hello) || hello.magic != SHM_STREAM_MAGIC || fds[0] < 0) {
+        ERR("ShmStream::accept: bad handshake from client\n");
+        for (int i = 0; i < 3; i++) {
+            if (fds[i] >= 0) ::close(fds[i]);
+        }
+        ::close(clientSock);
+        return NULL;
+    }
+
+    ShmStream *clientStream = new ShmStream(clientSock, m_bufsize);
+    clientStream->m_ringSize = hello.ringSize;
+    clientStream->m_peerEvent = fds[1];
+    clientStream->m_selfEvent = fds[2];
+    int stat = clientStream->map(fds[0], false);
+    ::close(fds[0]);
+    if (stat < 0) {
+        delete clientStream;
+        return NULL;
+    }
+
+    return clientStream;
+}
+
+int ShmStream::connect(unsigned short port)
+{
+    char name[64];
+    getSocketName(port, name, sizeof(name));
+
+    m_sock = socket_local_client(name, ANDROID_SOCKET_NAMESPACE_ABSTRACT, SOCK_STREAM);
+    if (m_sock < 0) return -1;
+
+    m_ringSize = ringSizeFor(m_bufsize);
+    int shmFd = createShmFd(SHM_STREAM_CTRL_SIZE + 2 * m_ringSize);
+    m_selfEvent = eventfd(0, EFD_NONBLOCK);
+    m_peerEvent = eventfd(0, EFD_NONBLOCK);
+    if (shmFd < 0 || m_selfEvent < 0 || m_peerEvent < 0 || map(shmFd, true) < 0) {
+        ERR("ShmStream::connect: failed to create shared segment: %s\n", strerror(errno));
+        if (shmFd >= 0) ::close(shmFd);
+        return -1;
+    }
+
+    ShmStreamHello hello;
+    hello.magic = SHM_STREAM_MAGIC;
+    hello.ringSize = m_ringSize;
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+
+    int fds[3] = { shmFd, m_selfEvent, m_peerEvent };
+    char cbuf[CMSG_SPACE(sizeof(fds))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(m_sock, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    ::close(shmFd);
+
+    if (n != (ssize_t)sizeof(hello)) {
+        ERR("ShmStream::connect: handshake failed: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int ShmStream::map(int shmFd, bool create)
+{
+    if (m_ringSize < SHM_STREAM_MIN_RING || (m_ringSize & (m_ringSize - 1)) != 0) {
+        ERR("ShmStream: invalid ring size %u\n", m_ringSize);
+        return -1;
+    }
+
+    size_t size = SHM_STREAM_CTRL_SIZE + 2 * (size_t)m_ringSize;
+    if (!create) {
+        // the segment comes from the peer, touching pages past its end
+        // would fault
+        struct stat st;
+        if (fstat(shmFd, &st) < 0 || st.st_size < 0 || (size_t)st.st_size < size) {
+            ERR("ShmStream: shared segment too small for rings of %u bytes\n", m_ringSize);
+            return -1;
+        }
+    }
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+    if (ptr == MAP_FAILED) {
+        ERR("ShmStream: mmap failed: %s\n", strerror(errno));
+        return -1;
+    }
+    m_ctrl = (ShmStreamControl *)ptr;
+    m_mapSize = size;
+
+    if (create) {
+        memset(m_ctrl, 0, sizeof(ShmStreamControl));
+        m_ctrl->magic = SHM_STREAM_MAGIC;
+        m_ctrl->ringSize = m_ringSize;
+    } else if (m_ctrl->magic != SHM_STREAM_MAGIC || m_ctrl->ringSize != m_ringSize) {
+        ERR("ShmStream: shared segment header mismatch\n");
+        return -1;
+    }
+
+    unsigned char *data = (unsigned char *)ptr + SHM_STREAM_CTRL_SIZE;
+    int self = create ? CLIENT_SIDE : SERVER_SIDE;
+    int peer = 1 - self;
+    m_tx = &m_ctrl->rings[self];
+    m_rx = &m_ctrl->rings[peer];
+    m_txData = data + self * m_ringSize;
+    m_rxData = data + peer * m_ringSize;
+    m_selfWaiting = &m_ctrl->waiting[self];
+    m_peerWaiting = &m_ctrl->waiting[peer];
+
+    return 0;
+}
+
+void *ShmStream::allocBuffer(size_t minSize)
+{
+    size_t allocSize = (m_bufsize < minSize ? minSize : m_bufsize);
+    if (!m_buf) {
+        m_buf = (unsigned char *)malloc(allocSize);
+    }
+    else if (m_bufsize < allocSize) {
+        unsigned char *p = (unsigned char *)realloc(m_buf, allocSize);
+        if (p != NULL) {
+            m_buf = p;
+            m_bufsize = allocSize;
+        } else {
+            ERR("realloc (%u) failed\n", (unsigned int)allocSize);
+            free(m_buf);
+            m_buf = NULL;
+            m_bufsize = 0;
+        }
+    }
+
+    return m_buf;
+}
+
+int ShmStream::commitBuffer(size_t size)
+{
+    return writeFully(m_buf, size);
+}
+
+int ShmStream::commitBufferv(const Segment *segments, int count)
+{
+    for (int i = 0; i < count; i++) {
+        int stat = writeFully(segments[i].base, segments[i].len);
+        if (stat < 0) {
+            return stat;
+        }
+    }
+    return 0;
+}
+
+int ShmStream::writeFully(const void *buf, size_t size)
+{
+    if (!valid()) return -1;
+
+    const unsigned char *src = (const unsigned char *)buf;
+    while (size > 0) {
+        size_t space = waitForSpace();
+        if (!space) {
+            ERR("ShmStream::writeFully failed: peer closed\n");
+            return -1;
+        }
+
+        uint32_t head = m_tx->head;
+        size_t n = (size < space ? size : space);
+        size_t off = head & (m_ringSize - 1);
+        size_t first = m_ringSize - off;
+        if (first > n) first = n;
+        memcpy(m_txData + off, src, first);
+        memcpy(m_txData, src + first, n - first);
+
+        // publish the data before the new head
+        __sync_synchronize();
+        m_tx->head = head + n;
+        __sync_synchronize();
+        if (*m_peerWaiting) {
+            wakePeer();
+        }
+
+        src += n;
+        size -= n;
+    }
+    return 0;
+}
+
+const unsigned char *ShmStream::readFully(void *buf, size_t len)
+{
+    if (!valid()) return NULL;
+    if (!buf) {
+      ERR("ShmStream::readFully failed, buf=NULL");
+      return NULL;  // do not allow NULL buf in that implementation
+    }
+
+    size_t res = len;
+    while (res > 0) {
+        size_t n = res;
+        if (!read((unsigned char *)buf + len - res, &n)) {
+            return NULL;
+        }
+        res -= n;
+    }
+    return (const unsigned char *)buf;
+}
+
+const unsigned char *ShmStream::read( void *buf, size_t *inout_len)
+{
+    if (!valid()) return NULL;
+    if (!buf) {
+      ERR("ShmStream::read failed, buf=NULL");
+      return NULL;  // do not allow NULL buf in that implementation
+    }
+
+    size_t avail = waitForData();
+    if (!avail) {
+        return NULL;
+    }
+
+    uint32_t tail = m_rx->tail;
+    size_t n = (*inout_len < avail ? *inout_len : avail);
+    size_t off = tail & (m_ringSize - 1);
+    size_t first = m_ringSize - off;
+    if (first > n) first = n;
+    memcpy(buf, m_rxData + off, first);
+    memcpy((unsigned char *)buf + first, m_rxData, n - first);
+
+    // make sure the data is copied out before releasing the space
+    __sync_synchronize();
+    m_rx->tail = tail + n;
+    __sync_synchronize();
+    if (*m_peerWaiting) {
+        wakePeer();
+    }
+
+    *inout_len = n;
+    return (const unsigned char *)buf;
+}
+
+//
+// waitForData - returns the number of bytes available for reading,
+// blocking until at least one is. Returns 0 if the peer has gone away.
+//
+size_t ShmStream::waitForData()
+{
+    int spin = 0;
+    while (true) {
+        size_t avail = m_rx->head - m_rx->tail;
+        if (avail > 0) {
+            __sync_synchronize();
+            return avail;
+        }
+        if (m_ctrl->closed) {
+            return 0;
+        }
+        if (spin++ < SHM_STREAM_SPIN_COUNT) {
+            continue;
+        }
+
+        // declare ourselves idle, then re-check before sleeping so
+        // that a head update racing with the flag is not missed.
+        *m_selfWaiting = 1;
+        __sync_synchronize();
+        if (m_rx->head == m_rx->tail && !m_ctrl->closed) {
+            if (!waitForPeer()) {
+                *m_selfWaiting = 0;
+                return 0;
+            }
+        }
+        *m_selfWaiting = 0;
+    }
+}
+
+//
+// waitForSpace - returns the number of free bytes in the outgoing ring,
+// blocking until at least one is. Returns 0 if the peer has gone away.
+//
+size_t ShmStream::waitForSpace()
+{
+    int spin = 0;
+    while (true) {
+        size_t space = m_ringSize - (m_tx->head - m_tx->tail);
+        if (space > 0) {
+            __sync_synchronize();
+            return space;
+        }
+        if (m_ctrl->closed) {
+            return 0;
+        }
+        if (spin++ < SHM_STREAM_SPIN_COUNT) {
+            continue;
+        }
+
+        *m_selfWaiting = 1;
+        __sync_synchronize();
+        if (m_tx->head - m_tx->tail == m_ringSize && !m_ctrl->closed) {
+            if (!waitForPeer()) {
+                *m_selfWaiting = 0;
+                return 0;
+            }
+        }
+        *m_selfWaiting = 0;
+    }
+}
+
+//
+// waitForPeer - sleeps until the peer signals our eventfd. Returns false
+// if the rendezvous socket reports that the peer process went away.
+//
+bool ShmStream::waitForPeer()
+{
+    struct pollfd fds[2];
+    fds[0].fd = m_selfEvent;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_sock;
+    fds[1].events = POLLIN;
+
+    int n;
+    do {
+        fds[0].revents = fds[1].revents = 0;
+        n = ::poll(fds, 2, -1);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        ERR("ShmStream: poll failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    if (fds[0].revents & POLLIN) {
+        uint64_t count;
+        while (::read(m_selfEvent, &count, sizeof(count)) < 0 && errno == EINTR) {
+        }
+    }
+
+    // nothing is ever sent on the socket after the handshake, so any
+    // readability on it means the peer has closed its end.
+    if (fds[1].revents) {
+        return !peerClosed();
+    }
+    return true;
+}
+
+bool ShmStream::armWait()
+{
+    if (!m_ctrl) return false;
+
+    *m_selfWaiting = 1;
+    __sync_synchronize();
+    if (m_rx->head != m_rx->tail || m_ctrl->closed) {
+        *m_selfWaiting = 0;
+        return false;
+    }
+    return true;
+}
+
+void ShmStream::disarmWait()
+{
+    if (!m_ctrl) return;
+
+    uint64_t count;
+    while (::read(m_selfEvent, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+    *m_selfWaiting = 0;
+}
+
+bool ShmStream::peerClosed()
+{
+    char c;
+    ssize_t n;
+    do {
+        n = ::recv(m_sock, &c, 1, MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    return n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+}
+
+void ShmStream::wakePeer()
+{
+    uint64_t one = 1;
+    while (::write(m_peerEvent, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
@@ -0,0 +1,102 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __SHM_STREAM_H
+#define __SHM_STREAM_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "IOStream.h"
+
+//
+// ShmStream - IOStream over a pair of single-producer/single-consumer
+// rings located in a shared memory segment. Intended for host-side
+// connections where both ends run on the same machine (the emulator and
+// the renderer). Data is exchanged without any system call; an eventfd
+// is signaled only when the peer has declared itself idle.
+//
+// The connection is set up over a local (abstract namespace) socket
+// derived from the port number. The connecting side creates the shared
+// segment and wakeup eventfds and passes them to the listening side. The
+// socket then stays open for the lifetime of the stream and is used to
+// detect peer death.
+//
+// Linux only.
+//
+struct ShmStreamControl;
+struct ShmStreamRing;
+
+class ShmStream : public IOStream {
+public:
+    typedef enum { ERR_INVALID_SOCKET = -1000 } ShmStreamError;
+
+    explicit ShmStream(size_t bufsize = 10000);
+    ~ShmStream();
+    int listen(unsigned short port);
+    ShmStream *accept();
+    int connect(unsigned short port);
+
+    virtual void *allocBuffer(size_t minSize);
+    virtual int commitBuffer(size_t size);
+    virtual int commitBufferv(const Segment *segments, int count);
+    virtual const unsigned char *readFully( void *buf, size_t len);
+    virtual const unsigned char *read( void *buf, size_t *inout_len);
+
+    bool valid() { return m_sock >= 0 && (m_isListener || m_ctrl != NULL); }
+    int socket() const { return m_sock; }
+
+    //
+    // Support for event driven readers. armWait() declares the reader
+    // idle, so that the peer signals eventFd() on its next write, and
+    // returns true. It returns false without arming if data is already
+    // available or the stream was closed, in which case read() will not
+    // block. disarmWait() must be called once eventFd() became readable.
+    // The peer going away is reported as readability on socket(), which
+    // can be confirmed with peerClosed().
+    //
+    int eventFd() const { return m_selfEvent; }
+    bool armWait();
+    void disarmWait();
+    bool peerClosed();
+
+private:
+    ShmStream(int sock, size_t bufSize);
+    int map(int shmFd, bool create);
+    int writeFully(const void *buf, size_t len);
+    size_t waitForData();
+    size_t waitForSpace();
+    bool waitForPeer();
+    void wakePeer();
+
+private:
+    int m_sock;
+    bool m_isListener;
+    size_t m_bufsize;
+    unsigned char *m_buf;
+
+    ShmStreamControl *m_ctrl;   // start of the shared segment
+    size_t m_mapSize;
+    ShmStreamRing *m_tx;        // ring we produce into
+    ShmStreamRing *m_rx;        // ring we consume from
+    unsigned char *m_txData;
+    unsigned char *m_rxData;
+    uint32_t m_ringSize;
+    volatile int32_t *m_selfWaiting;
+    volatile int32_t *m_peerWaiting;
+    int m_selfEvent;            // eventfd we sleep on
+    int m_peerEvent;            // eventfd used to wake the peer
+};
+
+#endif
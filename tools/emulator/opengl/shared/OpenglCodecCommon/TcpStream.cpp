@@ -23,8 +23,11 @@
 
 #ifndef _WIN32
 #include <netinet/in.h>
+#include <sys/uio.h>
 #endif
 
+#define MAX_IOVECS 64
+
 TcpStream::TcpStream(size_t bufSize) :
     IOStream(bufSize),
     m_sock(-1),
@@ -122,6 +125,11 @@ int TcpStream::commitBuffer(size_t size)
     return writeFully(m_buf, size);
 }
 
+int TcpStream::commitBufferv(const Segment *segments, int count)
+{
+    return writeFullyv(segments, count);
+}
+
 int TcpStream::writeFully(const void *buf, size_t len)
 {
     if (!valid()) return -1;
@@ -144,6 +152,51 @@ int TcpStream::writeFully(const void *buf, size_t len)
     return retval;
 }
 
+int TcpStream::writeFullyv(const Segment *segments, int count)
+{
+    if (!valid()) return -1;
+
+#ifdef _WIN32
+    for (int i = 0; i < count; i++) {
+        int stat = writeFully(segments[i].base, segments[i].len);
+        if (stat < 0) {
+            return stat;
+        }
+    }
+    return 0;
+#else
+    int first = 0;
+    size_t skip = 0;   // bytes of segments[first] already sent
+
+    while (first < count) {
+        struct iovec iov[MAX_IOVECS];
+        int n = 0;
+        for (int i = first; i < count && n < MAX_IOVECS; i++, n++) {
+            size_t off = (i == first ? skip : 0);
+            iov[n].iov_base = (char *)segments[i].base + off;
+            iov[n].iov_len = segments[i].len - off;
+        }
+
+        ssize_t stat = ::writev(m_sock, iov, n);
+        if (stat < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ERR("TcpStream::writeFullyv failed: %s\n", strerror(errno));
+            return stat;
+        }
+
+        size_t done = skip + stat;
+        while (first < count && done >= segments[first].len) {
+            done -= segments[first].len;
+            first++;
+        }
+        skip = done;
+    }
+    return 0;
+#endif
+}
+
 const unsigned char *TcpStream::readFully(void *buf, size_t len)
 {
     if (!valid()) return NULL;
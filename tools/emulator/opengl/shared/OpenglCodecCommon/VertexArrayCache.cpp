@@ -0,0 +1,190 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "VertexArrayCache.h"
+#include <string.h>
+
+// draws that must change every chunk before an array is sent inline, and
+// the number of draws it is then sent inline for.
+#define VERTEX_CACHE_DYNAMIC_DRAWS  4
+#define VERTEX_CACHE_SKIP_DRAWS     64
+
+VertexArrayCache::VertexArrayCache() :
+    m_totalBytes(0),
+    m_useCount(0)
+{
+    memset(m_entries, 0, sizeof(m_entries));
+}
+
+VertexArrayCache::~VertexArrayCache()
+{
+    for (int i = 0; i < VERTEX_CACHE_MAX_ENTRIES; i++) {
+        delete [] m_entries[i].hashes;
+    }
+}
+
+uint64_t VertexArrayCache::hash(const unsigned char *data, size_t size)
+{
+    // FNV-1a over 64 bit words
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while (size >= 8) {
+        uint64_t w;
+        memcpy(&w, data, 8);
+        h = (h ^ w) * prime;
+        data += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        h = (h ^ *data) * prime;
+        data++;
+        size--;
+    }
+    return h;
+}
+
+int VertexArrayCache::findEntry(const void *data, size_t size)
+{
+    for (int i = 0; i < VERTEX_CACHE_MAX_ENTRIES; i++) {
+        if (m_entries[i].size == size && m_entries[i].data == data) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void VertexArrayCache::evict(int entry, Update *update)
+{
+    Entry *e = &m_entries[entry];
+    if (e->buffer != 0) {
+        update->deleted[update->nDeleted++] = e->buffer;
+    }
+    discard(entry);
+}
+
+int VertexArrayCache::allocEntry(size_t size, Update *update)
+{
+    for (;;) {
+        int free = -1, lru = -1;
+        for (int i = 0; i < VERTEX_CACHE_MAX_ENTRIES; i++) {
+            if (m_entries[i].size == 0) {
+                if (free < 0) free = i;
+            } else if (lru < 0 || m_entries[i].lastUse < m_entries[lru].lastUse) {
+                lru = i;
+            }
+        }
+        if (free >= 0 && m_totalBytes + size <= VERTEX_CACHE_MAX_BYTES) {
+            return free;
+        }
+        if (lru < 0 || update->nDeleted == VERTEX_CACHE_MAX_DELETED) {
+            return -1;
+        }
+        evict(lru, update);
+    }
+}
+
+bool VertexArrayCache::lookup(const void *data, size_t size, Update *update)
+{
+    update->nRanges = 0;
+    update->nDeleted = 0;
+    update->realloc = false;
+
+    // very large arrays would evict everything else
+    if (size < VERTEX_CACHE_MIN_SIZE || size > VERTEX_CACHE_MAX_BYTES / 4) {
+        return false;
+    }
+
+    const unsigned char *bytes = (const unsigned char *)data;
+    unsigned int nChunks = (size + VERTEX_CACHE_CHUNK_SIZE - 1) / VERTEX_CACHE_CHUNK_SIZE;
+    int idx = findEntry(data, size);
+    Entry *e;
+
+    if (idx < 0) {
+        idx = allocEntry(size, update);
+        if (idx < 0) {
+            return false;
+        }
+        e = &m_entries[idx];
+        e->data = data;
+        e->size = size;
+        e->nChunks = nChunks;
+        e->hashes = new uint64_t[nChunks];
+        m_totalBytes += size;
+        update->realloc = true;
+    } else {
+        e = &m_entries[idx];
+        if (e->skipDraws > 0) {
+            e->skipDraws--;
+            e->lastUse = ++m_useCount;
+            return false;
+        }
+    }
+    e->lastUse = ++m_useCount;
+
+    unsigned int changed = 0;
+    for (unsigned int c = 0; c < nChunks; c++) {
+        size_t offset = c * VERTEX_CACHE_CHUNK_SIZE;
+        size_t len = size - offset;
+        if (len > VERTEX_CACHE_CHUNK_SIZE) len = VERTEX_CACHE_CHUNK_SIZE;
+        uint64_t h = hash(bytes + offset, len);
+        if (!update->realloc && h == e->hashes[c]) {
+            continue;
+        }
+        e->hashes[c] = h;
+        changed++;
+        if (update->realloc) {
+            continue;
+        }
+        // extend the last range, or start a new one, the last range
+        // takes what is left if there are too many.
+        Range *r = update->nRanges > 0 ? &update->ranges[update->nRanges - 1] : NULL;
+        if (r != NULL && (r->offset + r->size == offset ||
+                          update->nRanges == VERTEX_CACHE_MAX_RANGES)) {
+            r->size = offset + len - r->offset;
+        } else {
+            r = &update->ranges[update->nRanges++];
+            r->offset = offset;
+            r->size = len;
+        }
+    }
+
+    if (!update->realloc) {
+        if (changed == nChunks) {
+            if (++e->changedDraws >= VERTEX_CACHE_DYNAMIC_DRAWS) {
+                e->changedDraws = 0;
+                e->skipDraws = VERTEX_CACHE_SKIP_DRAWS;
+            }
+        } else {
+            e->changedDraws = 0;
+        }
+    }
+
+    update->entry = idx;
+    update->buffer = e->buffer;
+    return true;
+}
+
+void VertexArrayCache::setBuffer(int entry, GLuint buffer)
+{
+    m_entries[entry].buffer = buffer;
+}
+
+void VertexArrayCache::discard(int entry)
+{
+    Entry *e = &m_entries[entry];
+    m_totalBytes -= e->size;
+    delete [] e->hashes;
+    memset(e, 0, sizeof(*e));
+}
@@ -0,0 +1,115 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VERTEX_ARRAY_CACHE_H_
+#define _VERTEX_ARRAY_CACHE_H_
+
+#ifdef GL_API
+    #undef GL_API
+#endif
+#define GL_API
+
+#ifdef GL_APIENTRY
+    #undef GL_APIENTRY
+#endif
+
+#ifdef GL_APIENTRYP
+    #undef GL_APIENTRYP
+#endif
+#define GL_APIENTRYP
+
+#ifndef ANDROID
+#define GL_APIENTRY
+#endif
+
+#include <GLES/gl.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define VERTEX_CACHE_MAX_ENTRIES    64
+#define VERTEX_CACHE_MAX_BYTES      (16 * 1024 * 1024)
+#define VERTEX_CACHE_MIN_SIZE       1024    // smaller arrays are sent inline
+#define VERTEX_CACHE_CHUNK_SIZE     4096
+#define VERTEX_CACHE_MAX_RANGES     8
+#define VERTEX_CACHE_MAX_DELETED    8
+
+//
+// VertexArrayCache - keeps track of client vertex arrays copied into
+// buffer objects on the server, so that drawing the same array again
+// only sends the parts that changed.
+//
+// Arrays are identified by the address and size of the range a draw
+// reads, and their content by a hash of each chunk of
+// VERTEX_CACHE_CHUNK_SIZE bytes. Ranges are evicted in least recently
+// used order to stay within VERTEX_CACHE_MAX_ENTRIES and
+// VERTEX_CACHE_MAX_BYTES. Arrays that change completely on every draw
+// stop being cached for a while.
+//
+// The cache only does the bookkeeping, the GL calls are left to the
+// encoder. It holds server buffer names and must therefore be owned by
+// the context they were created in.
+//
+class VertexArrayCache {
+public:
+    typedef struct {
+        size_t offset;
+        size_t size;
+    } Range;
+
+    typedef struct {
+        int entry;
+        GLuint buffer;      // 0 if one must be generated and passed to setBuffer()
+        bool realloc;       // the buffer must be loaded with the whole range
+        int nRanges;        // otherwise, the ranges to load
+        Range ranges[VERTEX_CACHE_MAX_RANGES];
+        int nDeleted;       // buffers of evicted entries to delete
+        GLuint deleted[VERTEX_CACHE_MAX_DELETED];
+    } Update;
+
+    VertexArrayCache();
+    ~VertexArrayCache();
+
+    // Looks up the range of 'size' bytes at 'data' and fills 'update'
+    // with what must be sent before drawing from the entry buffer.
+    // Returns false if the range should be sent inline instead. The
+    // evicted buffers must be deleted in both cases.
+    bool lookup(const void *data, size_t size, Update *update);
+    void setBuffer(int entry, GLuint buffer);
+    // forgets an entry, for instance if no buffer could be created.
+    void discard(int entry);
+
+private:
+    struct Entry {
+        const void *data;
+        size_t size;
+        GLuint buffer;
+        uint32_t lastUse;
+        uint64_t *hashes;
+        unsigned int nChunks;
+        int changedDraws;   // consecutive draws that changed every chunk
+        int skipDraws;      // draws left to send inline
+    };
+
+    int findEntry(const void *data, size_t size);
+    int allocEntry(size_t size, Update *update);
+    void evict(int entry, Update *update);
+    static uint64_t hash(const unsigned char *data, size_t size);
+
+    Entry m_entries[VERTEX_CACHE_MAX_ENTRIES];
+    size_t m_totalBytes;
+    uint32_t m_useCount;
+};
+
+#endif
@@ -20,4 +20,33 @@
 
 #define CODEC_MAX_VERTEX_ATTRIBUTES 64
 
+// set in the length word of an 'in' pointer whose data is sent
+// compressed, see PayloadCodec.h
+#define CODEC_COMPRESSED_PAYLOAD 0x80000000
+
+// fields of the attribute records of glInterleavedPointerData, one
+// record per array set from the interleaved block.
+#define CODEC_INTERLEAVED_LOCATION      0
+#define CODEC_INTERLEAVED_SIZE          1
+#define CODEC_INTERLEAVED_TYPE          2
+#define CODEC_INTERLEAVED_NORMALIZED    3
+#define CODEC_INTERLEAVED_OFFSET        4
+#define CODEC_INTERLEAVED_FIELDS        5
+
+// layout of the block returned by glGetProgramInfoBlock: a header of
+// CODEC_PROGRAM_HEADER_FIELDS GLints, then one record per active
+// attribute, then one per active uniform. A record is made of
+// CODEC_PROGRAM_VAR_FIELDS GLints followed by the name, without its
+// terminator, padded to a multiple of 4 bytes.
+#define CODEC_PROGRAM_LINK_STATUS       0
+#define CODEC_PROGRAM_NUM_ATTRIBS       1
+#define CODEC_PROGRAM_NUM_UNIFORMS      2
+#define CODEC_PROGRAM_HEADER_FIELDS     3
+
+#define CODEC_PROGRAM_VAR_LOCATION      0
+#define CODEC_PROGRAM_VAR_SIZE          1
+#define CODEC_PROGRAM_VAR_TYPE          2
+#define CODEC_PROGRAM_VAR_NAME_LENGTH   3
+#define CODEC_PROGRAM_VAR_FIELDS        4
+
 #endif
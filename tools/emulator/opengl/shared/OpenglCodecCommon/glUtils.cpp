@@ -15,8 +15,17 @@
 */
 #include "glUtils.h"
 #include <string.h>
+#include <stdint.h>
 #include "ErrorLog.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__i386__)
+#include <cpuid.h>
+#endif
+#define GLUTILS_HAVE_SSE2 1
+#endif
+
 size_t glSizeof(GLenum type)
 {
     size_t retval = 0;
@@ -293,6 +302,326 @@ size_t glUtilsParamSize(GLenum param)
     return s;
 }
 
+//
+// Kernels of the per draw loops: copying strided vertices, and the range
+// and rebasing of index arrays. Each one has a scalar version and, where
+// the compiler provides the intrinsics, an SSE2 version; the set used is
+// selected at run time from the cpu features (see glUtilsSetSimd).
+// Vertices of 4, 8, 12 and 16 bytes, the common attribute sizes, get a
+// fixed size copy; other sizes go through memcpy.
+//
+typedef void (*CopyKernel)(unsigned char *dst, const unsigned char *src,
+                           unsigned int stride, unsigned int count);
+typedef void (*GatherKernel)(unsigned char *dst, const unsigned char *src,
+                             unsigned int stride, const int *vertices, int count);
+typedef void (*RangeKernel)(const void *indices, int count, int *min, int *max);
+typedef void (*ShiftKernel)(const void *src, void *dst, int count, int offset);
+
+#define KERNEL_VSIZES   5   // 4, 8, 12 and 16 bytes, by vsize / 4
+#define KERNEL_TYPES    3   // unsigned byte, short and int indices
+
+struct Kernels {
+    CopyKernel copy[KERNEL_VSIZES];         // NULL if memcpy is used
+    GatherKernel gather[KERNEL_VSIZES];
+    RangeKernel range[KERNEL_TYPES];
+    ShiftKernel shift[KERNEL_TYPES];
+};
+
+template <class T> static void rangeScalar(const void *indices, int count, int *min, int *max)
+{
+    const T *p = (const T *)indices;
+    if (count <= 0) {
+        *min = -1;
+        *max = -1;
+        return;
+    }
+    T lo = p[0], hi = p[0];
+    for (int i = 1; i < count; i++) {
+        if (p[i] < lo) lo = p[i];
+        if (p[i] > hi) hi = p[i];
+    }
+    *min = lo;
+    *max = hi;
+}
+
+template <class T> static void shiftScalar(const void *src, void *dst, int count, int offset)
+{
+    const T *s = (const T *)src;
+    T *d = (T *)dst;
+    for (int i = 0; i < count; i++) {
+        d[i] = s[i] + offset;
+    }
+}
+
+static const Kernels s_scalarKernels = {
+    { NULL, NULL, NULL, NULL, NULL },
+    { NULL, NULL, NULL, NULL, NULL },
+    { rangeScalar<uint8_t>, rangeScalar<uint16_t>, rangeScalar<uint32_t> },
+    { shiftScalar<uint8_t>, shiftScalar<uint16_t>, shiftScalar<uint32_t> },
+};
+
+#ifdef GLUTILS_HAVE_SSE2
+
+// copies one vertex of N bytes
+template <int N> static inline void copyVertex(unsigned char *dst, const unsigned char *src);
+
+template <> inline void copyVertex<4>(unsigned char *dst, const unsigned char *src)
+{
+    memcpy(dst, src, 4);
+}
+
+template <> inline void copyVertex<8>(unsigned char *dst, const unsigned char *src)
+{
+    _mm_storel_epi64((__m128i *)dst, _mm_loadl_epi64((const __m128i *)src));
+}
+
+template <> inline void copyVertex<12>(unsigned char *dst, const unsigned char *src)
+{
+    _mm_storel_epi64((__m128i *)dst, _mm_loadl_epi64((const __m128i *)src));
+    memcpy(dst + 8, src + 8, 4);
+}
+
+template <> inline void copyVertex<16>(unsigned char *dst, const unsigned char *src)
+{
+    _mm_storeu_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+}
+
+template <int N> static void copySse2(unsigned char *dst, const unsigned char *src,
+                                      unsigned int stride, unsigned int count)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        copyVertex<N>(dst, src);
+        copyVertex<N>(dst + N, src + stride);
+        copyVertex<N>(dst + 2 * N, src + 2 * stride);
+        copyVertex<N>(dst + 3 * N, src + 3 * stride);
+        dst += 4 * N;
+        src += 4 * stride;
+    }
+    for (; i < count; i++) {
+        copyVertex<N>(dst, src);
+        dst += N;
+        src += stride;
+    }
+}
+
+template <int N> static void gatherSse2(unsigned char *dst, const unsigned char *src,
+                                        unsigned int stride, const int *vertices, int count)
+{
+    for (int i = 0; i < count; i++) {
+        copyVertex<N>(dst, src + vertices[i] * stride);
+        dst += N;
+    }
+}
+
+//
+// SSE2 only compares signed 16 and 32 bit lanes, so these indices are
+// biased by the sign bit on the way in and out.
+//
+template <class T> static inline void reduceRange(const T *lanes, const T *lanesHi,
+                                                  int n, T bias, T *lo, T *hi)
+{
+    for (int i = 0; i < n; i++) {
+        T l = lanes[i] ^ bias, h = lanesHi[i] ^ bias;
+        if (l < *lo) *lo = l;
+        if (h > *hi) *hi = h;
+    }
+}
+
+static void rangeU8Sse2(const void *indices, int count, int *min, int *max)
+{
+    const uint8_t *p = (const uint8_t *)indices;
+    if (count < 16) {
+        rangeScalar<uint8_t>(indices, count, min, max);
+        return;
+    }
+    __m128i vlo = _mm_loadu_si128((const __m128i *)p);
+    __m128i vhi = vlo;
+    int i = 16;
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        vlo = _mm_min_epu8(vlo, v);
+        vhi = _mm_max_epu8(vhi, v);
+    }
+    uint8_t l[16], h[16];
+    _mm_storeu_si128((__m128i *)l, vlo);
+    _mm_storeu_si128((__m128i *)h, vhi);
+    uint8_t lo = l[0], hi = h[0];
+    reduceRange<uint8_t>(l, h, 16, 0, &lo, &hi);
+    reduceRange<uint8_t>(p + i, p + i, count - i, 0, &lo, &hi);
+    *min = lo;
+    *max = hi;
+}
+
+static void rangeU16Sse2(const void *indices, int count, int *min, int *max)
+{
+    const uint16_t *p = (const uint16_t *)indices;
+    if (count < 8) {
+        rangeScalar<uint16_t>(indices, count, min, max);
+        return;
+    }
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i vlo = _mm_xor_si128(_mm_loadu_si128((const __m128i *)p), bias);
+    __m128i vhi = vlo;
+    int i = 8;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(p + i)), bias);
+        vlo = _mm_min_epi16(vlo, v);
+        vhi = _mm_max_epi16(vhi, v);
+    }
+    uint16_t l[8], h[8];
+    _mm_storeu_si128((__m128i *)l, vlo);
+    _mm_storeu_si128((__m128i *)h, vhi);
+    uint16_t lo = l[0] ^ 0x8000, hi = h[0] ^ 0x8000;
+    reduceRange<uint16_t>(l, h, 8, 0x8000, &lo, &hi);
+    reduceRange<uint16_t>(p + i, p + i, count - i, 0, &lo, &hi);
+    *min = lo;
+    *max = hi;
+}
+
+static void rangeU32Sse2(const void *indices, int count, int *min, int *max)
+{
+    const uint32_t *p = (const uint32_t *)indices;
+    if (count < 4) {
+        rangeScalar<uint32_t>(indices, count, min, max);
+        return;
+    }
+    const __m128i bias = _mm_set1_epi32((int)0x80000000);
+    __m128i vlo = _mm_xor_si128(_mm_loadu_si128((const __m128i *)p), bias);
+    __m128i vhi = vlo;
+    int i = 4;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(p + i)), bias);
+        __m128i lt = _mm_cmplt_epi32(v, vlo);
+        __m128i gt = _mm_cmpgt_epi32(v, vhi);
+        vlo = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vlo));
+        vhi = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vhi));
+    }
+    uint32_t l[4], h[4];
+    _mm_storeu_si128((__m128i *)l, vlo);
+    _mm_storeu_si128((__m128i *)h, vhi);
+    uint32_t lo = l[0] ^ 0x80000000, hi = h[0] ^ 0x80000000;
+    reduceRange<uint32_t>(l, h, 4, 0x80000000, &lo, &hi);
+    reduceRange<uint32_t>(p + i, p + i, count - i, 0, &lo, &hi);
+    *min = lo;
+    *max = hi;
+}
+
+static void shiftU8Sse2(const void *src, void *dst, int count, int offset)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    const __m128i o = _mm_set1_epi8((char)offset);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_add_epi8(v, o));
+    }
+    shiftScalar<uint8_t>(s + i, d + i, count - i, offset);
+}
+
+static void shiftU16Sse2(const void *src, void *dst, int count, int offset)
+{
+    const uint16_t *s = (const uint16_t *)src;
+    uint16_t *d = (uint16_t *)dst;
+    const __m128i o = _mm_set1_epi16((short)offset);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_add_epi16(v, o));
+    }
+    shiftScalar<uint16_t>(s + i, d + i, count - i, offset);
+}
+
+static void shiftU32Sse2(const void *src, void *dst, int count, int offset)
+{
+    const uint32_t *s = (const uint32_t *)src;
+    uint32_t *d = (uint32_t *)dst;
+    const __m128i o = _mm_set1_epi32(offset);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_add_epi32(v, o));
+    }
+    shiftScalar<uint32_t>(s + i, d + i, count - i, offset);
+}
+
+static const Kernels s_sse2Kernels = {
+    { NULL, copySse2<4>, copySse2<8>, copySse2<12>, copySse2<16> },
+    { NULL, gatherSse2<4>, gatherSse2<8>, gatherSse2<12>, gatherSse2<16> },
+    { rangeU8Sse2, rangeU16Sse2, rangeU32Sse2 },
+    { shiftU8Sse2, shiftU16Sse2, shiftU32Sse2 },
+};
+
+static bool cpuHasSse2()
+{
+#if defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (edx & bit_SSE2) != 0;
+#else
+    return true;    // part of x86_64
+#endif
+}
+#endif // GLUTILS_HAVE_SSE2
+
+static const Kernels *selectKernels(bool simd)
+{
+#ifdef GLUTILS_HAVE_SSE2
+    if (simd && cpuHasSse2()) {
+        return &s_sse2Kernels;
+    }
+#endif
+    return &s_scalarKernels;
+}
+
+static const Kernels *s_kernels = selectKernels(true);
+
+int glUtilsSetSimd(int enable)
+{
+    s_kernels = selectKernels(enable != 0);
+    return s_kernels != &s_scalarKernels;
+}
+
+static int kernelType(GLenum type)
+{
+    switch (type) {
+    case GL_UNSIGNED_BYTE:  return 0;
+    case GL_UNSIGNED_SHORT: return 1;
+    case GL_UNSIGNED_INT:   return 2;
+    }
+    return -1;
+}
+
+void glUtilsIndexRange(const void *indices, GLenum type, int count, int *min, int *max)
+{
+    int t = kernelType(type);
+    if (t < 0) {
+        ERR("glUtilsIndexRange: unsupported index type 0x%x\n", type);
+        *min = -1;
+        *max = -1;
+        return;
+    }
+    s_kernels->range[t](indices, count, min, max);
+}
+
+void glUtilsShiftIndices(const void *src, void *dst, GLenum type, int count, int offset)
+{
+    int t = kernelType(type);
+    if (t < 0) {
+        ERR("glUtilsShiftIndices: unsupported index type 0x%x\n", type);
+        return;
+    }
+    s_kernels->shift[t](src, dst, count, offset);
+}
+
+static CopyKernel copyKernel(unsigned int vsize)
+{
+    return (vsize & 3) == 0 && vsize / 4 < KERNEL_VSIZES ? s_kernels->copy[vsize / 4] : NULL;
+}
+
 void glUtilsPackPointerData(unsigned char *dst, unsigned char *src,
                      int size, GLenum type, unsigned int stride,
                      unsigned int datalen)
@@ -300,8 +629,11 @@ void glUtilsPackPointerData(unsigned char *dst, unsigned char *src,
     unsigned int  vsize = size * glSizeof(type);
     if (stride == 0) stride = vsize;
 
+    CopyKernel copy;
     if (stride == vsize) {
         memcpy(dst, src, datalen);
+    } else if ((copy = copyKernel(vsize)) != NULL) {
+        copy(dst, src, stride, (datalen + vsize - 1) / vsize);
     } else {
         for (unsigned int i = 0; i < datalen; i += vsize) {
             memcpy(dst, src, vsize);
@@ -311,6 +643,24 @@ void glUtilsPackPointerData(unsigned char *dst, unsigned char *src,
     }
 }
 
+void glUtilsGatherVertices(unsigned char *dst, unsigned char *src,
+                           unsigned int vsize, unsigned int stride,
+                           const int *vertices, int count)
+{
+    if (stride == 0) stride = vsize;
+
+    GatherKernel gather = (vsize & 3) == 0 && vsize / 4 < KERNEL_VSIZES ?
+            s_kernels->gather[vsize / 4] : NULL;
+    if (gather != NULL) {
+        gather(dst, src, stride, vertices, count);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        memcpy(dst, src + vertices[i] * stride, vsize);
+        dst += vsize;
+    }
+}
+
 int glUtilsPixelBitSize(GLenum format, GLenum type)
 {
     int components = 0;
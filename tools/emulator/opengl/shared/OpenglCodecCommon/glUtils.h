@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef GL_API
     #undef GL_API
@@ -51,9 +52,20 @@ extern "C" {
     void   glUtilsPackPointerData(unsigned char *dst, unsigned char *str,
                            int size, GLenum type, unsigned int stride,
                            unsigned int datalen);
+    void   glUtilsGatherVertices(unsigned char *dst, unsigned char *src,
+                           unsigned int vsize, unsigned int stride,
+                           const int *vertices, int count);
     int glUtilsPixelBitSize(GLenum format, GLenum type);
     void   glUtilsPackStrings(char *ptr, char **strings, GLint *length, GLsizei count);
     int glUtilsCalcShaderSourceLen(char **strings, GLint *length, GLsizei count);
+
+    // index kernels, for GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT and
+    // GL_UNSIGNED_INT indices. min and max are -1 if count is 0.
+    void   glUtilsIndexRange(const void *indices, GLenum type, int count, int *min, int *max);
+    void   glUtilsShiftIndices(const void *src, void *dst, GLenum type, int count, int offset);
+    // selects the SIMD kernels if enable is not 0 and the cpu has them,
+    // or the scalar ones. Returns 1 if the SIMD kernels are in use.
+    int    glUtilsSetSimd(int enable);
 #ifdef __cplusplus
 };
 #endif
@@ -88,5 +100,69 @@ namespace GLUtils {
             src++;
         }
     }
+
+    // the index types GL knows about go through the kernels of glUtils.cpp
+    template <> inline void minmax<unsigned char>(unsigned char *indices, int count, int *min, int *max) {
+        glUtilsIndexRange(indices, GL_UNSIGNED_BYTE, count, min, max);
+    }
+    template <> inline void minmax<unsigned short>(unsigned short *indices, int count, int *min, int *max) {
+        glUtilsIndexRange(indices, GL_UNSIGNED_SHORT, count, min, max);
+    }
+    template <> inline void minmax<unsigned int>(unsigned int *indices, int count, int *min, int *max) {
+        glUtilsIndexRange(indices, GL_UNSIGNED_INT, count, min, max);
+    }
+
+    template <> inline void shiftIndices<unsigned char>(unsigned char *indices, int count, int offset) {
+        glUtilsShiftIndices(indices, indices, GL_UNSIGNED_BYTE, count, offset);
+    }
+    template <> inline void shiftIndices<unsigned short>(unsigned short *indices, int count, int offset) {
+        glUtilsShiftIndices(indices, indices, GL_UNSIGNED_SHORT, count, offset);
+    }
+    template <> inline void shiftIndices<unsigned int>(unsigned int *indices, int count, int offset) {
+        glUtilsShiftIndices(indices, indices, GL_UNSIGNED_INT, count, offset);
+    }
+
+    template <> inline void shiftIndices<unsigned char>(unsigned char *src, unsigned char *dst, int count, int offset) {
+        glUtilsShiftIndices(src, dst, GL_UNSIGNED_BYTE, count, offset);
+    }
+    template <> inline void shiftIndices<unsigned short>(unsigned short *src, unsigned short *dst, int count, int offset) {
+        glUtilsShiftIndices(src, dst, GL_UNSIGNED_SHORT, count, offset);
+    }
+    template <> inline void shiftIndices<unsigned int>(unsigned int *src, unsigned int *dst, int count, int offset) {
+        glUtilsShiftIndices(src, dst, GL_UNSIGNED_INT, count, offset);
+    }
+
+    // Only compact the vertices of an indexed draw from client arrays
+    // if there are fewer indices than vertices in their range, and if
+    // the vertices used are at most 3/4 of that range.
+    inline bool tryCompaction(int count, int minIndex, int maxIndex) {
+        return count > 0 && count < maxIndex - minIndex + 1;
+    }
+
+    inline bool compactionPays(int used, int minIndex, int maxIndex) {
+        int range = maxIndex - minIndex + 1;
+        return used <= range - range / 4;
+    }
+
+    // Numbers the vertices used by the indices in order of first use.
+    // 'dst' receives the new indices and 'vertices' the original index
+    // of each vertex used. 'map' must have room for maxIndex - minIndex
+    // + 1 entries. Returns the number of vertices used.
+    template <class T> int compactIndices(T *src, T *dst, int count,
+                                          int minIndex, int maxIndex,
+                                          int *map, int *vertices)
+    {
+        memset(map, 0xff, (maxIndex - minIndex + 1) * sizeof(int));
+        int used = 0;
+        for (int i = 0; i < count; i++) {
+            int v = src[i] - minIndex;
+            if (map[v] < 0) {
+                map[v] = used;
+                vertices[used++] = src[i];
+            }
+            dst[i] = (T)map[v];
+        }
+        return used;
+    }
 }; // namespace GLUtils
 #endif
@@ -36,6 +36,7 @@ Thread::start()
     m_isRunning = true;
     int ret = pthread_create(&m_thread, NULL, Thread::thread_main, this);
     if(ret) {
+        m_thread = (pthread_t)NULL;
         m_isRunning = false;
     }
     pthread_mutex_unlock(&m_lock);
@@ -45,7 +46,8 @@ Thread::start()
 bool
 Thread::wait(int *exitStatus)
 {
-    if (!m_isRunning) {
+    // the thread may have finished already but still needs to be joined
+    if (!m_thread) {
         return false;
     }
 
@@ -53,6 +55,7 @@ Thread::wait(int *exitStatus)
     if (pthread_join(m_thread,&retval)) {
         return false;
     }
+    m_thread = (pthread_t)NULL;
 
     long long int ret=(long long int)retval;
     if (exitStatus) {
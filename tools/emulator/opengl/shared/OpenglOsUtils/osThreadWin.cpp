@@ -45,7 +45,8 @@ Thread::start()
 bool
 Thread::wait(int *exitStatus)
 {
-    if (!m_isRunning) {
+    // the thread may have finished already, its handle is still valid
+    if (!m_thread) {
         return false;
     }
 
@@ -69,7 +70,7 @@ Thread::wait(int *exitStatus)
 bool
 Thread::trywait(int *exitStatus)
 {
-    if (!m_isRunning) {
+    if (!m_thread) {
         return false;
     }
 
@@ -42,5 +42,9 @@ $(GEN_GL) : $(EMUGEN) \
         $(LOCAL_PATH)//gl.types
 	$(transform-generated-source)
 
+ifneq (,$(BUILD_EMULATOR_OPENGL_TRACE))
+LOCAL_CFLAGS += -DCODEC_TRACE
+endif
+
 LOCAL_GENERATED_SOURCES += $(GEN_GL)
 include $(BUILD_SHARED_LIBRARY)
@@ -50,7 +50,8 @@ void GLEncoder::s_glGetIntegerv(void *self, GLenum param, GLint *ptr)
             memcpy(ptr, compressedTextureFormats, ctx->m_num_compressedTextureFormats * sizeof(GLint));
         }
     }
-    else if (!ctx->m_state->getClientStateParameter<GLint>(param,ptr)) {
+    else if (!ctx->m_state->getClientStateParameter<GLint>(param,ptr) &&
+             !ctx->m_state->shadow()->getParameter<GLint>(param,ptr)) {
         ctx->m_glGetIntegerv_enc(self, param, ptr);
     }
 }
@@ -67,7 +68,8 @@ void GLEncoder::s_glGetFloatv(void *self, GLenum param, GLfloat *ptr)
             }
         }
     }
-    else if (!ctx->m_state->getClientStateParameter<GLfloat>(param,ptr)) {
+    else if (!ctx->m_state->getClientStateParameter<GLfloat>(param,ptr) &&
+             !ctx->m_state->shadow()->getParameter<GLfloat>(param,ptr)) {
         ctx->m_glGetFloatv_enc(self, param, ptr);
     }
 }
@@ -96,7 +98,8 @@ void GLEncoder::s_glGetBooleanv(void *self, GLenum param, GLboolean *ptr)
     if (param == GL_COMPRESSED_TEXTURE_FORMATS) {
         // ignore the command, although we should have generated a GLerror;
     }
-    else if (!ctx->m_state->getClientStateParameter<GLboolean>(param,ptr)) {
+    else if (!ctx->m_state->getClientStateParameter<GLboolean>(param,ptr) &&
+             !ctx->m_state->shadow()->getParameter<GLboolean>(param,ptr)) {
         ctx->m_glGetBooleanv_enc(self, param, ptr);
     }
 }
@@ -115,6 +118,22 @@ void GLEncoder::s_glFlush(void *self)
     ctx->m_stream->flush();
 }
 
+GLenum GLEncoder::s_glGetError(void *self)
+{
+    GLEncoder *ctx = (GLEncoder *)self;
+    if (ctx->m_replyStatus == NULL) {
+        return ctx->m_glGetError_enc(self);
+    }
+    // the errors that came with the replies since the last call; in strict
+    // mode the server is asked about the calls sent after the latest reply
+    GLenum error = ctx->m_replyStatus->take();
+    if (error == GL_NO_ERROR && ctx->m_strictErrors &&
+        ctx->m_replyStatus->unanswered(ctx->m_stream)) {
+        error = ctx->m_glGetError_enc(self);
+    }
+    return error;
+}
+
 GLubyte *GLEncoder::s_glGetString(void *self, GLenum name)
 {
     GLubyte *retval =  (GLubyte *) "";
@@ -228,6 +247,10 @@ GLboolean GLEncoder::s_glIsEnabled(void *self, GLenum cap)
     if (state!=NULL)
       return state->enabled;
 
+    GLboolean enabled;
+    if (ctx->m_state->shadow()->isEnabled(cap, &enabled))
+      return enabled;
+
     return ctx->m_glIsEnabled_enc(self,cap);
 }
 
@@ -240,9 +263,195 @@ void GLEncoder::s_glBindBuffer(void *self, GLenum target, GLuint id)
     ctx->m_glBindBuffer_enc(self, target, id);
 }
 
-void GLEncoder::sendVertexData(unsigned int first, unsigned int count)
+void GLEncoder::s_glEnable(void *self, GLenum cap)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->enable(cap, true)) {
+        ctx->m_glEnable_enc(self, cap);
+    }
+}
+
+void GLEncoder::s_glDisable(void *self, GLenum cap)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->enable(cap, false)) {
+        ctx->m_glDisable_enc(self, cap);
+    }
+}
+
+void GLEncoder::s_glActiveTexture(void *self, GLenum texture)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    GLStateShadow *shadow = ctx->m_state->shadow();
+    if (!shadow->maxTextureUnitsKnown()) {
+        GLint units = 0;
+        ctx->m_glGetIntegerv_enc(self, shadow->maxTextureUnitsParam(), &units);
+        shadow->setMaxTextureUnits(units);
+    }
+    if (shadow->activeTexture(texture)) {
+        ctx->m_glActiveTexture_enc(self, texture);
+    }
+}
+
+void GLEncoder::s_glBindTexture(void *self, GLenum target, GLuint texture)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->bindTexture(target, texture)) {
+        ctx->m_glBindTexture_enc(self, target, texture);
+    }
+}
+
+void GLEncoder::s_glDeleteTextures(void *self, GLsizei n, GLuint *textures)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (n > 0 && textures != NULL) {
+        ctx->m_state->shadow()->deleteTextures(n, textures);
+    }
+    ctx->m_glDeleteTextures_enc(self, n, textures);
+}
+
+void GLEncoder::s_glBlendFunc(void *self, GLenum sfactor, GLenum dfactor)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->blendFunc(sfactor, dfactor)) {
+        ctx->m_glBlendFunc_enc(self, sfactor, dfactor);
+    }
+}
+
+void GLEncoder::s_glBlendFuncSeparateOES(void *self, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->blendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha)) {
+        ctx->m_glBlendFuncSeparateOES_enc(self, srcRGB, dstRGB, srcAlpha, dstAlpha);
+    }
+}
+
+void GLEncoder::s_glDepthFunc(void *self, GLenum func)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->depthFunc(func)) {
+        ctx->m_glDepthFunc_enc(self, func);
+    }
+}
+
+void GLEncoder::s_glDepthMask(void *self, GLboolean flag)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->depthMask(flag)) {
+        ctx->m_glDepthMask_enc(self, flag);
+    }
+}
+
+void GLEncoder::s_glCullFace(void *self, GLenum mode)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->cullFace(mode)) {
+        ctx->m_glCullFace_enc(self, mode);
+    }
+}
+
+void GLEncoder::s_glFrontFace(void *self, GLenum mode)
+{
+    GLEncoder *ctx = (GLEncoder *) self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->frontFace(mode)) {
+        ctx->m_glFrontFace_enc(self, mode);
+    }
+}
+
+void GLEncoder::sendPointerOffset(int location, const GLClientState::VertexAttribState *state, GLuint offset)
+{
+    switch(location) {
+    case GLClientState::VERTEX_LOCATION:
+        this->glVertexPointerOffset(this, state->size, state->type, state->stride, offset);
+        break;
+    case GLClientState::NORMAL_LOCATION:
+        this->glNormalPointerOffset(this, state->type, state->stride, offset);
+        break;
+    case GLClientState::POINTSIZE_LOCATION:
+        this->glPointSizePointerOffset(this, state->type, state->stride, offset);
+        break;
+    case GLClientState::COLOR_LOCATION:
+        this->glColorPointerOffset(this, state->size, state->type, state->stride, offset);
+        break;
+    case GLClientState::TEXCOORD0_LOCATION:
+    case GLClientState::TEXCOORD1_LOCATION:
+    case GLClientState::TEXCOORD2_LOCATION:
+    case GLClientState::TEXCOORD3_LOCATION:
+    case GLClientState::TEXCOORD4_LOCATION:
+    case GLClientState::TEXCOORD5_LOCATION:
+    case GLClientState::TEXCOORD6_LOCATION:
+    case GLClientState::TEXCOORD7_LOCATION:
+        this->glTexCoordPointerOffset(this, state->size, state->type, state->stride, offset);
+        break;
+    case GLClientState::WEIGHT_LOCATION:
+        this->glWeightPointerOffset(this, state->size, state->type, state->stride, offset);
+        break;
+    case GLClientState::MATRIXINDEX_LOCATION:
+        this->glMatrixIndexPointerOffset(this, state->size, state->type, state->stride, offset);
+        break;
+    }
+}
+
+bool GLEncoder::sendCachedArray(int location, const GLClientState::VertexAttribState *state,
+                                unsigned int first, unsigned int count)
+{
+    if (count == 0) {
+        return false;
+    }
+    int stride = state->stride;
+    if (stride == 0) stride = state->elementSize;
+    unsigned char *data = (unsigned char *)state->data + stride * first;
+    size_t size = stride * (count - 1) + state->elementSize;
+
+    VertexArrayCache *cache = m_state->vertexArrayCache();
+    VertexArrayCache::Update update;
+    bool cached = cache->lookup(data, size, &update);
+    if (update.nDeleted > 0) {
+        this->glDeleteBuffers(this, update.nDeleted, update.deleted);
+    }
+    if (!cached) {
+        return false;
+    }
+    if (update.buffer == 0) {
+        this->glGenBuffers(this, 1, &update.buffer);
+        if (update.buffer == 0) {
+            cache->discard(update.entry);
+            return false;
+        }
+        cache->setBuffer(update.entry, update.buffer);
+    }
+
+    m_glBindBuffer_enc(this, GL_ARRAY_BUFFER, update.buffer);
+    if (update.realloc) {
+        this->glBufferData(this, GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+    } else {
+        for (int r = 0; r < update.nRanges; r++) {
+            this->glBufferSubData(this, GL_ARRAY_BUFFER, update.ranges[r].offset,
+                                  update.ranges[r].size, data + update.ranges[r].offset);
+        }
+    }
+    sendPointerOffset(location, state, 0);
+    return true;
+}
+
+void GLEncoder::sendVertexData(unsigned int first, unsigned int count, const int *vertices)
 {
     assert(m_state != NULL);
+    bool cacheBound = false;
+    bool interleaved = m_interleavedArraysEnabled && vertices == NULL &&
+                       !m_vertexArrayCacheEnabled &&
+                       m_state->findInterleavedArrays(count) > 0;
     for (int i = 0; i < GLClientState::LAST_LOCATION; i++) {
         bool enableDirty;
         const GLClientState::VertexAttribState *state = m_state->getStateAndEnableDirty(i, &enableDirty);
@@ -268,20 +477,33 @@ void GLEncoder::sendVertexData(unsigned int first, unsigned int count)
             if (stride == 0) stride = state->elementSize;
             int firstIndex = stride * first;
 
-            if (state->bufferObject == 0) {
+            if (interleaved && m_state->interleavedGroup(i) >= 0) {
+                // sent below, along with the rest of its block
+            } else if (state->bufferObject == 0 && vertices == NULL && m_vertexArrayCacheEnabled &&
+                sendCachedArray(i, state, first, count)) {
+                cacheBound = true;
+            } else if (state->bufferObject == 0) {
+                unsigned char *data = (unsigned char *)state->data + firstIndex;
+                GLsizei dataStride = state->stride;
+                if (vertices != NULL) {
+                    data = (unsigned char *)m_gatherBuffer.alloc(datalen);
+                    glUtilsGatherVertices(data, (unsigned char *)state->data, state->elementSize,
+                                          state->stride, vertices, count);
+                    dataStride = 0;
+                }
 
                 switch(i) {
                 case GLClientState::VERTEX_LOCATION:
-                    this->glVertexPointerData(this, state->size, state->type, state->stride,
-                                              (unsigned char *)state->data + firstIndex, datalen);
+                    this->glVertexPointerData(this, state->size, state->type, dataStride,
+                                              data, datalen);
                     break;
                 case GLClientState::NORMAL_LOCATION:
-                    this->glNormalPointerData(this, state->type, state->stride,
-                                              (unsigned char *)state->data + firstIndex, datalen);
+                    this->glNormalPointerData(this, state->type, dataStride,
+                                              data, datalen);
                     break;
                 case GLClientState::COLOR_LOCATION:
-                    this->glColorPointerData(this, state->size, state->type, state->stride,
-                                             (unsigned char *)state->data + firstIndex, datalen);
+                    this->glColorPointerData(this, state->size, state->type, dataStride,
+                                             data, datalen);
                     break;
                 case GLClientState::TEXCOORD0_LOCATION:
                 case GLClientState::TEXCOORD1_LOCATION:
@@ -291,67 +513,50 @@ void GLEncoder::sendVertexData(unsigned int first, unsigned int count)
                 case GLClientState::TEXCOORD5_LOCATION:
                 case GLClientState::TEXCOORD6_LOCATION:
                 case GLClientState::TEXCOORD7_LOCATION:
-                    this->glTexCoordPointerData(this, i - GLClientState::TEXCOORD0_LOCATION, state->size, state->type, state->stride,
-                                                (unsigned char *)state->data + firstIndex, datalen);
+                    this->glTexCoordPointerData(this, i - GLClientState::TEXCOORD0_LOCATION, state->size, state->type, dataStride,
+                                                data, datalen);
                     break;
                 case GLClientState::POINTSIZE_LOCATION:
-                    this->glPointSizePointerData(this, state->type, state->stride,
-                                                 (unsigned char *) state->data + firstIndex, datalen);
+                    this->glPointSizePointerData(this, state->type, dataStride,
+                                                 data, datalen);
                     break;
                 case GLClientState::WEIGHT_LOCATION:
-                    this->glWeightPointerData(this, state->size, state->type, state->stride,
-                                              (unsigned char * ) state->data + firstIndex, datalen);
+                    this->glWeightPointerData(this, state->size, state->type, dataStride,
+                                              data, datalen);
                     break;
                 case GLClientState::MATRIXINDEX_LOCATION:
-                    this->glMatrixIndexPointerData(this, state->size, state->type, state->stride,
-                                                  (unsigned char *)state->data + firstIndex, datalen);
+                    this->glMatrixIndexPointerData(this, state->size, state->type, dataStride,
+                                                  data, datalen);
                     break;
                 }
             } else {
                 this->glBindBuffer(this, GL_ARRAY_BUFFER, state->bufferObject);
-
-                switch(i) {
-                case GLClientState::VERTEX_LOCATION:
-                    this->glVertexPointerOffset(this, state->size, state->type, state->stride,
-                                                (GLuint)state->data + firstIndex);
-                    break;
-                case GLClientState::NORMAL_LOCATION:
-                    this->glNormalPointerOffset(this, state->type, state->stride,
-                                                (GLuint) state->data + firstIndex);
-                    break;
-                case GLClientState::POINTSIZE_LOCATION:
-                    this->glPointSizePointerOffset(this, state->type, state->stride,
-                                                   (GLuint) state->data + firstIndex);
-                    break;
-                case GLClientState::COLOR_LOCATION:
-                    this->glColorPointerOffset(this, state->size, state->type, state->stride,
-                                               (GLuint) state->data + firstIndex);
-                    break;
-                case GLClientState::TEXCOORD0_LOCATION:
-                case GLClientState::TEXCOORD1_LOCATION:
-                case GLClientState::TEXCOORD2_LOCATION:
-                case GLClientState::TEXCOORD3_LOCATION:
-                case GLClientState::TEXCOORD4_LOCATION:
-                case GLClientState::TEXCOORD5_LOCATION:
-                case GLClientState::TEXCOORD6_LOCATION:
-                case GLClientState::TEXCOORD7_LOCATION:
-                    this->glTexCoordPointerOffset(this, state->size, state->type, state->stride,
-                                                  (GLuint) state->data + firstIndex);
-                    break;
-                case GLClientState::WEIGHT_LOCATION:
-                    this->glWeightPointerOffset(this,state->size,state->type,state->stride,
-                                                (GLuint)state->data+firstIndex);
-                    break;
-                case GLClientState::MATRIXINDEX_LOCATION:
-                    this->glMatrixIndexPointerOffset(this,state->size,state->type,state->stride,
-                                              (GLuint)state->data+firstIndex);
-                    break;
-                }
+                sendPointerOffset(i, state, (GLuint)state->data + firstIndex);
             }
         } else {
             this->m_glDisableClientState_enc(this, state->glConst);
         }
     }
+
+    // the decoder selects the texture unit of each texture coordinates
+    // array in a block, which is selected again for any other array.
+    for (int i = 0; interleaved && i < GLClientState::LAST_LOCATION; i++) {
+        if (m_state->interleavedGroup(i) == i) {
+            const GLuint *attribs;
+            unsigned char *data;
+            GLuint datalen;
+            GLsizei stride;
+            int n = m_state->getInterleavedBlock(i, first, count, &attribs, &data, &datalen, &stride);
+            this->glInterleavedPointerData(this, n, (GLuint *)attribs,
+                                           n * CODEC_INTERLEAVED_FIELDS * sizeof(GLuint),
+                                           stride, data, datalen);
+        }
+    }
+
+    // the cache buffers are not visible to the application
+    if (cacheBound) {
+        m_glBindBuffer_enc(this, GL_ARRAY_BUFFER, m_state->currentArrayVbo());
+    }
 }
 
 void GLEncoder::s_glDrawArrays(void *self, GLenum mode, GLint first, GLsizei count)
@@ -397,12 +602,31 @@ void GLEncoder::s_glDrawElements(void *self, GLenum mode, GLsizei count, GLenum
     } else {
         void *adjustedIndices = indices;
         int minIndex = 0, maxIndex = 0;
+        int *vertices = NULL;
+        int nVertices = 0;
 
+        // with client arrays only, the vertices may be compacted so that
+        // only those used are sent, see GLUtils::compactionPays(). The
+        // vertex array cache does better with the same range every time.
+        bool compact = !has_indirect_arrays && !ctx->m_vertexArrayCacheEnabled;
         switch(type) {
         case GL_BYTE:
         case GL_UNSIGNED_BYTE:
             GLUtils::minmax<unsigned char>((unsigned char *)indices, count, &minIndex, &maxIndex);
-            if (minIndex != 0) {
+            if (compact && GLUtils::tryCompaction(count, minIndex, maxIndex)) {
+                int *map = (int *)ctx->m_compactBuffer.alloc((maxIndex - minIndex + 1 + count) * sizeof(int));
+                vertices = map + maxIndex - minIndex + 1;
+                adjustedIndices = ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
+                nVertices = GLUtils::compactIndices<unsigned char>((unsigned char *)indices,
+                                                                   (unsigned char *)adjustedIndices,
+                                                                   count, minIndex, maxIndex,
+                                                                   map, vertices);
+                if (!GLUtils::compactionPays(nVertices, minIndex, maxIndex)) {
+                    vertices = NULL;
+                    adjustedIndices = indices;
+                }
+            }
+            if (vertices == NULL && minIndex != 0) {
                 adjustedIndices =  ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
                 GLUtils::shiftIndices<unsigned char>((unsigned char *)indices,
                                                  (unsigned char *)adjustedIndices,
@@ -412,7 +636,20 @@ void GLEncoder::s_glDrawElements(void *self, GLenum mode, GLsizei count, GLenum
         case GL_SHORT:
         case GL_UNSIGNED_SHORT:
             GLUtils::minmax<unsigned short>((unsigned short *)indices, count, &minIndex, &maxIndex);
-            if (minIndex != 0) {
+            if (compact && GLUtils::tryCompaction(count, minIndex, maxIndex)) {
+                int *map = (int *)ctx->m_compactBuffer.alloc((maxIndex - minIndex + 1 + count) * sizeof(int));
+                vertices = map + maxIndex - minIndex + 1;
+                adjustedIndices = ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
+                nVertices = GLUtils::compactIndices<unsigned short>((unsigned short *)indices,
+                                                                    (unsigned short *)adjustedIndices,
+                                                                    count, minIndex, maxIndex,
+                                                                    map, vertices);
+                if (!GLUtils::compactionPays(nVertices, minIndex, maxIndex)) {
+                    vertices = NULL;
+                    adjustedIndices = indices;
+                }
+            }
+            if (vertices == NULL && minIndex != 0) {
                 adjustedIndices = ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
                 GLUtils::shiftIndices<unsigned short>((unsigned short *)indices,
                                                  (unsigned short *)adjustedIndices,
@@ -422,19 +659,13 @@ void GLEncoder::s_glDrawElements(void *self, GLenum mode, GLsizei count, GLenum
         default:
             LOGE("unsupported index buffer type %d\n", type);
         }
-        if (has_indirect_arrays || 1) {
-            ctx->sendVertexData(minIndex, maxIndex - minIndex + 1);
-            ctx->glDrawElementsData(ctx, mode, count, type, adjustedIndices,
-                                      count * glSizeof(type));
-            // XXX - OPTIMIZATION (see the other else branch) should be implemented
-            if(!has_indirect_arrays) {
-                //LOGD("unoptimized drawelements !!!\n");
-            }
+        if (vertices != NULL) {
+            ctx->sendVertexData(0, nVertices, vertices);
         } else {
-            // we are all direct arrays and immidate mode index array -
-            // rebuild the arrays and the index array;
-            LOGE("glDrawElements: direct index & direct buffer data - will be implemented in later versions;\n");
+            ctx->sendVertexData(minIndex, maxIndex - minIndex + 1);
         }
+        ctx->glDrawElementsData(ctx, mode, count, type, adjustedIndices,
+                                count * glSizeof(type));
     }
 }
 
@@ -442,8 +673,12 @@ GLEncoder::GLEncoder(IOStream *stream) : gl_encoder_context_t(stream)
 {
     m_state = NULL;
     m_compressedTextureFormats = NULL;
+    m_vertexArrayCacheEnabled = false;
+    m_interleavedArraysEnabled = false;
+    m_strictErrors = false;
     // overrides;
     m_glFlush_enc = set_glFlush(s_glFlush);
+    m_glGetError_enc = set_glGetError(s_glGetError);
     m_glPixelStorei_enc = set_glPixelStorei(s_glPixelStorei);
     m_glVertexPointer_enc = set_glVertexPointer(s_glVertexPointer);
     m_glNormalPointer_enc = set_glNormalPointer(s_glNormalPointer);
@@ -468,6 +703,18 @@ GLEncoder::GLEncoder(IOStream *stream) : gl_encoder_context_t(stream)
     m_glDrawElements_enc = set_glDrawElements(s_glDrawElements);
     set_glGetString(s_glGetString);
 
+    m_glEnable_enc = set_glEnable(s_glEnable);
+    m_glDisable_enc = set_glDisable(s_glDisable);
+    m_glActiveTexture_enc = set_glActiveTexture(s_glActiveTexture);
+    m_glBindTexture_enc = set_glBindTexture(s_glBindTexture);
+    m_glDeleteTextures_enc = set_glDeleteTextures(s_glDeleteTextures);
+    m_glBlendFunc_enc = set_glBlendFunc(s_glBlendFunc);
+    m_glBlendFuncSeparateOES_enc = set_glBlendFuncSeparateOES(s_glBlendFuncSeparateOES);
+    m_glDepthFunc_enc = set_glDepthFunc(s_glDepthFunc);
+    m_glDepthMask_enc = set_glDepthMask(s_glDepthMask);
+    m_glCullFace_enc = set_glCullFace(s_glCullFace);
+    m_glFrontFace_enc = set_glFrontFace(s_glFrontFace);
+
 }
 
 GLEncoder::~GLEncoder()
@@ -27,15 +27,34 @@ public:
     virtual ~GLEncoder();
     void setClientState(GLClientState *state) {
         m_state = state;
+        if (m_replyStatus != NULL) {
+            m_replyStatus->setPending(m_state != NULL ? m_state->pendingError() : NULL);
+        }
+        if (m_state != NULL) {
+            m_state->shadow()->setApi(GLStateShadow::GLES1);
+        }
     }
     void flush() { m_stream->flush(); }
     size_t pixelDataSize(GLsizei width, GLsizei height, GLenum format, GLenum type, int pack);
+    // copy client arrays into buffers on the server, see VertexArrayCache
+    void setVertexArrayCacheEnabled(bool enabled) { m_vertexArrayCacheEnabled = enabled; }
+    // send interleaved client arrays once, needs RENDERER_CAP_INTERLEAVED_ARRAYS
+    void setInterleavedArraysEnabled(bool enabled) { m_interleavedArraysEnabled = enabled; }
+    // with m_replyStatus set, glGetError answers with the errors that came
+    // with the replies; strict, it also asks the server when calls were
+    // sent after the latest reply
+    void setStrictErrors(bool strict) { m_strictErrors = strict; }
 private:
 
     GLClientState *m_state;
     FixedBuffer m_fixedBuffer;
+    FixedBuffer m_compactBuffer;    // index map and vertex list of compacted draws
+    FixedBuffer m_gatherBuffer;     // vertices of compacted draws
     GLint *m_compressedTextureFormats;
     GLint m_num_compressedTextureFormats;
+    bool m_vertexArrayCacheEnabled;
+    bool m_interleavedArraysEnabled;
+    bool m_strictErrors;
 
     GLint *getCompressedTextureFormats();
     // original functions;
@@ -62,6 +81,20 @@ private:
     glDrawArrays_client_proc_t m_glDrawArrays_enc;
     glDrawElements_client_proc_t m_glDrawElements_enc;
     glFlush_client_proc_t m_glFlush_enc;
+    glGetError_client_proc_t m_glGetError_enc;
+
+    // server state shadowed in m_state->shadow()
+    glEnable_client_proc_t m_glEnable_enc;
+    glDisable_client_proc_t m_glDisable_enc;
+    glActiveTexture_client_proc_t m_glActiveTexture_enc;
+    glBindTexture_client_proc_t m_glBindTexture_enc;
+    glDeleteTextures_client_proc_t m_glDeleteTextures_enc;
+    glBlendFunc_client_proc_t m_glBlendFunc_enc;
+    glBlendFuncSeparateOES_client_proc_t m_glBlendFuncSeparateOES_enc;
+    glDepthFunc_client_proc_t m_glDepthFunc_enc;
+    glDepthMask_client_proc_t m_glDepthMask_enc;
+    glCullFace_client_proc_t m_glCullFace_enc;
+    glFrontFace_client_proc_t m_glFrontFace_enc;
 
     // statics
     static void s_glGetIntegerv(void *self, GLenum pname, GLint *ptr);
@@ -71,6 +104,7 @@ private:
     static void s_glGetPointerv(void *self, GLenum pname, GLvoid **params);
 
     static void s_glFlush(void * self);
+    static GLenum s_glGetError(void *self);
     static GLubyte * s_glGetString(void *self, GLenum name);
     static void s_glVertexPointer(void *self, int size, GLenum type, GLsizei stride, void *data);
     static void s_glNormalPointer(void *self, GLenum type, GLsizei stride, void *data);
@@ -87,6 +121,23 @@ private:
     static void s_glDrawArrays(void *self, GLenum mode, GLint first, GLsizei count);
     static void s_glDrawElements(void *self, GLenum mode, GLsizei count, GLenum type, void *indices);
     static void s_glPixelStorei(void *self, GLenum param, GLint value);
-    void sendVertexData(unsigned first, unsigned count);
+
+    static void s_glEnable(void *self, GLenum cap);
+    static void s_glDisable(void *self, GLenum cap);
+    static void s_glActiveTexture(void *self, GLenum texture);
+    static void s_glBindTexture(void *self, GLenum target, GLuint texture);
+    static void s_glDeleteTextures(void *self, GLsizei n, GLuint *textures);
+    static void s_glBlendFunc(void *self, GLenum sfactor, GLenum dfactor);
+    static void s_glBlendFuncSeparateOES(void *self, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+    static void s_glDepthFunc(void *self, GLenum func);
+    static void s_glDepthMask(void *self, GLboolean flag);
+    static void s_glCullFace(void *self, GLenum mode);
+    static void s_glFrontFace(void *self, GLenum mode);
+    // sends the arrays for vertices first to first + count - 1, or for
+    // the count vertices listed in 'vertices' if not NULL.
+    void sendVertexData(unsigned first, unsigned count, const int *vertices = NULL);
+    void sendPointerOffset(int location, const GLClientState::VertexAttribState *state, GLuint offset);
+    bool sendCachedArray(int location, const GLClientState::VertexAttribState *state,
+                         unsigned int first, unsigned int count);
 };
 #endif
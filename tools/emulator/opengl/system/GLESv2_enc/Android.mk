@@ -43,6 +43,10 @@ $(GEN_GL2) : $(EMUGEN) \
         $(LOCAL_PATH)/gl2.types
 	$(transform-generated-source)
 
+ifneq (,$(BUILD_EMULATOR_OPENGL_TRACE))
+LOCAL_CFLAGS += -DCODEC_TRACE
+endif
+
 LOCAL_GENERATED_SOURCES += $(GEN_GL2)
 include $(BUILD_SHARED_LIBRARY)
 
@@ -10,7 +10,11 @@ static GLubyte *gExtensionsString= (GLubyte *) ""; // no extensions at this poin
 GL2Encoder::GL2Encoder(IOStream *stream) : gl2_encoder_context_t(stream)
 {
     m_state = NULL;
+    m_interleavedArraysEnabled = false;
+    m_programCacheEnabled = false;
+    m_strictErrors = false;
     m_glFlush_enc = set_glFlush(s_glFlush);
+    m_glGetError_enc = set_glGetError(s_glGetError);
     m_glPixelStorei_enc = set_glPixelStorei(s_glPixelStorei);
     m_glGetString_enc = set_glGetString(s_glGetString);
     m_glBindBuffer_enc = set_glBindBuffer(s_glBindBuffer);
@@ -26,6 +30,33 @@ GL2Encoder::GL2Encoder(IOStream *stream) : gl2_encoder_context_t(stream)
     m_glGetVertexAttribfv_enc = set_glGetVertexAttribfv(s_glGetVertexAttribfv);
     m_glGetVertexAttribPointerv = set_glGetVertexAttribPointerv(s_glGetVertexAttribPointerv);
     set_glShaderSource(s_glShaderSource);
+
+    m_glEnable_enc = set_glEnable(s_glEnable);
+    m_glDisable_enc = set_glDisable(s_glDisable);
+    m_glIsEnabled_enc = set_glIsEnabled(s_glIsEnabled);
+    m_glActiveTexture_enc = set_glActiveTexture(s_glActiveTexture);
+    m_glBindTexture_enc = set_glBindTexture(s_glBindTexture);
+    m_glDeleteTextures_enc = set_glDeleteTextures(s_glDeleteTextures);
+    m_glBlendFunc_enc = set_glBlendFunc(s_glBlendFunc);
+    m_glBlendFuncSeparate_enc = set_glBlendFuncSeparate(s_glBlendFuncSeparate);
+    m_glDepthFunc_enc = set_glDepthFunc(s_glDepthFunc);
+    m_glDepthMask_enc = set_glDepthMask(s_glDepthMask);
+    m_glCullFace_enc = set_glCullFace(s_glCullFace);
+    m_glFrontFace_enc = set_glFrontFace(s_glFrontFace);
+    m_glUseProgram_enc = set_glUseProgram(s_glUseProgram);
+    m_glLinkProgram_enc = set_glLinkProgram(s_glLinkProgram);
+
+    m_glCreateProgram_enc = set_glCreateProgram(s_glCreateProgram);
+    m_glDeleteProgram_enc = set_glDeleteProgram(s_glDeleteProgram);
+    m_glGetProgramiv_enc = set_glGetProgramiv(s_glGetProgramiv);
+    m_glGetAttribLocation_enc = set_glGetAttribLocation(s_glGetAttribLocation);
+    m_glGetUniformLocation_enc = set_glGetUniformLocation(s_glGetUniformLocation);
+    m_glGetActiveAttrib_enc = set_glGetActiveAttrib(s_glGetActiveAttrib);
+    m_glGetActiveUniform_enc = set_glGetActiveUniform(s_glGetActiveUniform);
+    m_glCreateShader_enc = set_glCreateShader(s_glCreateShader);
+    m_glDeleteShader_enc = set_glDeleteShader(s_glDeleteShader);
+    m_glCompileShader_enc = set_glCompileShader(s_glCompileShader);
+    m_glGetShaderiv_enc = set_glGetShaderiv(s_glGetShaderiv);
 }
 
 GL2Encoder::~GL2Encoder()
@@ -40,6 +71,22 @@ void GL2Encoder::s_glFlush(void *self)
     ctx->m_stream->flush();
 }
 
+GLenum GL2Encoder::s_glGetError(void *self)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    if (ctx->m_replyStatus == NULL) {
+        return ctx->m_glGetError_enc(self);
+    }
+    // the errors that came with the replies since the last call; in strict
+    // mode the server is asked about the calls sent after the latest reply
+    GLenum error = ctx->m_replyStatus->take();
+    if (error == GL_NO_ERROR && ctx->m_strictErrors &&
+        ctx->m_replyStatus->unanswered(ctx->m_stream)) {
+        error = ctx->m_glGetError_enc(self);
+    }
+    return error;
+}
+
 GLubyte *GL2Encoder::s_glGetString(void *self, GLenum name)
 {
     GLubyte *retval =  (GLubyte *) "";
@@ -98,7 +145,8 @@ void GL2Encoder::s_glGetIntegerv(void *self, GLenum param, GLint *params)
         if (ctx->m_num_compressedTextureFormats > 0 && compressedTextureFormats != NULL) {
             memcpy(params, compressedTextureFormats, ctx->m_num_compressedTextureFormats * sizeof(GLint));
         }
-    } else if (!ctx->m_state->getClientStateParameter<GLint>(param, params)) {
+    } else if (!ctx->m_state->getClientStateParameter<GLint>(param, params) &&
+             !ctx->m_state->shadow()->getParameter<GLint>(param, params)) {
         ctx->m_glGetIntegerv_enc(self, param, params);
     }
 }
@@ -120,7 +168,8 @@ void GL2Encoder::s_glGetFloatv(void *self, GLenum param, GLfloat *ptr)
             }
         }
     }
-    else if (!ctx->m_state->getClientStateParameter<GLfloat>(param,ptr)) {
+    else if (!ctx->m_state->getClientStateParameter<GLfloat>(param,ptr) &&
+             !ctx->m_state->shadow()->getParameter<GLfloat>(param, ptr)) {
         ctx->m_glGetFloatv_enc(self, param, ptr);
     }
 }
@@ -133,7 +182,8 @@ void GL2Encoder::s_glGetBooleanv(void *self, GLenum param, GLboolean *ptr)
     if (param == GL_COMPRESSED_TEXTURE_FORMATS) {
         // ignore the command, although we should have generated a GLerror;
     }
-    else if (!ctx->m_state->getClientStateParameter<GLboolean>(param,ptr)) {
+    else if (!ctx->m_state->getClientStateParameter<GLboolean>(param,ptr) &&
+             !ctx->m_state->shadow()->getParameter<GLboolean>(param, ptr)) {
         ctx->m_glGetBooleanv_enc(self, param, ptr);
     }
 }
@@ -186,10 +236,294 @@ void GL2Encoder::s_glGetVertexAttribPointerv(void *self, GLuint index, GLenum pn
 }
 
 
-void GL2Encoder::sendVertexAttributes(GLint first, GLsizei count)
+void GL2Encoder::s_glEnable(void *self, GLenum cap)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->enable(cap, true)) {
+        ctx->m_glEnable_enc(self, cap);
+    }
+}
+
+void GL2Encoder::s_glDisable(void *self, GLenum cap)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->enable(cap, false)) {
+        ctx->m_glDisable_enc(self, cap);
+    }
+}
+
+GLboolean GL2Encoder::s_glIsEnabled(void *self, GLenum cap)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    GLboolean enabled;
+    if (ctx->m_state->shadow()->isEnabled(cap, &enabled)) {
+        return enabled;
+    }
+    return ctx->m_glIsEnabled_enc(self, cap);
+}
+
+void GL2Encoder::s_glActiveTexture(void *self, GLenum texture)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    GLStateShadow *shadow = ctx->m_state->shadow();
+    if (!shadow->maxTextureUnitsKnown()) {
+        GLint units = 0;
+        ctx->m_glGetIntegerv_enc(self, shadow->maxTextureUnitsParam(), &units);
+        shadow->setMaxTextureUnits(units);
+    }
+    if (shadow->activeTexture(texture)) {
+        ctx->m_glActiveTexture_enc(self, texture);
+    }
+}
+
+void GL2Encoder::s_glBindTexture(void *self, GLenum target, GLuint texture)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->bindTexture(target, texture)) {
+        ctx->m_glBindTexture_enc(self, target, texture);
+    }
+}
+
+void GL2Encoder::s_glDeleteTextures(void *self, GLsizei n, GLuint *textures)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (n > 0 && textures != NULL) {
+        ctx->m_state->shadow()->deleteTextures(n, textures);
+    }
+    ctx->m_glDeleteTextures_enc(self, n, textures);
+}
+
+void GL2Encoder::s_glBlendFunc(void *self, GLenum sfactor, GLenum dfactor)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->blendFunc(sfactor, dfactor)) {
+        ctx->m_glBlendFunc_enc(self, sfactor, dfactor);
+    }
+}
+
+void GL2Encoder::s_glBlendFuncSeparate(void *self, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->blendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha)) {
+        ctx->m_glBlendFuncSeparate_enc(self, srcRGB, dstRGB, srcAlpha, dstAlpha);
+    }
+}
+
+void GL2Encoder::s_glDepthFunc(void *self, GLenum func)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->depthFunc(func)) {
+        ctx->m_glDepthFunc_enc(self, func);
+    }
+}
+
+void GL2Encoder::s_glDepthMask(void *self, GLboolean flag)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->depthMask(flag)) {
+        ctx->m_glDepthMask_enc(self, flag);
+    }
+}
+
+void GL2Encoder::s_glCullFace(void *self, GLenum mode)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->cullFace(mode)) {
+        ctx->m_glCullFace_enc(self, mode);
+    }
+}
+
+void GL2Encoder::s_glFrontFace(void *self, GLenum mode)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->frontFace(mode)) {
+        ctx->m_glFrontFace_enc(self, mode);
+    }
+}
+
+void GL2Encoder::s_glUseProgram(void *self, GLuint program)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    if (ctx->m_state->shadow()->useProgram(program)) {
+        ctx->m_glUseProgram_enc(self, program);
+    }
+}
+
+void GL2Encoder::s_glLinkProgram(void *self, GLuint program)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    ctx->m_state->shadow()->programLinked();
+    ctx->m_state->programCache()->linkProgram(program);
+    ctx->m_glLinkProgram_enc(self, program);
+}
+
+bool GL2Encoder::loadProgramInfo(GLuint program)
+{
+    if (!m_programCacheEnabled) {
+        return false;
+    }
+    assert(m_state != NULL);
+    ProgramCache *cache = m_state->programCache();
+    if (!cache->needsProgramInfo(program)) {
+        return true;
+    }
+
+    // most programs fit in the first buffer, the others take a second call
+    GLsizei bufsize = 4096;
+    void *block = m_fixedBuffer.alloc(bufsize);
+    GLsizei size = this->glGetProgramInfoBlock(this, program, bufsize, block);
+    if (size > bufsize) {
+        bufsize = size;
+        block = m_fixedBuffer.alloc(bufsize);
+        size = this->glGetProgramInfoBlock(this, program, bufsize, block);
+    }
+    if (size > bufsize || !cache->setProgramInfo(program, block, size)) {
+        LOGE("GL2Encoder: could not load the info of program %u\n", program);
+        return false;
+    }
+    return true;
+}
+
+GLuint GL2Encoder::s_glCreateProgram(void *self)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    GLuint program = ctx->m_glCreateProgram_enc(self);
+    if (ctx->m_programCacheEnabled) {
+        ctx->m_state->programCache()->createProgram(program);
+    }
+    return program;
+}
+
+void GL2Encoder::s_glDeleteProgram(void *self, GLuint program)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    ctx->m_state->programCache()->deleteProgram(program);
+    ctx->m_glDeleteProgram_enc(self, program);
+}
+
+void GL2Encoder::s_glGetProgramiv(void *self, GLuint program, GLenum pname, GLint *params)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    if (!ctx->loadProgramInfo(program) ||
+        !ctx->m_state->programCache()->getProgramiv(program, pname, params)) {
+        ctx->m_glGetProgramiv_enc(self, program, pname, params);
+    }
+}
+
+int GL2Encoder::s_glGetAttribLocation(void *self, GLuint program, GLchar *name)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    if (!ctx->loadProgramInfo(program)) {
+        return ctx->m_glGetAttribLocation_enc(self, program, name);
+    }
+
+    ProgramCache *cache = ctx->m_state->programCache();
+    GLint location;
+    if (!cache->getAttribLocation(program, name, &location)) {
+        location = ctx->m_glGetAttribLocation_enc(self, program, name);
+        cache->setAttribLocation(program, name, location);
+    }
+    return location;
+}
+
+int GL2Encoder::s_glGetUniformLocation(void *self, GLuint program, GLchar *name)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    if (!ctx->loadProgramInfo(program)) {
+        return ctx->m_glGetUniformLocation_enc(self, program, name);
+    }
+
+    ProgramCache *cache = ctx->m_state->programCache();
+    GLint location;
+    if (!cache->getUniformLocation(program, name, &location)) {
+        location = ctx->m_glGetUniformLocation_enc(self, program, name);
+        cache->setUniformLocation(program, name, location);
+    }
+    return location;
+}
+
+void GL2Encoder::s_glGetActiveAttrib(void *self, GLuint program, GLuint index, GLsizei bufsize,
+                                     GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    if (!ctx->loadProgramInfo(program) ||
+        !ctx->m_state->programCache()->getActiveAttrib(program, index, bufsize, length, size, type, name)) {
+        ctx->m_glGetActiveAttrib_enc(self, program, index, bufsize, length, size, type, name);
+    }
+}
+
+void GL2Encoder::s_glGetActiveUniform(void *self, GLuint program, GLuint index, GLsizei bufsize,
+                                      GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    if (!ctx->loadProgramInfo(program) ||
+        !ctx->m_state->programCache()->getActiveUniform(program, index, bufsize, length, size, type, name)) {
+        ctx->m_glGetActiveUniform_enc(self, program, index, bufsize, length, size, type, name);
+    }
+}
+
+GLuint GL2Encoder::s_glCreateShader(void *self, GLenum type)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    GLuint shader = ctx->m_glCreateShader_enc(self, type);
+    if (ctx->m_programCacheEnabled) {
+        ctx->m_state->programCache()->createShader(shader, type);
+    }
+    return shader;
+}
+
+void GL2Encoder::s_glDeleteShader(void *self, GLuint shader)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    ctx->m_state->programCache()->deleteShader(shader);
+    ctx->m_glDeleteShader_enc(self, shader);
+}
+
+void GL2Encoder::s_glCompileShader(void *self, GLuint shader)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    ctx->m_state->programCache()->compileShader(shader);
+    ctx->m_glCompileShader_enc(self, shader);
+}
+
+void GL2Encoder::s_glGetShaderiv(void *self, GLuint shader, GLenum pname, GLint *params)
+{
+    GL2Encoder *ctx = (GL2Encoder *)self;
+    assert(ctx->m_state != NULL);
+    ProgramCache *cache = ctx->m_state->programCache();
+    if (!cache->getShaderiv(shader, pname, params)) {
+        ctx->m_glGetShaderiv_enc(self, shader, pname, params);
+        // the reply of a failed query is garbage, only the status tells
+        if (ctx->m_replyStatus != NULL && ctx->m_replyStatus->last() == GL_NO_ERROR) {
+            cache->setShaderiv(shader, pname, *params);
+        }
+    }
+}
+
+void GL2Encoder::sendVertexAttributes(GLint first, GLsizei count, const int *vertices)
 {
     assert(m_state);
 
+    bool interleaved = m_interleavedArraysEnabled && vertices == NULL &&
+                       m_state->findInterleavedArrays(count) > 0;
+
     for (int i = 0; i < m_state->nLocations(); i++) {
         bool enableDirty;
         const GLClientState::VertexAttribState *state = m_state->getStateAndEnableDirty(i, &enableDirty);
@@ -210,7 +544,15 @@ void GL2Encoder::sendVertexAttributes(GLint first, GLsizei count)
             int stride = state->stride == 0 ? state->elementSize : state->stride;
             int firstIndex = stride * first;
 
-            if (state->bufferObject == 0) {
+            if (interleaved && m_state->interleavedGroup(i) >= 0) {
+                // sent below, along with the rest of its block
+            } else if (state->bufferObject == 0 && vertices != NULL) {
+                unsigned char *data = (unsigned char *)m_gatherBuffer.alloc(datalen);
+                glUtilsGatherVertices(data, (unsigned char *)state->data, state->elementSize,
+                                      state->stride, vertices, count);
+                this->glVertexAttribPointerData(this, i, state->size, state->type, state->normalized, 0,
+                                                data, datalen);
+            } else if (state->bufferObject == 0) {
                 this->glVertexAttribPointerData(this, i, state->size, state->type, state->normalized, state->stride,
                                                 (unsigned char *)state->data + firstIndex, datalen);
             } else {
@@ -222,6 +564,19 @@ void GL2Encoder::sendVertexAttributes(GLint first, GLsizei count)
             this->m_glDisableVertexAttribArray_enc(this, i);
         }
     }
+
+    for (int i = 0; interleaved && i < m_state->nLocations(); i++) {
+        if (m_state->interleavedGroup(i) == i) {
+            const GLuint *attribs;
+            unsigned char *data;
+            GLuint datalen;
+            GLsizei stride;
+            int n = m_state->getInterleavedBlock(i, first, count, &attribs, &data, &datalen, &stride);
+            this->glInterleavedPointerData(this, n, (GLuint *)attribs,
+                                           n * CODEC_INTERLEAVED_FIELDS * sizeof(GLuint),
+                                           stride, data, datalen);
+        }
+    }
 }
 
 void GL2Encoder::s_glDrawArrays(void *self, GLenum mode, GLint first, GLsizei count)
@@ -268,12 +623,29 @@ void GL2Encoder::s_glDrawElements(void *self, GLenum mode, GLsizei count, GLenum
     } else {
         void *adjustedIndices = indices;
         int minIndex = 0, maxIndex = 0;
+        int *vertices = NULL;
+        int nVertices = 0;
 
+        // with client arrays only, the vertices may be compacted so that
+        // only those used are sent, see GLUtils::compactionPays().
         switch(type) {
         case GL_BYTE:
         case GL_UNSIGNED_BYTE:
             GLUtils::minmax<unsigned char>((unsigned char *)indices, count, &minIndex, &maxIndex);
-            if (minIndex != 0) {
+            if (!has_indirect_arrays && GLUtils::tryCompaction(count, minIndex, maxIndex)) {
+                int *map = (int *)ctx->m_compactBuffer.alloc((maxIndex - minIndex + 1 + count) * sizeof(int));
+                vertices = map + maxIndex - minIndex + 1;
+                adjustedIndices = ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
+                nVertices = GLUtils::compactIndices<unsigned char>((unsigned char *)indices,
+                                                                   (unsigned char *)adjustedIndices,
+                                                                   count, minIndex, maxIndex,
+                                                                   map, vertices);
+                if (!GLUtils::compactionPays(nVertices, minIndex, maxIndex)) {
+                    vertices = NULL;
+                    adjustedIndices = indices;
+                }
+            }
+            if (vertices == NULL && minIndex != 0) {
                 adjustedIndices =  ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
                 GLUtils::shiftIndices<unsigned char>((unsigned char *)indices,
                                                  (unsigned char *)adjustedIndices,
@@ -283,7 +655,20 @@ void GL2Encoder::s_glDrawElements(void *self, GLenum mode, GLsizei count, GLenum
         case GL_SHORT:
         case GL_UNSIGNED_SHORT:
             GLUtils::minmax<unsigned short>((unsigned short *)indices, count, &minIndex, &maxIndex);
-            if (minIndex != 0) {
+            if (!has_indirect_arrays && GLUtils::tryCompaction(count, minIndex, maxIndex)) {
+                int *map = (int *)ctx->m_compactBuffer.alloc((maxIndex - minIndex + 1 + count) * sizeof(int));
+                vertices = map + maxIndex - minIndex + 1;
+                adjustedIndices = ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
+                nVertices = GLUtils::compactIndices<unsigned short>((unsigned short *)indices,
+                                                                    (unsigned short *)adjustedIndices,
+                                                                    count, minIndex, maxIndex,
+                                                                    map, vertices);
+                if (!GLUtils::compactionPays(nVertices, minIndex, maxIndex)) {
+                    vertices = NULL;
+                    adjustedIndices = indices;
+                }
+            }
+            if (vertices == NULL && minIndex != 0) {
                 adjustedIndices = ctx->m_fixedBuffer.alloc(glSizeof(type) * count);
                 GLUtils::shiftIndices<unsigned short>((unsigned short *)indices,
                                                   (unsigned short *)adjustedIndices,
@@ -293,19 +678,13 @@ void GL2Encoder::s_glDrawElements(void *self, GLenum mode, GLsizei count, GLenum
         default:
             LOGE("unsupported index buffer type %d\n", type);
         }
-        if (has_indirect_arrays || 1) {
-            ctx->sendVertexAttributes(minIndex, maxIndex - minIndex + 1);
-            ctx->glDrawElementsData(ctx, mode, count, type, adjustedIndices,
-                                    count * glSizeof(type));
-            // XXX - OPTIMIZATION (see the other else branch) should be implemented
-            if(!has_indirect_arrays) {
-                LOGD("unoptimized drawelements !!!\n");
-            }
+        if (vertices != NULL) {
+            ctx->sendVertexAttributes(0, nVertices, vertices);
         } else {
-            // we are all direct arrays and immidate mode index array -
-            // rebuild the arrays and the index array;
-            LOGE("glDrawElements: direct index & direct buffer data - will be implemented in later versions;\n");
+            ctx->sendVertexAttributes(minIndex, maxIndex - minIndex + 1);
         }
+        ctx->glDrawElementsData(ctx, mode, count, type, adjustedIndices,
+                                count * glSizeof(type));
     }
 }
 
@@ -332,6 +711,9 @@ void GL2Encoder::s_glShaderSource(void *self, GLuint shader, GLsizei count, GLst
     glUtilsPackStrings(str, string, length, count);
 
     GL2Encoder *ctx = (GL2Encoder *)self;
+    if (ctx->m_state != NULL) {
+        ctx->m_state->programCache()->shaderSource(shader);
+    }
     ctx->glShaderString(ctx, shader, str, len + 1);
     delete str;
 }
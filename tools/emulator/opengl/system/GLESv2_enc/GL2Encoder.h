@@ -28,25 +28,54 @@ public:
     virtual ~GL2Encoder();
     void setClientState(GLClientState *state) {
         m_state = state;
+        if (m_replyStatus != NULL) {
+            m_replyStatus->setPending(m_state != NULL ? m_state->pendingError() : NULL);
+        }
+        if (m_state != NULL) {
+            m_state->shadow()->setApi(GLStateShadow::GLES2);
+        }
     }
     const GLClientState *state() { return m_state; }
+    // send interleaved client arrays once, needs RENDERER_CAP_INTERLEAVED_ARRAYS
+    void setInterleavedArraysEnabled(bool enabled) { m_interleavedArraysEnabled = enabled; }
+    // answer program and shader queries from m_state->programCache(),
+    // needs RENDERER_CAP_PROGRAM_INFO
+    void setProgramCacheEnabled(bool enabled) { m_programCacheEnabled = enabled; }
+    // with m_replyStatus set, glGetError answers with the errors that came
+    // with the replies; strict, it also asks the server when calls were
+    // sent after the latest reply
+    void setStrictErrors(bool strict) { m_strictErrors = strict; }
     void flush() {
         gl2_encoder_context_t::m_stream->flush();
     }
 private:
     GLClientState *m_state;
+    bool m_interleavedArraysEnabled;
+    bool m_programCacheEnabled;
+    bool m_strictErrors;
 
     GLint *m_compressedTextureFormats;
     GLint m_num_compressedTextureFormats;
     GLint *getCompressedTextureFormats();
 
     FixedBuffer m_fixedBuffer;
+    FixedBuffer m_compactBuffer;    // index map and vertex list of compacted draws
+    FixedBuffer m_gatherBuffer;     // vertices of compacted draws
 
-    void sendVertexAttributes(GLint first, GLsizei count);
+    // sends the arrays for vertices first to first + count - 1, or for
+    // the count vertices listed in 'vertices' if not NULL.
+    void sendVertexAttributes(GLint first, GLsizei count, const int *vertices = NULL);
+
+    // true if the program cache can answer queries about 'program',
+    // after loading its info block from the server if needed.
+    bool loadProgramInfo(GLuint program);
 
     glFlush_client_proc_t m_glFlush_enc;
     static void s_glFlush(void * self);
 
+    glGetError_client_proc_t m_glGetError_enc;
+    static GLenum s_glGetError(void *self);
+
     glPixelStorei_client_proc_t m_glPixelStorei_enc;
     static void s_glPixelStorei(void *self, GLenum param, GLint value);
 
@@ -92,5 +121,84 @@ private:
     static void s_glGetVertexAttribPointerv(void *self, GLuint index, GLenum pname, GLvoid **pointer);
 
     static void s_glShaderSource(void *self, GLuint shader, GLsizei count, GLstr *string, GLint *length);
+
+    // server state shadowed in m_state->shadow()
+    glEnable_client_proc_t m_glEnable_enc;
+    static void s_glEnable(void *self, GLenum cap);
+
+    glDisable_client_proc_t m_glDisable_enc;
+    static void s_glDisable(void *self, GLenum cap);
+
+    glIsEnabled_client_proc_t m_glIsEnabled_enc;
+    static GLboolean s_glIsEnabled(void *self, GLenum cap);
+
+    glActiveTexture_client_proc_t m_glActiveTexture_enc;
+    static void s_glActiveTexture(void *self, GLenum texture);
+
+    glBindTexture_client_proc_t m_glBindTexture_enc;
+    static void s_glBindTexture(void *self, GLenum target, GLuint texture);
+
+    glDeleteTextures_client_proc_t m_glDeleteTextures_enc;
+    static void s_glDeleteTextures(void *self, GLsizei n, GLuint *textures);
+
+    glBlendFunc_client_proc_t m_glBlendFunc_enc;
+    static void s_glBlendFunc(void *self, GLenum sfactor, GLenum dfactor);
+
+    glBlendFuncSeparate_client_proc_t m_glBlendFuncSeparate_enc;
+    static void s_glBlendFuncSeparate(void *self, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+
+    glDepthFunc_client_proc_t m_glDepthFunc_enc;
+    static void s_glDepthFunc(void *self, GLenum func);
+
+    glDepthMask_client_proc_t m_glDepthMask_enc;
+    static void s_glDepthMask(void *self, GLboolean flag);
+
+    glCullFace_client_proc_t m_glCullFace_enc;
+    static void s_glCullFace(void *self, GLenum mode);
+
+    glFrontFace_client_proc_t m_glFrontFace_enc;
+    static void s_glFrontFace(void *self, GLenum mode);
+
+    glUseProgram_client_proc_t m_glUseProgram_enc;
+    static void s_glUseProgram(void *self, GLuint program);
+
+    glLinkProgram_client_proc_t m_glLinkProgram_enc;
+    static void s_glLinkProgram(void *self, GLuint program);
+
+    // program and shader queries answered from m_state->programCache()
+    glCreateProgram_client_proc_t m_glCreateProgram_enc;
+    static GLuint s_glCreateProgram(void *self);
+
+    glDeleteProgram_client_proc_t m_glDeleteProgram_enc;
+    static void s_glDeleteProgram(void *self, GLuint program);
+
+    glGetProgramiv_client_proc_t m_glGetProgramiv_enc;
+    static void s_glGetProgramiv(void *self, GLuint program, GLenum pname, GLint *params);
+
+    glGetAttribLocation_client_proc_t m_glGetAttribLocation_enc;
+    static int s_glGetAttribLocation(void *self, GLuint program, GLchar *name);
+
+    glGetUniformLocation_client_proc_t m_glGetUniformLocation_enc;
+    static int s_glGetUniformLocation(void *self, GLuint program, GLchar *name);
+
+    glGetActiveAttrib_client_proc_t m_glGetActiveAttrib_enc;
+    static void s_glGetActiveAttrib(void *self, GLuint program, GLuint index, GLsizei bufsize,
+                                    GLsizei *length, GLint *size, GLenum *type, GLchar *name);
+
+    glGetActiveUniform_client_proc_t m_glGetActiveUniform_enc;
+    static void s_glGetActiveUniform(void *self, GLuint program, GLuint index, GLsizei bufsize,
+                                     GLsizei *length, GLint *size, GLenum *type, GLchar *name);
+
+    glCreateShader_client_proc_t m_glCreateShader_enc;
+    static GLuint s_glCreateShader(void *self, GLenum type);
+
+    glDeleteShader_client_proc_t m_glDeleteShader_enc;
+    static void s_glDeleteShader(void *self, GLuint shader);
+
+    glCompileShader_client_proc_t m_glCompileShader_enc;
+    static void s_glCompileShader(void *self, GLuint shader);
+
+    glGetShaderiv_client_proc_t m_glGetShaderiv_enc;
+    static void s_glGetShaderiv(void *self, GLuint shader, GLenum pname, GLint *params);
 };
 #endif
@@ -8,7 +8,8 @@ include $(CLEAR_VARS)
 # is generated
 LOCAL_ADDITIONAL_DEPENDENCIES := \
 	$(TARGET_OUT_SHARED_LIBRARIES)/lib_renderControl_enc$(TARGET_SHLIB_SUFFIX) \
-	$(TARGET_OUT_SHARED_LIBRARIES)/libGLESv1_enc$(TARGET_SHLIB_SUFFIX)
+	$(TARGET_OUT_SHARED_LIBRARIES)/libGLESv1_enc$(TARGET_SHLIB_SUFFIX) \
+	$(TARGET_OUT_SHARED_LIBRARIES)/libGLESv2_enc$(TARGET_SHLIB_SUFFIX)
 
 LOCAL_SRC_FILES := \
         HostConnection.cpp \
@@ -19,9 +20,11 @@ LOCAL_C_INCLUDES += \
         $(emulatorOpengl)/host/include/libOpenglRender \
         $(emulatorOpengl)/shared/OpenglCodecCommon \
         $(emulatorOpengl)/system/GLESv1_enc \
+        $(emulatorOpengl)/system/GLESv2_enc \
         $(emulatorOpengl)/system/renderControl_enc \
 		$(call intermediates-dir-for, SHARED_LIBRARIES, lib_renderControl_enc) \
-		$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv1_enc)
+		$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv1_enc) \
+		$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv2_enc)
 
 LOCAL_MODULE_TAGS := debug
 LOCAL_MODULE := libOpenglSystemCommon
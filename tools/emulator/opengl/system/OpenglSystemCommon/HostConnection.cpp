@@ -25,10 +25,39 @@
 /* Set to 1 to use a QEMU pipe, or 0 for a TCP connection */
 #define  USE_QEMU_PIPE  1
 
+/* Set to 1 to compress large payloads if the host renderer supports it */
+#define  USE_PAYLOAD_COMPRESSION  0
+
+/* Set to 1 to create host objects without a round trip if the host renderer supports it */
+#define  USE_ASYNC_OBJECT_CREATION  1
+
+/* Set to 1 to send compact packet headers if the host renderer supports it */
+#define  USE_COMPACT_HEADER  1
+
+/* Set to 1 to keep client vertex arrays in buffers on the host, and only send what changed */
+#define  USE_VERTEX_ARRAY_CACHE  0
+
+/* Set to 1 to have the GL errors sent along with the replies if the host renderer supports it */
+#define  USE_DEFERRED_GL_ERRORS  1
+
+/* Set to 1 to have glGetError ask the host when no error came with the replies and
+ * calls were sent after the latest one; errors of calls without a reply are otherwise
+ * reported with the next reply */
+#define  USE_STRICT_GL_ERRORS  0
+
+/* number of handles reserved at once for asynchronous object creation */
+#define  RESERVED_HANDLES_COUNT  64
+
 HostConnection::HostConnection() :
     m_stream(NULL),
     m_glEnc(NULL),
-    m_rcEnc(NULL)
+    m_gl2Enc(NULL),
+    m_rcEnc(NULL),
+    m_capsQueried(false),
+    m_rendererCaps(0),
+    m_packetFormat(PACKET_FORMAT_CLASSIC),
+    m_nextHandle(0),
+    m_handlesLeft(0)
 {
 }
 
@@ -36,6 +65,7 @@ HostConnection::~HostConnection()
 {
     delete m_stream;
     delete m_glEnc;
+    delete m_gl2Enc;
     delete m_rcEnc;
 }
 
@@ -98,18 +128,131 @@ GLEncoder *HostConnection::glEncoder()
     if (!m_glEnc) {
         m_glEnc = new GLEncoder(m_stream);
         m_glEnc->setContextAccessor(s_getGLContext);
+        m_glEnc->m_compressor.setEnabled(compressPayloads());
+        m_glEnc->setVertexArrayCacheEnabled(USE_VERTEX_ARRAY_CACHE);
+        m_glEnc->setInterleavedArraysEnabled(
+                (rendererCaps() & RENDERER_CAP_INTERLEAVED_ARRAYS) != 0);
+        // the format is negotiated when the renderControl encoder is created
+        rcEncoder();
+        m_glEnc->m_packetFormat = m_packetFormat;
+        m_glEnc->m_replyStatus = m_rcEnc->m_replyStatus;
+        m_glEnc->setStrictErrors(USE_STRICT_GL_ERRORS);
     }
     return m_glEnc;
 }
 
+GL2Encoder *HostConnection::gl2Encoder()
+{
+    if (!m_gl2Enc) {
+        m_gl2Enc = new GL2Encoder(m_stream);
+        m_gl2Enc->setContextAccessor(s_getGL2Context);
+        m_gl2Enc->m_compressor.setEnabled(compressPayloads());
+        m_gl2Enc->setInterleavedArraysEnabled(
+                (rendererCaps() & RENDERER_CAP_INTERLEAVED_ARRAYS) != 0);
+        m_gl2Enc->setProgramCacheEnabled(
+                (rendererCaps() & RENDERER_CAP_PROGRAM_INFO) != 0);
+        // the format is negotiated when the renderControl encoder is created
+        rcEncoder();
+        m_gl2Enc->m_packetFormat = m_packetFormat;
+        m_gl2Enc->m_replyStatus = m_rcEnc->m_replyStatus;
+        m_gl2Enc->setStrictErrors(USE_STRICT_GL_ERRORS);
+    }
+    return m_gl2Enc;
+}
+
 renderControl_encoder_context_t *HostConnection::rcEncoder()
 {
     if (!m_rcEnc) {
         m_rcEnc = new renderControl_encoder_context_t(m_stream);
+        m_rcEnc->m_compressor.setEnabled(compressPayloads());
+        if (USE_COMPACT_HEADER &&
+            (rendererCaps() & RENDERER_CAP_COMPACT_HEADER) &&
+            m_rcEnc->rcSetPacketFormat(m_rcEnc, PACKET_FORMAT_COMPACT) == EGL_TRUE) {
+            m_packetFormat = PACKET_FORMAT_COMPACT;
+        }
+        m_rcEnc->m_packetFormat = m_packetFormat;
+        if (USE_DEFERRED_GL_ERRORS &&
+            (rendererCaps() & RENDERER_CAP_REPLY_STATUS) &&
+            m_rcEnc->rcSetReplyStatus(m_rcEnc, 1) == EGL_TRUE) {
+            m_rcEnc->m_replyStatus = &m_replyStatus;
+        }
     }
     return m_rcEnc;
 }
 
+uint32_t HostConnection::rendererCaps()
+{
+    if (!m_capsQueried) {
+        renderControl_encoder_context_t *rcEnc = rcEncoder();
+        if (rcEnc->rcGetRendererVersion(rcEnc) >= RENDERER_VERSION_WITH_CAPS) {
+            m_rendererCaps = rcEnc->rcGetRendererCaps(rcEnc);
+        }
+        m_capsQueried = true;
+    }
+    return m_rendererCaps;
+}
+
+bool HostConnection::compressPayloads()
+{
+    return USE_PAYLOAD_COMPRESSION &&
+           (rendererCaps() & RENDERER_CAP_COMPRESSED_PAYLOAD) != 0;
+}
+
+uint32_t HostConnection::reserveHandle()
+{
+    if (!USE_ASYNC_OBJECT_CREATION ||
+        !(rendererCaps() & RENDERER_CAP_ASYNC_CREATE)) {
+        return 0;
+    }
+
+    if (m_handlesLeft == 0) {
+        // a round trip anyway, report the creations of the previous
+        // range that failed
+        if (m_nextHandle != 0) {
+            uint32_t failed = asyncError();
+            if (failed != 0) {
+                LOGE("HostConnection: asynchronous creation of host object 0x%x failed\n", failed);
+            }
+        }
+        renderControl_encoder_context_t *rcEnc = rcEncoder();
+        m_nextHandle = rcEnc->rcReserveHandles(rcEnc, RESERVED_HANDLES_COUNT);
+        if (m_nextHandle == 0) {
+            return 0;
+        }
+        m_handlesLeft = RESERVED_HANDLES_COUNT;
+    }
+
+    m_handlesLeft--;
+    return m_nextHandle++;
+}
+
+//
+// The asynchronous creation is flushed right away: the handle may be
+// passed to another process, and used on another connection, as soon as
+// it is returned. The host makes that connection wait for the creation.
+//
+uint32_t HostConnection::createColorBuffer(uint32_t width, uint32_t height,
+                                           GLenum internalFormat)
+{
+    renderControl_encoder_context_t *rcEnc = rcEncoder();
+    uint32_t handle = reserveHandle();
+    if (handle == 0) {
+        return rcEnc->rcCreateColorBuffer(rcEnc, width, height, internalFormat);
+    }
+    rcEnc->rcCreateColorBufferAsync(rcEnc, handle, width, height, internalFormat);
+    flush();
+    return handle;
+}
+
+uint32_t HostConnection::asyncError()
+{
+    if (!(rendererCaps() & RENDERER_CAP_ASYNC_CREATE)) {
+        return 0;
+    }
+    renderControl_encoder_context_t *rcEnc = rcEncoder();
+    return rcEnc->rcGetAsyncError(rcEnc);
+}
+
 gl_client_context_t *HostConnection::s_getGLContext()
 {
     EGLThreadInfo *ti = getEGLThreadInfo();
@@ -118,3 +261,12 @@ gl_client_context_t *HostConnection::s_getGLContext()
     }
     return NULL;
 }
+
+gl2_client_context_t *HostConnection::s_getGL2Context()
+{
+    EGLThreadInfo *ti = getEGLThreadInfo();
+    if (ti->hostConn) {
+        return ti->hostConn->m_gl2Enc;
+    }
+    return NULL;
+}
@@ -18,7 +18,9 @@
 
 #include "IOStream.h"
 #include "GLEncoder.h"
+#include "GL2Encoder.h"
 #include "renderControl_enc.h"
+#include "ReplyStatus.h"
 
 class HostConnection
 {
@@ -27,7 +29,17 @@ public:
     ~HostConnection();
 
     GLEncoder *glEncoder();
+    GL2Encoder *gl2Encoder();
     renderControl_encoder_context_t *rcEncoder();
+    uint32_t rendererCaps();
+
+    // creates a host color buffer. When the renderer supports it the
+    // buffer is created asynchronously with a handle reserved up front,
+    // and a failure is only reported by asyncError() and by the calls
+    // using the handle; failures are logged each time handles are
+    // reserved. The handle can be used on other connections right away.
+    uint32_t createColorBuffer(uint32_t width, uint32_t height, GLenum internalFormat);
+    uint32_t asyncError();
 
     void flush() {
         if (m_stream) {
@@ -38,11 +50,21 @@ public:
 private:
     HostConnection();
     static gl_client_context_t *s_getGLContext();
+    static gl2_client_context_t *s_getGL2Context();
+    bool compressPayloads();
+    uint32_t reserveHandle();
 
 private:
     IOStream *m_stream;
     GLEncoder *m_glEnc;
+    GL2Encoder *m_gl2Enc;
     renderControl_encoder_context_t *m_rcEnc;
+    bool m_capsQueried;
+    uint32_t m_rendererCaps;
+    int m_packetFormat;
+    uint32_t m_nextHandle;
+    uint32_t m_handlesLeft;
+    ReplyStatus m_replyStatus;  // GL errors sent with the replies
 };
 
 #endif
@@ -20,6 +20,9 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/uio.h>
+
+#define MAX_IOVECS 64
 
 QemuPipeStream::QemuPipeStream(size_t bufSize) :
     IOStream(bufSize),
@@ -82,6 +85,11 @@ int QemuPipeStream::commitBuffer(size_t size)
     return writeFully(m_buf, size);
 }
 
+int QemuPipeStream::commitBufferv(const Segment *segments, int count)
+{
+    return writeFullyv(segments, count);
+}
+
 int QemuPipeStream::writeFully(const void *buf, size_t len)
 {
     if (!valid()) return -1;
@@ -110,6 +118,45 @@ int QemuPipeStream::writeFully(const void *buf, size_t len)
     return retval;
 }
 
+int QemuPipeStream::writeFullyv(const Segment *segments, int count)
+{
+    if (!valid()) return -1;
+
+    int first = 0;
+    size_t skip = 0;   // bytes of segments[first] already written
+
+    while (first < count) {
+        struct iovec iov[MAX_IOVECS];
+        int n = 0;
+        for (int i = first; i < count && n < MAX_IOVECS; i++, n++) {
+            size_t off = (i == first ? skip : 0);
+            iov[n].iov_base = (char *)segments[i].base + off;
+            iov[n].iov_len = segments[i].len - off;
+        }
+
+        ssize_t stat = ::writev(m_sock, iov, n);
+        if (stat == 0) { /* EOF */
+            ERR("QemuPipeStream::writeFullyv failed: premature EOF\n");
+            return -1;
+        }
+        if (stat < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ERR("QemuPipeStream::writeFullyv failed: %s\n", strerror(errno));
+            return stat;
+        }
+
+        size_t done = skip + stat;
+        while (first < count && done >= segments[first].len) {
+            done -= segments[first].len;
+            first++;
+        }
+        skip = done;
+    }
+    return 0;
+}
+
 const unsigned char *QemuPipeStream::readFully(void *buf, size_t len)
 {
     if (!valid()) return NULL;
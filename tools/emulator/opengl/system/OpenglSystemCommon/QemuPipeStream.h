@@ -33,6 +33,7 @@ public:
 
     virtual void *allocBuffer(size_t minSize);
     virtual int commitBuffer(size_t size);
+    virtual int commitBufferv(const Segment *segments, int count);
     virtual const unsigned char *readFully( void *buf, size_t len);
     virtual const unsigned char *read( void *buf, size_t *inout_len);
 
@@ -41,6 +42,7 @@ public:
 
 private:
     int writeFully(const void *buf, size_t len);
+    int writeFullyv(const Segment *segments, int count);
 
 private:
     int m_sock;
@@ -10,7 +10,8 @@ include $(CLEAR_VARS)
 # is generated
 LOCAL_ADDITIONAL_DEPENDENCIES := \
 	$(TARGET_OUT_SHARED_LIBRARIES)/lib_renderControl_enc$(TARGET_SHLIB_SUFFIX) \
-	$(TARGET_OUT_SHARED_LIBRARIES)/libGLESv1_enc$(TARGET_SHLIB_SUFFIX)
+	$(TARGET_OUT_SHARED_LIBRARIES)/libGLESv1_enc$(TARGET_SHLIB_SUFFIX) \
+	$(TARGET_OUT_SHARED_LIBRARIES)/libGLESv2_enc$(TARGET_SHLIB_SUFFIX)
 
 LOCAL_SRC_FILES := \
         gralloc.cpp
@@ -20,9 +21,11 @@ LOCAL_C_INCLUDES += \
         $(emulatorOpengl)/shared/OpenglCodecCommon \
         $(emulatorOpengl)/system/OpenglSystemCommon \
         $(emulatorOpengl)/system/GLESv1_enc \
+        $(emulatorOpengl)/system/GLESv2_enc \
         $(emulatorOpengl)/system/renderControl_enc \
 		$(call intermediates-dir-for, SHARED_LIBRARIES, lib_renderControl_enc) \
-		$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv1_enc)
+		$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv1_enc) \
+		$(call intermediates-dir-for, SHARED_LIBRARIES, libGLESv2_enc)
 
 LOCAL_MODULE_TAGS := debug
 LOCAL_PRELINK_MODULE := false
@@ -38,6 +41,7 @@ LOCAL_STATIC_LIBRARIES := \
 LOCAL_SHARED_LIBRARIES := \
     libcutils \
     libGLESv1_enc \
+    libGLESv2_enc \
     lib_renderControl_enc
 
 include $(BUILD_SHARED_LIBRARY)
@@ -270,7 +270,7 @@ static int gralloc_alloc(alloc_device_t* dev,
     if (usage & GRALLOC_USAGE_HW_MASK) {
         DEFINE_HOST_CONNECTION;
         if (hostCon && rcEnc) {
-            cb->hostHandle = rcEnc->rcCreateColorBuffer(rcEnc, w, h, glFormat);
+            cb->hostHandle = hostCon->createColorBuffer(w, h, glFormat);
             LOGD("Created host ColorBuffer 0x%x\n", cb->hostHandle);
         }
 
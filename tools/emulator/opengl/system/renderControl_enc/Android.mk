@@ -33,6 +33,10 @@ $(RC_GEN) : $(EMUGEN) \
         $(LOCAL_PATH)/renderControl.types
 	$(transform-generated-source)
 
+ifneq (,$(BUILD_EMULATOR_OPENGL_TRACE))
+LOCAL_CFLAGS += -DCODEC_TRACE
+endif
+
 LOCAL_GENERATED_SOURCES += $(RC_GEN)
 include $(BUILD_SHARED_LIBRARY)
 
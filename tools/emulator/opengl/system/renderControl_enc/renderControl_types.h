@@ -10,3 +10,18 @@
 #define FB_FPS      5
 #define FB_MIN_SWAP_INTERVAL 6
 #define FB_MAX_SWAP_INTERVAL 7
+
+// first renderer version that implements rcGetRendererCaps
+#define RENDERER_VERSION_WITH_CAPS 2
+
+// bits returned by rcGetRendererCaps
+#define RENDERER_CAP_COMPRESSED_PAYLOAD  0x00000001
+#define RENDERER_CAP_OPCODE_STATS        0x00000002
+#define RENDERER_CAP_ASYNC_CREATE        0x00000004
+#define RENDERER_CAP_COMPACT_HEADER      0x00000008
+#define RENDERER_CAP_INTERLEAVED_ARRAYS  0x00000010
+#define RENDERER_CAP_PROGRAM_INFO        0x00000020
+#define RENDERER_CAP_REPLY_STATUS        0x00000040
+
+// maximum number of handles a single rcReserveHandles call can reserve
+#define RC_MAX_RESERVED_HANDLES 1024
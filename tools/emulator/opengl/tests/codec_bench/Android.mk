@@ -0,0 +1,157 @@
+LOCAL_PATH := $(call my-dir)
+
+emulatorOpengl := $(LOCAL_PATH)/../..
+EMUGEN := $(HOST_OUT_EXECUTABLES)/emugen
+
+# Encode/decode throughput of each protocol, generated by emugen -B.
+# Run <api>_bench [-c] [-n calls]; it needs no GPU.
+
+### gl_bench ###########################################
+include $(CLEAR_VARS)
+
+LOCAL_IS_HOST_MODULE := true
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE := gl_bench
+LOCAL_SRC_FILES := \
+        BenchStream.cpp \
+        BenchEncoderUtils.cpp
+
+intermediates := $(local-intermediates-dir)
+
+LOCAL_C_INCLUDES += \
+    $(emulatorOpengl)/shared/OpenglCodecCommon \
+    $(emulatorOpengl)/host/include/libOpenglRender \
+    $(emulatorOpengl)/system/GLESv1_enc \
+    $(intermediates)
+
+LOCAL_STATIC_LIBRARIES := \
+        libOpenglCodecCommon \
+        libcutils \
+        liblog
+
+GEN := \
+	$(intermediates)/gl_bench.cpp \
+	$(intermediates)/gl_enc.cpp \
+	$(intermediates)/gl_client_context.cpp \
+	$(intermediates)/gl_dec.cpp \
+	$(intermediates)/gl_server_context.cpp
+
+$(GEN) : PRIVATE_PATH := $(LOCAL_PATH)
+$(GEN) : PRIVATE_CUSTOM_TOOL := \
+        $(EMUGEN) -E $(intermediates) -D $(intermediates) -B $(intermediates) \
+        -i $(emulatorOpengl)/system/GLESv1_enc gl
+$(GEN) : $(EMUGEN) \
+        $(emulatorOpengl)/system/GLESv1_enc/gl.attrib \
+        $(emulatorOpengl)/system/GLESv1_enc/gl.in \
+        $(emulatorOpengl)/system/GLESv1_enc/gl.types
+	$(transform-generated-source)
+
+LOCAL_GENERATED_SOURCES += $(GEN)
+include $(BUILD_HOST_EXECUTABLE)
+
+### gl2_bench ###########################################
+include $(CLEAR_VARS)
+
+LOCAL_IS_HOST_MODULE := true
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE := gl2_bench
+LOCAL_SRC_FILES := \
+        BenchStream.cpp \
+        BenchEncoderUtils.cpp
+
+intermediates := $(local-intermediates-dir)
+
+LOCAL_C_INCLUDES += \
+    $(emulatorOpengl)/shared/OpenglCodecCommon \
+    $(emulatorOpengl)/host/include/libOpenglRender \
+    $(emulatorOpengl)/system/GLESv2_enc \
+    $(intermediates)
+
+LOCAL_STATIC_LIBRARIES := \
+        libOpenglCodecCommon \
+        libcutils \
+        liblog
+
+GEN := \
+	$(intermediates)/gl2_bench.cpp \
+	$(intermediates)/gl2_enc.cpp \
+	$(intermediates)/gl2_client_context.cpp \
+	$(intermediates)/gl2_dec.cpp \
+	$(intermediates)/gl2_server_context.cpp
+
+$(GEN) : PRIVATE_PATH := $(LOCAL_PATH)
+$(GEN) : PRIVATE_CUSTOM_TOOL := \
+        $(EMUGEN) -E $(intermediates) -D $(intermediates) -B $(intermediates) \
+        -i $(emulatorOpengl)/system/GLESv2_enc gl2
+$(GEN) : $(EMUGEN) \
+        $(emulatorOpengl)/system/GLESv2_enc/gl2.attrib \
+        $(emulatorOpengl)/system/GLESv2_enc/gl2.in \
+        $(emulatorOpengl)/system/GLESv2_enc/gl2.types
+	$(transform-generated-source)
+
+LOCAL_GENERATED_SOURCES += $(GEN)
+include $(BUILD_HOST_EXECUTABLE)
+
+### renderControl_bench ###########################################
+include $(CLEAR_VARS)
+
+LOCAL_IS_HOST_MODULE := true
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE := renderControl_bench
+LOCAL_SRC_FILES := \
+        BenchStream.cpp
+
+intermediates := $(local-intermediates-dir)
+
+LOCAL_C_INCLUDES += \
+    $(emulatorOpengl)/shared/OpenglCodecCommon \
+    $(emulatorOpengl)/host/include/libOpenglRender \
+    $(emulatorOpengl)/system/renderControl_enc \
+    $(intermediates)
+
+LOCAL_STATIC_LIBRARIES := \
+        libOpenglCodecCommon \
+        libcutils \
+        liblog
+
+GEN := \
+	$(intermediates)/renderControl_bench.cpp \
+	$(intermediates)/renderControl_enc.cpp \
+	$(intermediates)/renderControl_client_context.cpp \
+	$(intermediates)/renderControl_dec.cpp \
+	$(intermediates)/renderControl_server_context.cpp
+
+$(GEN) : PRIVATE_PATH := $(LOCAL_PATH)
+$(GEN) : PRIVATE_CUSTOM_TOOL := \
+        $(EMUGEN) -E $(intermediates) -D $(intermediates) -B $(intermediates) \
+        -i $(emulatorOpengl)/system/renderControl_enc renderControl
+$(GEN) : $(EMUGEN) \
+        $(emulatorOpengl)/system/renderControl_enc/renderControl.attrib \
+        $(emulatorOpengl)/system/renderControl_enc/renderControl.in \
+        $(emulatorOpengl)/system/renderControl_enc/renderControl.types
+	$(transform-generated-source)
+
+LOCAL_GENERATED_SOURCES += $(GEN)
+include $(BUILD_HOST_EXECUTABLE)
+
+### glutils_bench ###########################################
+# The vertex and index kernels of glUtils.cpp, scalar against SIMD.
+# Run glutils_bench [-n runs].
+include $(CLEAR_VARS)
+
+LOCAL_IS_HOST_MODULE := true
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE := glutils_bench
+LOCAL_SRC_FILES := \
+        glUtilsBench.cpp
+
+LOCAL_C_INCLUDES += \
+    $(emulatorOpengl)/shared/OpenglCodecCommon \
+    $(emulatorOpengl)/host/include/libOpenglRender
+
+LOCAL_STATIC_LIBRARIES := \
+        libOpenglCodecCommon \
+        libcutils \
+        liblog
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,96 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "BenchStream.h"
+#include <string.h>
+
+BenchStream::BenchStream(size_t bufsize) :
+    IOStream(bufsize),
+    m_buf(NULL),
+    m_bufsize(0),
+    m_data(NULL),
+    m_size(0),
+    m_capacity(0)
+{
+}
+
+BenchStream::~BenchStream()
+{
+    flush();
+    free(m_buf);
+    free(m_data);
+}
+
+void *BenchStream::allocBuffer(size_t minSize)
+{
+    if (minSize > m_bufsize) {
+        unsigned char *p = (unsigned char *)realloc(m_buf, minSize);
+        if (!p) {
+            ERR("BenchStream::allocBuffer failed\n");
+            return NULL;
+        }
+        m_buf = p;
+        m_bufsize = minSize;
+    }
+    return m_buf;
+}
+
+int BenchStream::commitBuffer(size_t size)
+{
+    return append(m_buf, size);
+}
+
+int BenchStream::commitBufferv(const Segment *segments, int count)
+{
+    int res = 0;
+    for (int i = 0; i < count && res >= 0; i++) {
+        res = append(segments[i].base, segments[i].len);
+    }
+    return res;
+}
+
+const unsigned char *BenchStream::readFully(void *buf, size_t len)
+{
+    if (!buf) {
+        return NULL;
+    }
+    memset(buf, 0, len);
+    return (const unsigned char *)buf;
+}
+
+const unsigned char *BenchStream::read(void *buf, size_t *inout_len)
+{
+    return readFully(buf, *inout_len);
+}
+
+int BenchStream::append(const void *data, size_t len)
+{
+    if (m_size + len > m_capacity) {
+        size_t capacity = m_capacity ? m_capacity : 4096;
+        while (capacity < m_size + len) {
+            capacity *= 2;
+        }
+        unsigned char *p = (unsigned char *)realloc(m_data, capacity);
+        if (!p) {
+            ERR("BenchStream: out of memory\n");
+            return -1;
+        }
+        m_data = p;
+        m_capacity = capacity;
+    }
+    memcpy(m_data + m_size, data, len);
+    m_size += len;
+    return len;
+}
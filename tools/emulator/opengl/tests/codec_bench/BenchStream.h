@@ -0,0 +1,52 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __BENCH_STREAM_H
+#define __BENCH_STREAM_H
+
+#include <stdlib.h>
+#include "IOStream.h"
+
+//
+// BenchStream - IOStream that keeps the committed data in memory, for the
+// emugen generated benchmarks. Reads return zeroes.
+//
+class BenchStream : public IOStream {
+public:
+    explicit BenchStream(size_t bufsize);
+    ~BenchStream();
+
+    virtual void *allocBuffer(size_t minSize);
+    virtual int commitBuffer(size_t size);
+    virtual int commitBufferv(const Segment *segments, int count);
+    virtual const unsigned char *readFully( void *buf, size_t len);
+    virtual const unsigned char *read( void *buf, size_t *inout_len);
+
+    unsigned char *data() { return m_data; }
+    size_t size() const { return m_size; }
+    // drops the committed data
+    void reset() { m_size = 0; }
+
+private:
+    int append(const void *data, size_t len);
+
+    unsigned char *m_buf;
+    size_t m_bufsize;
+    unsigned char *m_data;
+    size_t m_size;
+    size_t m_capacity;
+};
+
+#endif
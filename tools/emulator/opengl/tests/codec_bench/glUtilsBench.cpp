@@ -0,0 +1,132 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "glUtils.h"
+#include "TimeUtils.h"
+
+//
+// glutils_bench - the vertex and index kernels of glUtils.cpp, scalar
+// against SIMD. Each case runs both and checks that they agree.
+//
+#define BENCH_DEFAULT_RUNS 200
+#define BENCH_VERTICES 4096
+#define BENCH_STRIDE 32     // interleaved arrays, up to 16 bytes of padding
+
+static unsigned char s_src[BENCH_VERTICES * BENCH_STRIDE];
+static unsigned char s_dst[2][BENCH_VERTICES * 16];
+static int s_vertices[BENCH_VERTICES];
+
+struct BenchCase {
+    const char *name;
+    GLenum type;        // index type, or 0 for the vertex copies
+    int vsize;
+    bool gather;
+};
+
+static const BenchCase s_cases[] = {
+    { "PackPointerData 4", 0, 4, false },
+    { "PackPointerData 8", 0, 8, false },
+    { "PackPointerData 12", 0, 12, false },
+    { "PackPointerData 16", 0, 16, false },
+    { "GatherVertices 4", 0, 4, true },
+    { "GatherVertices 8", 0, 8, true },
+    { "GatherVertices 12", 0, 12, true },
+    { "GatherVertices 16", 0, 16, true },
+    { "IndexRange u8", GL_UNSIGNED_BYTE, 1, false },
+    { "IndexRange u16", GL_UNSIGNED_SHORT, 2, false },
+    { "IndexRange u32", GL_UNSIGNED_INT, 4, false },
+    { "ShiftIndices u8", GL_UNSIGNED_BYTE, 1, true },
+    { "ShiftIndices u16", GL_UNSIGNED_SHORT, 2, true },
+    { "ShiftIndices u32", GL_UNSIGNED_INT, 4, true },
+};
+
+// runs a case once into dst, returns its result for the index ranges
+static long long runCase(const BenchCase *c, unsigned char *dst)
+{
+    if (c->type == 0 && !c->gather) {
+        glUtilsPackPointerData(dst, s_src, c->vsize / 4, GL_FLOAT, BENCH_STRIDE,
+                               BENCH_VERTICES * c->vsize);
+    } else if (c->type == 0) {
+        glUtilsGatherVertices(dst, s_src, c->vsize, BENCH_STRIDE, s_vertices, BENCH_VERTICES);
+    } else if (!c->gather) {
+        int min, max;
+        glUtilsIndexRange(s_src, c->type, BENCH_VERTICES, &min, &max);
+        return ((long long)min << 32) | (unsigned int)max;
+    } else {
+        glUtilsShiftIndices(s_src, dst, c->type, BENCH_VERTICES, -3);
+    }
+    return 0;
+}
+
+// ns per vertex or index of runs runs of a case
+static double timeCase(const BenchCase *c, unsigned char *dst, int runs, long long *result)
+{
+    long long start = GetCurrentTimeNS();
+    for (int i = 0; i < runs; i++) {
+        *result = runCase(c, dst);
+    }
+    return (double)(GetCurrentTimeNS() - start) / ((double)runs * BENCH_VERTICES);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = BENCH_DEFAULT_RUNS;
+    if (argc == 3 && !strcmp(argv[1], "-n")) {
+        runs = atoi(argv[2]);
+    }
+    if (argc != 1 && (argc != 3 || runs <= 0)) {
+        fprintf(stderr, "Usage: %s [-n runs]\n", argv[0]);
+        fprintf(stderr, "\t-n: runs per case, %d by default\n", BENCH_DEFAULT_RUNS);
+        return 1;
+    }
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(s_src); i++) {
+        s_src[i] = rand();
+    }
+    for (int i = 0; i < BENCH_VERTICES; i++) {
+        s_vertices[i] = rand() % BENCH_VERTICES;
+    }
+
+    if (!glUtilsSetSimd(1)) {
+        printf("no SIMD kernels on this cpu, timing the scalar ones twice\n");
+    }
+    int failed = 0;
+    printf("%-24s %12s %12s %8s\n", "glUtils", "scalar ns", "simd ns", "speedup");
+    for (size_t n = 0; n < sizeof(s_cases) / sizeof(s_cases[0]); n++) {
+        const BenchCase *c = &s_cases[n];
+        size_t len = BENCH_VERTICES * c->vsize;
+        memset(s_dst, 0, sizeof(s_dst));
+        long long scalarResult, simdResult;
+
+        glUtilsSetSimd(0);
+        double scalar = timeCase(c, s_dst[0], runs, &scalarResult);
+        glUtilsSetSimd(1);
+        double simd = timeCase(c, s_dst[1], runs, &simdResult);
+
+        if (scalarResult != simdResult || memcmp(s_dst[0], s_dst[1], len)) {
+            printf("%-24s FAILED, the kernels disagree\n", c->name);
+            failed++;
+            continue;
+        }
+        printf("%-24s %12.3f %12.3f %7.2fx\n", c->name, scalar, simd,
+               simd > 0 ? scalar / simd : 0.0);
+    }
+    printf("%d cases failed\n", failed);
+    return failed ? 1 : 0;
+}